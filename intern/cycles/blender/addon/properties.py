@@ -397,6 +397,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Sample lights by their estimated contribution to the shading point, rather than by their area and power. "
+        "Reduces noise in scenes with many lights, at the cost of slower light sampling",
+        default=False,
+    )
 
     use_adaptive_sampling: BoolProperty(
         name="Use Adaptive Sampling",
@@ -800,6 +806,14 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Memory budget in megabytes for image textures read from disk on demand by final CPU renders, "
+        "0 loads all images in memory",
+        default=0,
+        min=0,
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
@@ -42,7 +42,10 @@ int BVHStackEntry::encodeIdx() const
 BVH2::BVH2(const BVHParams &params_,
            const vector<Geometry *> &geometry_,
            const vector<Object *> &objects_)
-    : BVH(params_, geometry_, objects_)
+    : BVH(params_, geometry_, objects_),
+      top_level_nodes_size(0),
+      top_level_leaf_nodes_size(0),
+      top_level_prims_size(0)
 {
 }
 
@@ -110,6 +113,39 @@ void BVH2::refit(Progress &progress)
   refit_nodes();
 }
 
+void BVH2::refit_top_level(int4 *nodes,
+                           int4 *leaf_nodes,
+                           const int *prim_index,
+                           const int *prim_object,
+                           const int *prim_type)
+{
+  assert(params.top_level);
+
+  /* Copy the top level part to refit it with the same code as object BVHs. It only has a few
+   * nodes per object when all geometry is instanced, which is when objects can be transformed
+   * without modifying the geometry. */
+  pack.nodes.resize(top_level_nodes_size);
+  pack.leaf_nodes.resize(top_level_leaf_nodes_size);
+  pack.prim_index.resize(top_level_prims_size);
+  pack.prim_object.resize(top_level_prims_size);
+  pack.prim_type.resize(top_level_prims_size);
+
+  memcpy(pack.nodes.data(), nodes, sizeof(int4) * top_level_nodes_size);
+  memcpy(pack.leaf_nodes.data(), leaf_nodes, sizeof(int4) * top_level_leaf_nodes_size);
+  memcpy(pack.prim_index.data(), prim_index, sizeof(int) * top_level_prims_size);
+  memcpy(pack.prim_object.data(), prim_object, sizeof(int) * top_level_prims_size);
+  memcpy(pack.prim_type.data(), prim_type, sizeof(int) * top_level_prims_size);
+
+  refit_nodes();
+
+  memcpy(nodes, pack.nodes.data(), sizeof(int4) * top_level_nodes_size);
+  memcpy(leaf_nodes, pack.leaf_nodes.data(), sizeof(int4) * top_level_leaf_nodes_size);
+
+  const int root_index = pack.root_index;
+  pack = PackedBVH();
+  pack.root_index = root_index;
+}
+
 BVHNode *BVH2::widen_children_nodes(const BVHNode *root)
 {
   return const_cast<BVHNode *>(root);
@@ -260,6 +296,9 @@ void BVH2::pack_nodes(const BVHNode *root)
   pack.leaf_nodes.clear();
   /* For top level BVH, first merge existing BVH's so we know the offsets. */
   if (params.top_level) {
+    top_level_nodes_size = node_size;
+    top_level_leaf_nodes_size = num_leaf_nodes * BVH_NODE_LEAF_SIZE;
+    top_level_prims_size = pack.prim_index.size();
     pack_instances(node_size, num_leaf_nodes * BVH_NODE_LEAF_SIZE);
   }
   else {
@@ -315,8 +354,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -331,7 +368,13 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    refit_primitives(c0, c1, bbox, visibility);
+    if (c0 < 0) {
+      /* Object instance in the top level, see pack_leaf(). */
+      refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+    }
+    else {
+      refit_primitives(c0, c1, bbox, visibility);
+    }
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
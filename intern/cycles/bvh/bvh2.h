@@ -48,6 +48,14 @@ class BVH2 : public BVH {
   void build(Progress &progress, Stats *stats);
   void refit(Progress &progress);
 
+  /* Refit the top level nodes after objects were transformed, in packed arrays that were moved
+   * out of the BVH. The nodes of instanced BVHs merged after them are not modified. */
+  void refit_top_level(int4 *nodes,
+                       int4 *leaf_nodes,
+                       const int *prim_index,
+                       const int *prim_object,
+                       const int *prim_type);
+
   PackedBVH pack;
 
  protected:
@@ -103,6 +111,11 @@ class BVH2 : public BVH {
 
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
+
+  /* Size of the top level part of the packed arrays, before the merged instance BVH's. */
+  size_t top_level_nodes_size;
+  size_t top_level_leaf_nodes_size;
+  size_t top_level_prims_size;
 };
 
 CCL_NAMESPACE_END
@@ -624,6 +624,9 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo> &subdevices,
   info.has_osl = true;
   info.has_profiling = true;
   info.has_peer_memory = false;
+  /* Pointer maps of the multi device are not protected. */
+  info.has_thread_safe_memory = false;
+  info.has_texture_cache = true;
   info.denoisers = DENOISER_ALL;
 
   foreach (const DeviceInfo &device, subdevices) {
@@ -668,6 +671,7 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo> &subdevices,
     info.has_adaptive_stop_per_sample &= device.has_adaptive_stop_per_sample;
     info.has_osl &= device.has_osl;
     info.has_profiling &= device.has_profiling;
+    info.has_texture_cache &= device.has_texture_cache;
     info.has_peer_memory |= device.has_peer_memory;
     info.denoisers &= device.denoisers;
   }
@@ -84,6 +84,8 @@ class DeviceInfo {
   bool use_split_kernel;             /* Use split or mega kernel. */
   bool has_profiling;                /* Supports runtime collection of profiling info. */
   bool has_peer_memory;              /* GPU has P2P access to memory of another GPU. */
+  bool has_thread_safe_memory;       /* Memory can be updated from multiple threads at once. */
+  bool has_texture_cache;            /* Supports image textures read from files on demand. */
   DenoiserTypeMask denoisers;        /* Supported denoiser types. */
   int cpu_threads;
   vector<DeviceInfo> multi_devices;
@@ -104,6 +106,8 @@ class DeviceInfo {
     use_split_kernel = false;
     has_profiling = false;
     has_peer_memory = false;
+    has_thread_safe_memory = false;
+    has_texture_cache = false;
     denoisers = DENOISER_NONE;
   }
 
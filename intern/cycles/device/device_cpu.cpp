@@ -178,8 +178,12 @@ class CPUDevice : public Device {
   TaskPool task_pool;
   KernelGlobals kernel_globals;
 
+  /* Texture info used by the kernel. Textures may be loaded by other threads while a task is
+   * running, so they are written to the pending info which is copied when adding a task. */
   device_vector<TextureInfo> texture_info;
+  vector<TextureInfo> pending_texture_info;
   bool need_texture_info;
+  thread_mutex texture_info_mutex;
 
 #ifdef WITH_OSL
   OSLGlobals osl_globals;
@@ -375,7 +379,10 @@ class CPUDevice : public Device {
 
   void load_texture_info()
   {
+    thread_scoped_lock lock(texture_info_mutex);
     if (need_texture_info) {
+      TextureInfo *data = texture_info.resize(pending_texture_info.size());
+      memcpy(data, pending_texture_info.data(), sizeof(TextureInfo) * pending_texture_info.size());
       texture_info.copy_to_device();
       need_texture_info = false;
     }
@@ -519,14 +526,15 @@ class CPUDevice : public Device {
     mem.device_size = mem.memory_size();
     stats.mem_alloc(mem.device_size);
 
+    thread_scoped_lock lock(texture_info_mutex);
     const uint slot = mem.slot;
-    if (slot >= texture_info.size()) {
+    if (slot >= pending_texture_info.size()) {
       /* Allocate some slots in advance, to reduce amount of re-allocations. */
-      texture_info.resize(slot + 128);
+      pending_texture_info.resize(slot + 128);
     }
 
-    texture_info[slot] = mem.info;
-    texture_info[slot].data = (uint64_t)mem.host_pointer;
+    pending_texture_info[slot] = mem.info;
+    pending_texture_info[slot].data = (uint64_t)mem.host_pointer;
     need_texture_info = true;
   }
 
@@ -536,6 +544,8 @@ class CPUDevice : public Device {
       mem.device_pointer = 0;
       stats.mem_free(mem.device_size);
       mem.device_size = 0;
+
+      thread_scoped_lock lock(texture_info_mutex);
       need_texture_info = true;
     }
   }
@@ -1657,6 +1667,8 @@ void device_cpu_info(vector<DeviceInfo> &devices)
   info.has_osl = true;
   info.has_half_images = true;
   info.has_profiling = true;
+  info.has_thread_safe_memory = true;
+  info.has_texture_cache = true;
   info.denoisers = DENOISER_NLM;
   if (openimagedenoise_supported()) {
     info.denoisers |= DENOISER_OPENIMAGEDENOISE;
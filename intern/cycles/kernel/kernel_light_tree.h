@@ -0,0 +1,300 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Picks an entry of the light distribution proportional to an estimate of its contribution to
+ * the shading point, instead of proportional to its area. The tree is traversed from the root,
+ * choosing a child with a probability proportional to its importance, until a leaf is reached
+ * where one of the emitters is chosen the same way.
+ *
+ * The pdf of the light samples is computed for the flat distribution as before, it is rescaled
+ * by the ratio of the probabilities of picking the entry with the tree and the distribution.
+ * The importance only depends on the shading point and not on its normal, so the same factor
+ * can be computed for multiple importance sampling when a light is hit. */
+
+/* Estimate of the energy arriving at P from the given bounds, following
+ * "Importance Sampling of Many Lights with Adaptive Tree Splitting" by Conty and Kulla. */
+ccl_device float light_tree_importance(const float3 P,
+                                       const float3 bbox_min,
+                                       const float3 bbox_max,
+                                       const float3 axis,
+                                       const float theta_o,
+                                       const float theta_e,
+                                       const float energy)
+{
+  if (energy == 0.0f) {
+    return 0.0f;
+  }
+
+  const float3 centroid = 0.5f * (bbox_min + bbox_max);
+  const float3 extent = bbox_max - bbox_min;
+  float distance;
+  const float3 D = normalize_len(P - centroid, &distance);
+
+  /* Clamp the distance to the size of the bounds, to avoid the singularity for points inside or
+   * close to them. */
+  const float distance_squared = max(distance * distance,
+                                     max(0.25f * len_squared(extent), 1e-12f));
+
+  /* Half angle of the cone around D containing the bounds. */
+  const float radius = 0.5f * len(extent);
+  const float theta_u = (distance > radius) ? fast_asinf(radius / distance) : M_PI_F;
+
+  /* Smallest angle between the emission directions and the direction to P. */
+  const float theta = fast_acosf(clamp(dot(axis, D), -1.0f, 1.0f));
+  const float theta_prime = max(theta - theta_o - theta_u, 0.0f);
+  if (theta_prime >= theta_e) {
+    return 0.0f;
+  }
+
+  return energy * fast_cosf(theta_prime) / distance_squared;
+}
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, const float3 P, const int index)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+  const ccl_global float *bbox_min = knode->bounding_box_min;
+  const ccl_global float *bbox_max = knode->bounding_box_max;
+  return light_tree_importance(P,
+                               make_float3(bbox_min[0], bbox_min[1], bbox_min[2]),
+                               make_float3(bbox_max[0], bbox_max[1], bbox_max[2]),
+                               make_float3(knode->axis[0], knode->axis[1], knode->axis[2]),
+                               knode->theta_o,
+                               knode->theta_e,
+                               knode->energy);
+}
+
+ccl_device float light_tree_emitter_importance(KernelGlobals *kg, const float3 P, const int index)
+{
+  const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                        index);
+  const ccl_global float *bbox_min = kemitter->bounding_box_min;
+  const ccl_global float *bbox_max = kemitter->bounding_box_max;
+  return light_tree_importance(P,
+                               make_float3(bbox_min[0], bbox_min[1], bbox_min[2]),
+                               make_float3(bbox_max[0], bbox_max[1], bbox_max[2]),
+                               make_float3(
+                                   kemitter->axis[0], kemitter->axis[1], kemitter->axis[2]),
+                               kemitter->theta_o,
+                               kemitter->theta_e,
+                               kemitter->energy);
+}
+
+/* Probability of picking the first child of an interior node. */
+ccl_device float light_tree_first_child_probability(KernelGlobals *kg,
+                                                    const float3 P,
+                                                    const int index,
+                                                    const int child_index)
+{
+  const float importance_first = light_tree_node_importance(kg, P, index + 1);
+  const float importance_second = light_tree_node_importance(kg, P, child_index);
+  const float importance_sum = importance_first + importance_second;
+  return (importance_sum > 0.0f) ? importance_first / importance_sum : -1.0f;
+}
+
+/* Ratio of the probabilities of picking the emitter with the tree and with the flat
+ * distribution. */
+ccl_device float light_tree_pdf_factor(KernelGlobals *kg,
+                                       const float probability,
+                                       const int emitter)
+{
+  const float distribution_probability =
+      kernel_tex_fetch(__light_tree_emitters, emitter).distribution_probability;
+  return (distribution_probability > 0.0f) ? probability / distribution_probability : 0.0f;
+}
+
+/* Pick an entry of the light distribution, rescaling randu for reuse. Returns -1 when no light
+ * can contribute to P. */
+ccl_device int light_tree_sample(KernelGlobals *kg,
+                                 const float3 P,
+                                 float *randu,
+                                 float *pdf_factor)
+{
+  const float local_probability = kernel_data.integrator.light_tree_local_probability;
+  float r = *randu;
+
+  if (r >= local_probability) {
+    /* Infinite lights are not in the tree and are picked uniformly, with the same probability
+     * as in the flat distribution. */
+    const int num_infinite = kernel_data.integrator.light_tree_num_infinite_emitters;
+    if (num_infinite == 0) {
+      return -1;
+    }
+    r = (r - local_probability) / (1.0f - local_probability) * num_infinite;
+    const int infinite_index = min((int)r, num_infinite - 1);
+    const int emitter = kernel_data.integrator.light_tree_num_local_emitters + infinite_index;
+    *randu = r - infinite_index;
+    *pdf_factor = light_tree_pdf_factor(kg, (1.0f - local_probability) / num_infinite, emitter);
+    return kernel_tex_fetch(__light_tree_emitters, emitter).distribution_index;
+  }
+
+  r /= local_probability;
+  float probability = local_probability;
+
+  /* Traverse to a leaf. */
+  int index = 0;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+  while (knode->child_index != -1) {
+    const float first_probability = light_tree_first_child_probability(
+        kg, P, index, knode->child_index);
+    if (first_probability < 0.0f) {
+      return -1;
+    }
+
+    if (r < first_probability) {
+      r /= first_probability;
+      probability *= first_probability;
+      index = index + 1;
+    }
+    else {
+      r = (r - first_probability) / (1.0f - first_probability);
+      probability *= 1.0f - first_probability;
+      index = knode->child_index;
+    }
+    knode = &kernel_tex_fetch(__light_tree_nodes, index);
+  }
+
+  /* Pick an emitter of the leaf. */
+  float importance_sum = 0.0f;
+  for (int i = 0; i < knode->num_emitters; i++) {
+    importance_sum += light_tree_emitter_importance(kg, P, knode->first_emitter + i);
+  }
+  if (importance_sum == 0.0f) {
+    return -1;
+  }
+
+  int emitter = -1;
+  float emitter_probability = 0.0f;
+  float cdf = 0.0f;
+  for (int i = 0; i < knode->num_emitters; i++) {
+    const float probability_i = light_tree_emitter_importance(kg, P, knode->first_emitter + i) /
+                                importance_sum;
+    if (probability_i == 0.0f) {
+      continue;
+    }
+    if (emitter != -1) {
+      cdf += emitter_probability;
+    }
+    emitter = knode->first_emitter + i;
+    emitter_probability = probability_i;
+    if (r < cdf + emitter_probability) {
+      break;
+    }
+  }
+  *randu = clamp((r - cdf) / emitter_probability, 0.0f, 1.0f - FLT_EPSILON);
+
+  *pdf_factor = light_tree_pdf_factor(kg, probability * emitter_probability, emitter);
+  return kernel_tex_fetch(__light_tree_emitters, emitter).distribution_index;
+}
+
+/* Factor to apply to the pdf of the flat distribution for the given entry, when it is hit
+ * from P. Matches the factor computed by light_tree_sample. */
+ccl_device float light_tree_distribution_pdf_factor(KernelGlobals *kg,
+                                                    const float3 P,
+                                                    const int distribution_index)
+{
+  const int emitter = kernel_tex_fetch(__light_tree_distribution_to_emitter, distribution_index);
+  const float local_probability = kernel_data.integrator.light_tree_local_probability;
+
+  const int leaf_index = kernel_tex_fetch(__light_tree_emitters, emitter).leaf_index;
+  if (leaf_index == -1) {
+    const int num_infinite = kernel_data.integrator.light_tree_num_infinite_emitters;
+    return light_tree_pdf_factor(kg, (1.0f - local_probability) / num_infinite, emitter);
+  }
+
+  /* Probability of the emitter in its leaf. */
+  const ccl_global KernelLightTreeNode *kleaf = &kernel_tex_fetch(__light_tree_nodes, leaf_index);
+  float importance_sum = 0.0f;
+  for (int i = 0; i < kleaf->num_emitters; i++) {
+    importance_sum += light_tree_emitter_importance(kg, P, kleaf->first_emitter + i);
+  }
+  if (importance_sum == 0.0f) {
+    return 0.0f;
+  }
+  float probability = local_probability * light_tree_emitter_importance(kg, P, emitter) /
+                      importance_sum;
+
+  /* Probabilities of the nodes on the path to the root. */
+  int index = leaf_index;
+  while (index != 0 && probability > 0.0f) {
+    const int parent_index = kernel_tex_fetch(__light_tree_nodes, index).parent_index;
+    const int child_index = kernel_tex_fetch(__light_tree_nodes, parent_index).child_index;
+    const float first_probability = light_tree_first_child_probability(
+        kg, P, parent_index, child_index);
+    if (first_probability < 0.0f) {
+      return 0.0f;
+    }
+    probability *= (index == parent_index + 1) ? first_probability : 1.0f - first_probability;
+    index = parent_index;
+  }
+
+  return light_tree_pdf_factor(kg, probability, emitter);
+}
+
+/* Find the entry of an emissive triangle in the light distribution. Triangles are stored first,
+ * sorted by object and primitive. */
+ccl_device int light_tree_triangle_distribution_index(KernelGlobals *kg, int object, int prim)
+{
+  int first = 0;
+  int len = kernel_data.integrator.num_distribution - kernel_data.integrator.num_all_lights;
+
+  while (len > 0) {
+    const int half_len = len >> 1;
+    const int middle = first + half_len;
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, middle);
+    const int middle_object = kdistribution->mesh_light.object_id;
+
+    if (middle_object < object || (middle_object == object && kdistribution->prim < prim)) {
+      first = middle + 1;
+      len = len - half_len - 1;
+    }
+    else {
+      len = half_len;
+    }
+  }
+
+  return first;
+}
+
+ccl_device float light_tree_triangle_pdf_factor(KernelGlobals *kg,
+                                                const float3 P,
+                                                int object,
+                                                int prim)
+{
+  const int index = light_tree_triangle_distribution_index(kg, object, prim);
+  const int num_triangles = kernel_data.integrator.num_distribution -
+                            kernel_data.integrator.num_all_lights;
+  if (index == num_triangles ||
+      kernel_tex_fetch(__light_distribution, index).mesh_light.object_id != object ||
+      kernel_tex_fetch(__light_distribution, index).prim != prim) {
+    /* Not in the distribution, so it is never sampled as a light either way. */
+    return 1.0f;
+  }
+  return light_tree_distribution_pdf_factor(kg, P, index);
+}
+
+ccl_device float light_tree_lamp_pdf_factor(KernelGlobals *kg, const float3 P, int lamp)
+{
+  const int index = kernel_data.integrator.num_distribution -
+                    kernel_data.integrator.num_all_lights + lamp;
+  return light_tree_distribution_pdf_factor(kg, P, index);
+}
+
+CCL_NAMESPACE_END
@@ -1387,6 +1387,12 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
+  /* light tree */
+  int use_light_tree;
+  int light_tree_num_local_emitters;
+  int light_tree_num_infinite_emitters;
+  float light_tree_local_probability;
+
   int pad1, pad2;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
@@ -1548,6 +1554,46 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Light tree, see render/light_tree.h. Both nodes and emitters store the bounds of the emitted
+ * energy: a bounding box and a cone of emission directions around the axis. theta_o is the half
+ * angle of the cone containing the normals, theta_e the angle the emission extends beyond it. */
+
+typedef struct KernelLightTreeNode {
+  float bounding_box_min[3];
+  float energy;
+  float bounding_box_max[3];
+  float theta_o;
+  float axis[3];
+  float theta_e;
+
+  /* Interior nodes: the first child directly follows the node, the second child is at
+   * child_index. Leaf nodes: child_index is -1 and the emitters are stored contiguously. */
+  int child_index;
+  int first_emitter;
+  int num_emitters;
+  int parent_index;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
+typedef struct KernelLightTreeEmitter {
+  float bounding_box_min[3];
+  float energy;
+  float bounding_box_max[3];
+  float theta_o;
+  float axis[3];
+  float theta_e;
+
+  /* Entry in the light distribution, which holds the primitive or lamp. */
+  int distribution_index;
+  /* Leaf node containing the emitter, -1 for infinite lights which are not in the tree. */
+  int leaf_index;
+  /* Probability of the emitter in the flat light distribution, which is already included in
+   * the pdf of the light sample. */
+  float distribution_probability;
+  int pad1;
+} KernelLightTreeEmitter;
+static_assert_align(KernelLightTreeEmitter, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
@@ -286,6 +286,7 @@ GeometryManager::GeometryManager()
 {
   need_update = true;
   need_flags_update = true;
+  need_scene_bvh_rebuild = true;
 }
 
 GeometryManager::~GeometryManager()
@@ -1141,14 +1142,64 @@ void GeometryManager::device_update_mesh(
   }
 }
 
-void GeometryManager::device_update_bvh(Device *device,
-                                        DeviceScene *dscene,
-                                        Scene *scene,
-                                        Progress &progress)
+bool GeometryManager::can_refit_scene_bvh(Device *device, Scene *scene) const
 {
+  if (scene->bvh == NULL || need_scene_bvh_rebuild) {
+    return false;
+  }
+
+  /* Refitting only updates the bounds or transforms of objects, all primitives must be the same
+   * as when the BVH was built. */
+  if (scene->bvh->objects != scene->objects || scene->bvh->geometry != scene->geometry) {
+    return false;
+  }
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->is_modified()) {
+      return false;
+    }
+  }
+
+  /* OptiX has its own acceleration structure for the top level, which is always rebuilt. */
+  const BVHLayout bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
+                                                          device->get_bvh_layout_mask());
+  return scene->bvh->params.bvh_layout == bvh_layout &&
+         (bvh_layout == BVH_LAYOUT_BVH2 || bvh_layout == BVH_LAYOUT_EMBREE);
+}
+
+void GeometryManager::device_update_bvh(
+    Device *device, DeviceScene *dscene, Scene *scene, bool refit, Progress &progress)
+{
+  if (refit) {
+    /* Only object transforms changed, the primitive arrays of the previous build are still on
+     * the device and only the top level nodes are updated. The quality of the BVH degrades as
+     * objects move further from where they were when it was built, a rebuild is done as soon
+     * as anything else changes. */
+    progress.set_status("Updating Scene BVH", "Refitting");
+
+    BVH *bvh = scene->bvh;
+    if (bvh->params.bvh_layout == BVH_LAYOUT_BVH2) {
+      static_cast<BVH2 *>(bvh)->refit_top_level(dscene->bvh_nodes.data(),
+                                                dscene->bvh_leaf_nodes.data(),
+                                                dscene->prim_index.data(),
+                                                dscene->prim_object.data(),
+                                                dscene->prim_type.data());
+      dscene->bvh_nodes.copy_to_device();
+      dscene->bvh_leaf_nodes.copy_to_device();
+    }
+    else {
+      device->build_bvh(bvh, progress, true);
+    }
+
+    dscene->data.bvh.bvh_layout = bvh->params.bvh_layout;
+    return;
+  }
+
   /* bvh build */
   progress.set_status("Updating Scene BVH", "Building");
 
+  /* Arrays may have been kept for refitting. */
+  device_free_bvh(dscene);
+
   BVHParams bparams;
   bparams.top_level = true;
   bparams.bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
@@ -1524,7 +1575,8 @@ void GeometryManager::device_update(Device *device,
   }
 
   /* Device update. */
-  device_free(device, dscene);
+  bool refit_scene_bvh = can_refit_scene_bvh(device, scene);
+  device_free(device, dscene, !refit_scene_bvh);
 
   mesh_calc_offset(scene);
   if (true_displacement_used) {
@@ -1645,7 +1697,13 @@ void GeometryManager::device_update(Device *device,
     });
     vector<Object *> volume_objects;
     foreach (Object *object, scene->objects) {
+      const bool was_traceable = object->is_traceable();
       object->compute_bounds(motion_blur);
+
+      /* Objects are added to or removed from the scene BVH. */
+      if (object->is_traceable() != was_traceable) {
+        refit_scene_bvh = false;
+      }
     }
   }
 
@@ -1659,7 +1717,7 @@ void GeometryManager::device_update(Device *device,
         scene->update_stats->geometry.times.add_entry({"device_update (build scene BVH)", time});
       }
     });
-    device_update_bvh(device, dscene, scene, progress);
+    device_update_bvh(device, dscene, scene, refit_scene_bvh, progress);
     if (progress.get_cancel()) {
       return;
     }
@@ -1679,6 +1737,7 @@ void GeometryManager::device_update(Device *device,
   }
 
   need_update = false;
+  need_scene_bvh_rebuild = false;
 
   if (true_displacement_used) {
     /* Re-tag flags for update, so they're re-evaluated
@@ -1691,7 +1750,7 @@ void GeometryManager::device_update(Device *device,
   }
 }
 
-void GeometryManager::device_free(Device *device, DeviceScene *dscene)
+void GeometryManager::device_free_bvh(DeviceScene *dscene)
 {
   dscene->bvh_nodes.free();
   dscene->bvh_leaf_nodes.free();
@@ -1703,6 +1762,13 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
   dscene->prim_index.free();
   dscene->prim_object.free();
   dscene->prim_time.free();
+}
+
+void GeometryManager::device_free(Device *device, DeviceScene *dscene, bool free_bvh)
+{
+  if (free_bvh) {
+    device_free_bvh(dscene);
+  }
   dscene->tri_shader.free();
   dscene->tri_vnormal.free();
   dscene->tri_vindex.free();
@@ -1736,6 +1802,7 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
 void GeometryManager::tag_update(Scene *scene)
 {
   need_update = true;
+  need_scene_bvh_rebuild = true;
   scene->object_manager->need_update = true;
 }
 
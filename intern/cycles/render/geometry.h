@@ -166,6 +166,8 @@ class GeometryManager {
   /* Update Flags */
   bool need_update;
   bool need_flags_update;
+  /* Set for any change other than object transforms, for which the scene BVH is refit. */
+  bool need_scene_bvh_rebuild;
 
   /* Constructor/Destructor */
   GeometryManager();
@@ -174,7 +176,7 @@ class GeometryManager {
   /* Device Updates */
   void device_update_preprocess(Device *device, Scene *scene, Progress &progress);
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
-  void device_free(Device *device, DeviceScene *dscene);
+  void device_free(Device *device, DeviceScene *dscene, bool free_bvh = true);
 
   /* Updates */
   void tag_update(Scene *scene);
@@ -213,7 +215,12 @@ class GeometryManager {
                                 Scene *scene,
                                 Progress &progress);
 
-  void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+  bool can_refit_scene_bvh(Device *device, Scene *scene) const;
+
+  void device_update_bvh(
+      Device *device, DeviceScene *dscene, Scene *scene, bool refit, Progress &progress);
+
+  void device_free_bvh(DeviceScene *dscene);
 
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
@@ -30,6 +30,7 @@
 #include "util/util_progress.h"
 #include "util/util_task.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 #include "util/util_unique_ptr.h"
 
 #ifdef WITH_OSL
@@ -301,15 +302,22 @@ ImageManager::ImageManager(const DeviceInfo &info)
   need_update = true;
   osl_texture_system = NULL;
   animation_frame = 0;
+  keep_vdb_grids = false;
 
   /* Set image limits */
   has_half_images = info.has_half_images;
+  has_texture_cache = info.has_texture_cache;
+  texture_cache_used = false;
 }
 
 ImageManager::~ImageManager()
 {
   for (size_t slot = 0; slot < images.size(); slot++)
     assert(!images[slot]);
+
+  if (texture_cache_used) {
+    TextureCache::exit();
+  }
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -490,6 +498,48 @@ static bool image_associate_alpha(ImageManager::Image *img)
            img->params.alpha_type == IMAGE_ALPHA_CHANNEL_PACKED);
 }
 
+/* Images read from files can be looked up through the texture cache instead of being loaded in
+ * memory, when the kernel would get the pixels as stored in the file. */
+bool ImageManager::use_texture_cache(Scene *scene, Image *img)
+{
+  const int texture_cache_size = scene->params.texture_cache_size;
+  if (!has_texture_cache || texture_cache_size == 0 || img->loader->osl_filepath().empty()) {
+    return false;
+  }
+
+  const ImageMetaData &metadata = img->metadata;
+  if (metadata.channels == 0 || metadata.channels > 4 || metadata.depth > 1 ||
+      metadata.type == IMAGE_DATA_TYPE_NANOVDB_FLOAT ||
+      metadata.type == IMAGE_DATA_TYPE_NANOVDB_FLOAT3) {
+    return false;
+  }
+
+  /* Images larger than the texture limit are scaled down in memory. */
+  const int texture_limit = scene->params.texture_limit;
+  if (texture_limit > 0 && max(metadata.width, metadata.height) > texture_limit) {
+    return false;
+  }
+
+  /* No conversion to scene linear, sRGB is converted by the kernel. */
+  if (metadata.colorspace != u_colorspace_raw && metadata.colorspace != u_colorspace_srgb) {
+    return false;
+  }
+
+  /* The cache always associates alpha. */
+  const bool has_alpha = (metadata.channels == 2 || metadata.channels == 4);
+  if (has_alpha && !image_associate_alpha(img)) {
+    return false;
+  }
+
+  thread_scoped_lock device_lock(device_mutex);
+  if (!texture_cache_used) {
+    TextureCache::init(texture_cache_size);
+    texture_cache_used = true;
+  }
+
+  return true;
+}
+
 template<TypeDesc::BASETYPE FileFormat, typename StorageType>
 bool ImageManager::file_load_image(Image *img, int texture_limit)
 {
@@ -654,6 +704,13 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
 
   Image *img = images[slot];
 
+  /* The geometry manager loads the images it needs for displacement and volumes itself, possibly
+   * while all images are being loaded by another thread. */
+  thread_scoped_lock load_lock(img->load_mutex);
+  if (!img->need_load) {
+    return;
+  }
+
   progress->set_status("Updating Images", "Loading " + img->loader->name());
 
   const int texture_limit = scene->params.texture_limit;
@@ -666,6 +723,10 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
 
   /* Free previous texture in slot. */
   if (img->mem) {
+    if (img->mem->info.cache_handle) {
+      TextureCache::invalidate(img->loader->osl_filepath().string());
+    }
+
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
     img->mem = NULL;
@@ -677,7 +738,15 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (use_texture_cache(scene, img)) {
+    /* The kernel reads pixels from the file, a single pixel is allocated to create the texture
+     * on the device. */
+    thread_scoped_lock device_lock(device_mutex);
+    img->mem->info.cache_handle = TextureCache::get_handle(img->loader->osl_filepath().string());
+    void *pixels = img->mem->alloc(1, 1);
+    memset(pixels, 0, img->mem->memory_size());
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -778,7 +847,15 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   }
 
   /* Cleanup memory in image loader. */
-  img->loader->cleanup();
+  {
+    thread_scoped_lock vdb_grids_lock(vdb_grids_mutex);
+    if (keep_vdb_grids && img->loader->is_vdb_loader()) {
+      kept_vdb_grid_slots.push_back(slot);
+    }
+    else {
+      img->loader->cleanup();
+    }
+  }
   img->need_load = false;
 }
 
@@ -799,6 +876,10 @@ void ImageManager::device_free_image(Device *, int slot)
   }
 
   if (img->mem) {
+    if (img->mem->info.cache_handle) {
+      TextureCache::invalidate(img->loader->osl_filepath().string());
+    }
+
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
   }
@@ -837,6 +918,24 @@ void ImageManager::device_update(Device *device, Scene *scene, Progress &progres
   need_update = false;
 }
 
+void ImageManager::begin_keep_vdb_grids()
+{
+  thread_scoped_lock vdb_grids_lock(vdb_grids_mutex);
+  keep_vdb_grids = true;
+}
+
+void ImageManager::end_keep_vdb_grids()
+{
+  thread_scoped_lock vdb_grids_lock(vdb_grids_mutex);
+  keep_vdb_grids = false;
+  foreach (int slot, kept_vdb_grid_slots) {
+    if (images[slot]) {
+      images[slot]->loader->cleanup();
+    }
+  }
+  kept_vdb_grid_slots.clear();
+}
+
 void ImageManager::device_update_slot(Device *device, Scene *scene, int slot, Progress *progress)
 {
   Image *img = images[slot];
@@ -845,7 +944,8 @@ void ImageManager::device_update_slot(Device *device, Scene *scene, int slot, Pr
   if (img->users == 0) {
     device_free_image(device, slot);
   }
-  else if (img->need_load) {
+  else {
+    /* Checks if the image needs to be loaded under the lock, it may be loading already. */
     device_load_image(device, scene, slot, progress);
   }
 }
@@ -181,6 +181,12 @@ class ImageManager {
   void device_update_slot(Device *device, Scene *scene, int slot, Progress *progress);
   void device_free(Device *device);
 
+  /* Keep the OpenVDB grids of volume images after loading them, until end_keep_vdb_grids() is
+   * called. The geometry manager builds volume meshes from them, while images may be loaded in
+   * parallel. */
+  void begin_keep_vdb_grids();
+  void end_keep_vdb_grids();
+
   void device_load_builtin(Device *device, Scene *scene, Progress &progress);
   void device_free_builtin(Device *device);
 
@@ -206,15 +212,22 @@ class ImageManager {
 
     int users;
     thread_mutex mutex;
+    thread_mutex load_mutex;
   };
 
  private:
   bool has_half_images;
+  bool has_texture_cache;
+  bool texture_cache_used;
 
   thread_mutex device_mutex;
   thread_mutex images_mutex;
   int animation_frame;
 
+  thread_mutex vdb_grids_mutex;
+  bool keep_vdb_grids;
+  vector<int> kept_vdb_grid_slots;
+
   vector<Image *> images;
   void *osl_texture_system;
 
@@ -227,6 +240,8 @@ class ImageManager {
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
 
+  bool use_texture_cache(Scene *scene, Image *img);
+
   void device_load_image(Device *device, Scene *scene, int slot, Progress *progress);
   void device_free_image(Device *device, int slot);
 
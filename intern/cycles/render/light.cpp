@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/integrator.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -276,6 +277,69 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
+bool LightManager::use_light_tree(Scene *scene)
+{
+  const Integrator *integrator = scene->integrator;
+  if (!integrator->get_use_light_tree()) {
+    return false;
+  }
+  /* Sampling all lights with the branched path integrator relies on the layout of the flat
+   * distribution, to pick only triangles. */
+  return !(integrator->get_method() == Integrator::BRANCHED_PATH &&
+           (integrator->get_sample_all_lights_direct() ||
+            integrator->get_sample_all_lights_indirect()));
+}
+
+/* Estimate of the intensity of an emissive triangle, used to build the light tree. Shaders
+ * with varying emission are assumed to have unit strength. */
+static float light_tree_triangle_energy(DeviceScene *dscene, const Shader *shader, float area)
+{
+  const KernelShader &kshader = dscene->shaders[shader->id];
+  float strength = 1.0f;
+  if (kshader.flags & SD_HAS_CONSTANT_EMISSION) {
+    strength = average(make_float3(
+        kshader.constant_emission[0], kshader.constant_emission[1], kshader.constant_emission[2]));
+  }
+  return area * strength * M_1_PI_F;
+}
+
+/* Bounds of a lamp for the light tree, matching the emission of the lamp in the kernel.
+ * Distant and background lights can not be bounded, their bounds are left empty. */
+static void light_tree_lamp_emitter(const Light *light, LightTreeEmitter *emitter)
+{
+  const float3 co = light->get_co();
+  const float strength = average(light->get_strength());
+
+  switch (light->get_light_type()) {
+    case LIGHT_POINT:
+      emitter->bbox = BoundBox(co);
+      emitter->bbox.grow(co, light->get_size());
+      emitter->bcone = OrientationBounds::omnidirectional();
+      emitter->energy = strength * M_1_PI_F * 0.25f;
+      break;
+    case LIGHT_SPOT:
+      emitter->bbox = BoundBox(co);
+      emitter->bbox.grow(co, light->get_size());
+      emitter->bcone = {safe_normalize(light->get_dir()), 0.0f, light->get_spot_angle() * 0.5f};
+      emitter->energy = strength * M_1_PI_F * 0.25f;
+      break;
+    case LIGHT_AREA: {
+      const float3 axisu = light->get_axisu() * (light->get_sizeu() * light->get_size());
+      const float3 axisv = light->get_axisv() * (light->get_sizev() * light->get_size());
+      emitter->bbox = BoundBox(BoundBox::empty);
+      emitter->bbox.grow(co + 0.5f * (axisu + axisv));
+      emitter->bbox.grow(co + 0.5f * (axisu - axisv));
+      emitter->bbox.grow(co - 0.5f * (axisu + axisv));
+      emitter->bbox.grow(co - 0.5f * (axisu - axisv));
+      emitter->bcone = {safe_normalize(light->get_dir()), 0.0f, M_PI_2_F};
+      emitter->energy = strength * 0.25f;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
 void LightManager::device_update_distribution(Device *,
                                               DeviceScene *dscene,
                                               Scene *scene,
@@ -330,6 +394,15 @@ void LightManager::device_update_distribution(Device *,
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
 
+  /* light tree, the emitters are stored in the order of the distribution */
+  const bool use_light_tree = this->use_light_tree(scene);
+  vector<LightTreeEmitter> tree_emitters;
+  vector<float> tree_emitter_areas;
+  if (use_light_tree) {
+    tree_emitters.resize(num_distribution);
+    tree_emitter_areas.resize(num_triangles);
+  }
+
   /* triangles */
   size_t offset = 0;
   int j = 0;
@@ -382,6 +455,9 @@ void LightManager::device_update_distribution(Device *,
 
         Mesh::Triangle t = mesh->get_triangle(i);
         if (!t.valid(&mesh->get_verts()[0])) {
+          if (use_light_tree) {
+            tree_emitters[offset - 1].bbox = BoundBox(object->bounds.center());
+          }
           continue;
         }
         float3 p1 = mesh->get_verts()[t.v[0]];
@@ -394,7 +470,17 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree) {
+          LightTreeEmitter &emitter = tree_emitters[offset - 1];
+          emitter.bbox = BoundBox(p1);
+          emitter.bbox.grow(p2);
+          emitter.bbox.grow(p3);
+          emitter.energy = light_tree_triangle_energy(dscene, shader, area);
+          tree_emitter_areas[offset - 1] = area;
+        }
       }
     }
 
@@ -418,6 +504,10 @@ void LightManager::device_update_distribution(Device *,
     distribution[offset].lamp.size = light->size;
     totarea += lightarea;
 
+    if (use_light_tree) {
+      light_tree_lamp_emitter(light, &tree_emitters[offset]);
+    }
+
     if (light->light_type == LIGHT_DISTANT) {
       use_lamp_mis |= (light->angle > 0.0f && light->use_mis);
     }
@@ -495,6 +585,13 @@ void LightManager::device_update_distribution(Device *,
     /* CDF */
     dscene->light_distribution.copy_to_device();
 
+    if (use_light_tree) {
+      device_update_light_tree(dscene, tree_emitters, tree_emitter_areas);
+    }
+    else {
+      kintegrator->use_light_tree = false;
+    }
+
     /* Portals */
     if (num_portals > 0) {
       kbackground->portal_offset = light_index;
@@ -518,6 +615,7 @@ void LightManager::device_update_distribution(Device *,
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
 
     kbackground->num_portals = 0;
     kbackground->portal_offset = 0;
@@ -529,6 +627,90 @@ void LightManager::device_update_distribution(Device *,
   }
 }
 
+void LightManager::device_update_light_tree(DeviceScene *dscene,
+                                            vector<LightTreeEmitter> &emitters,
+                                            const vector<float> &triangle_areas)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+  const int num_distribution = emitters.size();
+
+  /* Distant and background lights are sampled separately, with the same probability as in the
+   * flat distribution. This keeps the pdf of the background map unchanged. */
+  vector<LightTreeEmitter> local_emitters;
+  vector<LightTreeEmitter> infinite_emitters;
+  for (int i = 0; i < num_distribution; i++) {
+    emitters[i].distribution_index = i;
+    if (!emitters[i].bbox.valid()) {
+      infinite_emitters.push_back(emitters[i]);
+    }
+    else {
+      local_emitters.push_back(emitters[i]);
+    }
+  }
+
+  LightTree tree(local_emitters);
+  const vector<KernelLightTreeNode> &tree_nodes = tree.get_nodes();
+
+  const int num_local = local_emitters.size();
+  const int num_infinite = infinite_emitters.size();
+  const int num_triangles = triangle_areas.size();
+
+  KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(tree_nodes.size());
+  std::copy(tree_nodes.begin(), tree_nodes.end(), knodes);
+
+  KernelLightTreeEmitter *kemitters = dscene->light_tree_emitters.alloc(num_distribution);
+  uint *distribution_to_emitter = dscene->light_tree_distribution_to_emitter.alloc(
+      num_distribution);
+
+  for (int i = 0; i < num_distribution; i++) {
+    const LightTreeEmitter &emitter = (i < num_local) ? local_emitters[i] :
+                                                        infinite_emitters[i - num_local];
+    KernelLightTreeEmitter &kemitter = kemitters[i];
+    kemitter.bounding_box_min[0] = emitter.bbox.min.x;
+    kemitter.bounding_box_min[1] = emitter.bbox.min.y;
+    kemitter.bounding_box_min[2] = emitter.bbox.min.z;
+    kemitter.energy = emitter.energy;
+    kemitter.bounding_box_max[0] = emitter.bbox.max.x;
+    kemitter.bounding_box_max[1] = emitter.bbox.max.y;
+    kemitter.bounding_box_max[2] = emitter.bbox.max.z;
+    kemitter.theta_o = emitter.bcone.theta_o;
+    kemitter.axis[0] = emitter.bcone.axis.x;
+    kemitter.axis[1] = emitter.bcone.axis.y;
+    kemitter.axis[2] = emitter.bcone.axis.z;
+    kemitter.theta_e = emitter.bcone.theta_e;
+    kemitter.distribution_index = emitter.distribution_index;
+    kemitter.leaf_index = emitter.leaf_index;
+    kemitter.distribution_probability = (emitter.distribution_index < num_triangles) ?
+                                            triangle_areas[emitter.distribution_index] *
+                                                kintegrator->pdf_triangles :
+                                            kintegrator->pdf_lights;
+    kemitter.pad1 = 0;
+
+    distribution_to_emitter[emitter.distribution_index] = i;
+  }
+
+  kintegrator->use_light_tree = true;
+  kintegrator->light_tree_num_local_emitters = num_local;
+  kintegrator->light_tree_num_infinite_emitters = num_infinite;
+  if (num_local == 0) {
+    kintegrator->light_tree_local_probability = 0.0f;
+  }
+  else if (num_infinite == 0) {
+    kintegrator->light_tree_local_probability = 1.0f;
+  }
+  else {
+    kintegrator->light_tree_local_probability = clamp(
+        1.0f - num_infinite * kintegrator->pdf_lights, 0.0f, 1.0f);
+  }
+
+  VLOG(1) << "Light tree with " << tree_nodes.size() << " nodes, " << num_local
+          << " local and " << num_infinite << " infinite emitters.";
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_emitters.copy_to_device();
+  dscene->light_tree_distribution_to_emitter.copy_to_device();
+}
+
 static void background_cdf(
     int start, int end, int res_x, int res_y, const vector<float3> *pixels, float2 *cond_cdf)
 {
@@ -1007,6 +1189,9 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_emitters.free();
+  dscene->light_tree_distribution_to_emitter.free();
   dscene->lights.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
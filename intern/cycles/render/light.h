@@ -34,6 +34,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceScene;
+struct LightTreeEmitter;
 class Object;
 class Progress;
 class Scene;
@@ -125,6 +126,9 @@ class LightManager {
                                   DeviceScene *dscene,
                                   Scene *scene,
                                   Progress &progress);
+  void device_update_light_tree(DeviceScene *dscene,
+                                vector<LightTreeEmitter> &emitters,
+                                const vector<float> &triangle_areas);
   void device_update_background(Device *device,
                                 DeviceScene *dscene,
                                 Scene *scene,
@@ -134,6 +138,9 @@ class LightManager {
   /* Check whether light manager can use the object as a light-emissive. */
   bool object_usable_as_light(Object *object);
 
+  /* Check whether lights are sampled with the light tree. */
+  bool use_light_tree(Scene *scene);
+
   struct IESSlot {
     IESFile ies;
     uint hash;
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Orientation Bounds */
+
+OrientationBounds OrientationBounds::merge(const OrientationBounds &cone_a,
+                                           const OrientationBounds &cone_b)
+{
+  /* Make sure a is the wider cone. */
+  const bool swap = cone_a.theta_o < cone_b.theta_o;
+  const OrientationBounds &a = swap ? cone_b : cone_a;
+  const OrientationBounds &b = swap ? cone_a : cone_b;
+
+  const float theta_d = safe_acosf(dot(a.axis, b.axis));
+  const float theta_e = fmaxf(a.theta_e, b.theta_e);
+
+  /* Cone a already contains b. */
+  if (fminf(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+    return {a.axis, a.theta_o, theta_e};
+  }
+
+  /* Cone containing both, rotated from a towards b. */
+  const float theta_o = (a.theta_o + theta_d + b.theta_o) * 0.5f;
+  const float3 rotation_axis = cross(a.axis, b.axis);
+  if (theta_o >= M_PI_F || len_squared(rotation_axis) < 1e-12f) {
+    return {a.axis, M_PI_F, theta_e};
+  }
+
+  const float3 axis = rotate_around_axis(
+      a.axis, normalize(rotation_axis), theta_o - a.theta_o);
+  return {normalize(axis), theta_o, theta_e};
+}
+
+float OrientationBounds::measure() const
+{
+  const float theta_w = fminf(theta_o + theta_e, M_PI_F);
+  const float cos_theta_o = cosf(theta_o);
+  const float sin_theta_o = sinf(theta_o);
+  return M_2PI_F * (1.0f - cos_theta_o) +
+         M_PI_2_F * (2.0f * theta_w * sin_theta_o - cosf(theta_o - 2.0f * theta_w) -
+                     2.0f * theta_o * sin_theta_o + cos_theta_o);
+}
+
+/* Light Tree */
+
+/* Number of buckets per axis used to find the best split. */
+static const int light_tree_num_buckets = 12;
+
+struct LightTreeBucket {
+  BoundBox bbox = BoundBox(BoundBox::empty);
+  OrientationBounds bcone = OrientationBounds::omnidirectional();
+  float energy = 0.0f;
+  int count = 0;
+
+  void add(const BoundBox &other_bbox,
+           const OrientationBounds &other_bcone,
+           const float other_energy,
+           const int other_count)
+  {
+    bcone = (count == 0) ? other_bcone : OrientationBounds::merge(bcone, other_bcone);
+    bbox.grow(other_bbox);
+    energy += other_energy;
+    count += other_count;
+  }
+
+  void add(const LightTreeBucket &other)
+  {
+    if (other.count > 0) {
+      add(other.bbox, other.bcone, other.energy, other.count);
+    }
+  }
+};
+
+/* Cost of a node with the surface area orientation heuristic. Degenerate bounds, like those of
+ * lamps in a row, use the length of the diagonal instead of the area. */
+static float light_tree_cost(const LightTreeBucket &bucket, const bool degenerate)
+{
+  const float size = degenerate ? len(bucket.bbox.size()) : bucket.bbox.half_area();
+  return bucket.energy * bucket.bcone.measure() * size;
+}
+
+LightTree::LightTree(vector<LightTreeEmitter> &emitters, const int max_emitters_in_leaf)
+    : max_emitters_in_leaf(max_emitters_in_leaf)
+{
+  if (emitters.empty()) {
+    return;
+  }
+
+  nodes.reserve(2 * emitters.size());
+  recursive_build(emitters, 0, emitters.size(), -1);
+}
+
+int LightTree::recursive_build(vector<LightTreeEmitter> &emitters,
+                               const int begin,
+                               const int end,
+                               const int parent_index)
+{
+  const int node_index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+
+  LightTreeBucket node;
+  BoundBox centroid_bbox = BoundBox(BoundBox::empty);
+  for (int i = begin; i < end; i++) {
+    const LightTreeEmitter &emitter = emitters[i];
+    node.add(emitter.bbox, emitter.bcone, emitter.energy, 1);
+    centroid_bbox.grow(emitter.centroid());
+  }
+
+  int middle = -1;
+  if (end - begin > max_emitters_in_leaf) {
+    middle = split(emitters, begin, end, node.bbox, centroid_bbox);
+  }
+
+  int child_index = -1;
+  if (middle != -1) {
+    recursive_build(emitters, begin, middle, node_index);
+    child_index = recursive_build(emitters, middle, end, node_index);
+  }
+  else {
+    for (int i = begin; i < end; i++) {
+      emitters[i].leaf_index = node_index;
+    }
+  }
+
+  /* Write the node after building the children, nodes may have been reallocated. */
+  KernelLightTreeNode &knode = nodes[node_index];
+  knode.bounding_box_min[0] = node.bbox.min.x;
+  knode.bounding_box_min[1] = node.bbox.min.y;
+  knode.bounding_box_min[2] = node.bbox.min.z;
+  knode.energy = node.energy;
+  knode.bounding_box_max[0] = node.bbox.max.x;
+  knode.bounding_box_max[1] = node.bbox.max.y;
+  knode.bounding_box_max[2] = node.bbox.max.z;
+  knode.theta_o = node.bcone.theta_o;
+  knode.axis[0] = node.bcone.axis.x;
+  knode.axis[1] = node.bcone.axis.y;
+  knode.axis[2] = node.bcone.axis.z;
+  knode.theta_e = node.bcone.theta_e;
+  knode.child_index = child_index;
+  knode.first_emitter = begin;
+  knode.num_emitters = end - begin;
+  knode.parent_index = parent_index;
+
+  return node_index;
+}
+
+/* Partition the emitters into two groups and return the index of the first emitter of the
+ * second group, or -1 to create a leaf. */
+int LightTree::split(vector<LightTreeEmitter> &emitters,
+                     const int begin,
+                     const int end,
+                     const BoundBox &bbox,
+                     const BoundBox &centroid_bbox)
+{
+  const float3 extent = bbox.size();
+  const float max_extent = max3(extent);
+  const float3 centroid_extent = centroid_bbox.size();
+  const bool degenerate = bbox.half_area() == 0.0f;
+
+  float min_cost = FLT_MAX;
+  int min_dim = -1;
+  int min_bucket = -1;
+
+  for (int dim = 0; dim < 3; dim++) {
+    if (centroid_extent[dim] == 0.0f) {
+      continue;
+    }
+
+    const float inv_extent = 1.0f / centroid_extent[dim];
+    LightTreeBucket buckets[light_tree_num_buckets];
+    for (int i = begin; i < end; i++) {
+      const LightTreeEmitter &emitter = emitters[i];
+      const int bucket_index = min(
+          (int)((emitter.centroid()[dim] - centroid_bbox.min[dim]) * inv_extent *
+                light_tree_num_buckets),
+          light_tree_num_buckets - 1);
+      buckets[bucket_index].add(emitter.bbox, emitter.bcone, emitter.energy, 1);
+    }
+
+    /* Costs of all splits between buckets, sweeping from both sides. */
+    float costs[light_tree_num_buckets - 1];
+    LightTreeBucket left;
+    for (int i = 0; i < light_tree_num_buckets - 1; i++) {
+      left.add(buckets[i]);
+      costs[i] = (left.count > 0) ? light_tree_cost(left, degenerate) : FLT_MAX;
+    }
+    LightTreeBucket right;
+    for (int i = light_tree_num_buckets - 1; i > 0; i--) {
+      right.add(buckets[i]);
+      costs[i - 1] = (right.count > 0 && costs[i - 1] != FLT_MAX) ?
+                         costs[i - 1] + light_tree_cost(right, degenerate) :
+                         FLT_MAX;
+    }
+
+    /* Prefer splitting along the longest axis. */
+    const float regularization = (extent[dim] > 0.0f) ? max_extent / extent[dim] : 1.0f;
+    for (int i = 0; i < light_tree_num_buckets - 1; i++) {
+      if (costs[i] != FLT_MAX && costs[i] * regularization < min_cost) {
+        min_cost = costs[i] * regularization;
+        min_dim = dim;
+        min_bucket = i;
+      }
+    }
+  }
+
+  if (min_dim == -1) {
+    /* All emitters have the same centroid, split them in the middle so leaves stay small. */
+    return (begin + end) / 2;
+  }
+
+  const float inv_extent = 1.0f / centroid_extent[min_dim];
+  const float centroid_min = centroid_bbox.min[min_dim];
+  LightTreeEmitter *middle = std::partition(
+      &emitters[begin], &emitters[end - 1] + 1, [&](const LightTreeEmitter &emitter) {
+        const int bucket_index = (int)((emitter.centroid()[min_dim] - centroid_min) * inv_extent *
+                                       light_tree_num_buckets);
+        return bucket_index <= min_bucket;
+      });
+
+  const int middle_index = middle - &emitters[0];
+  if (middle_index == begin || middle_index == end) {
+    return (begin + end) / 2;
+  }
+  return middle_index;
+}
+
+CCL_NAMESPACE_END
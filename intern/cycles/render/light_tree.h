@@ -0,0 +1,102 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds of the directions in which light is emitted: the normals are within theta_o of the
+ * axis, and light is emitted up to theta_e away from the normals. */
+
+struct OrientationBounds {
+  float3 axis;
+  float theta_o;
+  float theta_e;
+
+  /* Emits in all directions, like point lights and two-sided triangles. */
+  static OrientationBounds omnidirectional()
+  {
+    return {make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F};
+  }
+
+  /* Smallest bounds containing both. */
+  static OrientationBounds merge(const OrientationBounds &a, const OrientationBounds &b);
+
+  /* Solid angle measure used for the cost of splits. */
+  float measure() const;
+};
+
+/* Local emitter, a triangle or a point, spot or area lamp. Distant and background lights can
+ * not be bounded and are not part of the tree. */
+
+struct LightTreeEmitter {
+  BoundBox bbox = BoundBox(BoundBox::empty);
+  OrientationBounds bcone = OrientationBounds::omnidirectional();
+  float energy = 0.0f;
+
+  /* Entry in the light distribution. */
+  int distribution_index = -1;
+  /* Set when building the tree. */
+  int leaf_index = -1;
+
+  float3 centroid() const
+  {
+    return bbox.center();
+  }
+};
+
+/* Light Tree
+ *
+ * Bounding volume hierarchy over the local emitters, used to sample lights proportional to
+ * their estimated contribution to a shading point. Built with the surface area orientation
+ * heuristic from "Importance Sampling of Many Lights with Adaptive Tree Splitting" by Conty and
+ * Kulla. */
+
+class LightTree {
+ public:
+  /* The emitters are reordered, so that the emitters of every leaf are contiguous. */
+  LightTree(vector<LightTreeEmitter> &emitters, const int max_emitters_in_leaf = 4);
+
+  const vector<KernelLightTreeNode> &get_nodes() const
+  {
+    return nodes;
+  }
+
+ protected:
+  int recursive_build(vector<LightTreeEmitter> &emitters,
+                      const int begin,
+                      const int end,
+                      const int parent_index);
+  int split(vector<LightTreeEmitter> &emitters,
+            const int begin,
+            const int end,
+            const BoundBox &bbox,
+            const BoundBox &centroid_bbox);
+
+  vector<KernelLightTreeNode> nodes;
+  int max_emitters_in_leaf;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
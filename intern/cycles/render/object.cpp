@@ -226,6 +226,13 @@ void Object::tag_update(Scene *scene)
     }
   }
 
+  /* The scene BVH is only refit for transformed objects. */
+  const SocketModifiedFlags transform_flags = get_tfm_socket()->modified_flag_bit |
+                                              get_motion_socket()->modified_flag_bit;
+  if (socket_modified & ~transform_flags) {
+    scene->geometry_manager->need_scene_bvh_rebuild = true;
+  }
+
   scene->camera->need_flags_update = true;
   scene->geometry_manager->need_update = true;
   scene->object_manager->need_update = true;
@@ -918,6 +925,7 @@ void ObjectManager::tag_update(Scene *scene)
 {
   need_update = true;
   scene->geometry_manager->need_update = true;
+  scene->geometry_manager->need_scene_bvh_rebuild = true;
   scene->light_manager->need_update = true;
 }
 
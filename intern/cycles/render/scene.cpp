@@ -40,6 +40,7 @@
 #include "util/util_guarded_allocator.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_task.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -74,6 +75,10 @@ DeviceScene::DeviceScene(Device *device)
       attributes_float3(device, "__attributes_float3", MEM_GLOBAL),
       attributes_uchar4(device, "__attributes_uchar4", MEM_GLOBAL),
       light_distribution(device, "__light_distribution", MEM_GLOBAL),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_GLOBAL),
+      light_tree_emitters(device, "__light_tree_emitters", MEM_GLOBAL),
+      light_tree_distribution_to_emitter(
+          device, "__light_tree_distribution_to_emitter", MEM_GLOBAL),
       lights(device, "__lights", MEM_GLOBAL),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_GLOBAL),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_GLOBAL),
@@ -228,6 +233,11 @@ void Scene::device_update(Device *device_, Progress &progress)
    * - Light manager needs lookup tables and final mesh data to compute emission CDF.
    * - Film needs light manager to run for use_light_visibility
    * - Lookup tables are done a second time to handle film tables
+   *
+   * Images are only needed by the light manager for the background light, and by later
+   * managers. When the device memory can be updated from multiple threads, they are loaded in
+   * parallel with the geometry, object flags, camera volume and lookup tables. The geometry
+   * manager loads the images needed for displacement and volumes itself.
    */
 
   progress.set_status("Updating Shaders");
@@ -265,36 +275,67 @@ void Scene::device_update(Device *device_, Progress &progress)
   if (progress.get_cancel() || device->have_error())
     return;
 
+  TaskPool image_pool;
+  const bool update_images_in_parallel = device->info.has_thread_safe_memory;
+  if (update_images_in_parallel) {
+    /* Volume meshes are built from the OpenVDB grids, which are freed once an image is loaded. */
+    image_manager->begin_keep_vdb_grids();
+    image_pool.push([this, &progress] { image_manager->device_update(device, this, progress); });
+  }
+
+  /* Wait for the images before returning, the pool would cancel loads that did not start. */
+  auto cancel_update = [&] {
+    if (progress.get_cancel() || device->have_error()) {
+      image_pool.wait_work();
+      return true;
+    }
+    return false;
+  };
+
   progress.set_status("Updating Meshes");
   geometry_manager->device_update(device, &dscene, this, progress);
 
-  if (progress.get_cancel() || device->have_error())
+  if (update_images_in_parallel) {
+    image_manager->end_keep_vdb_grids();
+  }
+
+  if (cancel_update())
     return;
 
   progress.set_status("Updating Objects Flags");
   object_manager->device_update_flags(device, &dscene, this, progress);
 
-  if (progress.get_cancel() || device->have_error())
+  if (cancel_update())
     return;
 
-  progress.set_status("Updating Images");
-  image_manager->device_update(device, this, progress);
+  if (!update_images_in_parallel) {
+    progress.set_status("Updating Images");
+    image_manager->device_update(device, this, progress);
 
-  if (progress.get_cancel() || device->have_error())
-    return;
+    if (progress.get_cancel() || device->have_error())
+      return;
+  }
 
   progress.set_status("Updating Camera Volume");
   camera->device_update_volume(device, &dscene, this);
 
-  if (progress.get_cancel() || device->have_error())
+  if (cancel_update())
     return;
 
   progress.set_status("Updating Lookup Tables");
   lookup_tables->device_update(device, &dscene, this);
 
-  if (progress.get_cancel() || device->have_error())
+  if (cancel_update())
     return;
 
+  if (update_images_in_parallel) {
+    progress.set_status("Updating Images");
+    image_pool.wait_work();
+
+    if (progress.get_cancel() || device->have_error())
+      return;
+  }
+
   progress.set_status("Updating Lights");
   light_manager->device_update(device, &dscene, this, progress);
 
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/kernel_math.h"
+#include "kernel/kernel_types.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+#include "kernel/kernel_light_tree.h"
+
+#include "render/light_tree.h"
+
+#include "util/util_hash.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Kernel globals with the light tree of the given emitters, which are all local and equally
+ * likely to be picked by the flat distribution. */
+class LightTreeKernelGlobals {
+ public:
+  explicit LightTreeKernelGlobals(vector<LightTreeEmitter> emitters) : kg()
+  {
+    const int num_emitters = emitters.size();
+    for (int i = 0; i < num_emitters; i++) {
+      emitters[i].distribution_index = i;
+    }
+
+    LightTree tree(emitters);
+    nodes = tree.get_nodes();
+
+    kemitters.resize(num_emitters);
+    distribution_to_emitter.resize(num_emitters);
+    for (int i = 0; i < num_emitters; i++) {
+      const LightTreeEmitter &emitter = emitters[i];
+      KernelLightTreeEmitter &kemitter = kemitters[i];
+      kemitter.bounding_box_min[0] = emitter.bbox.min.x;
+      kemitter.bounding_box_min[1] = emitter.bbox.min.y;
+      kemitter.bounding_box_min[2] = emitter.bbox.min.z;
+      kemitter.energy = emitter.energy;
+      kemitter.bounding_box_max[0] = emitter.bbox.max.x;
+      kemitter.bounding_box_max[1] = emitter.bbox.max.y;
+      kemitter.bounding_box_max[2] = emitter.bbox.max.z;
+      kemitter.theta_o = emitter.bcone.theta_o;
+      kemitter.axis[0] = emitter.bcone.axis.x;
+      kemitter.axis[1] = emitter.bcone.axis.y;
+      kemitter.axis[2] = emitter.bcone.axis.z;
+      kemitter.theta_e = emitter.bcone.theta_e;
+      kemitter.distribution_index = emitter.distribution_index;
+      kemitter.leaf_index = emitter.leaf_index;
+      kemitter.distribution_probability = 1.0f / num_emitters;
+      kemitter.pad1 = 0;
+
+      distribution_to_emitter[emitter.distribution_index] = i;
+    }
+
+    kg.__light_tree_nodes.data = nodes.data();
+    kg.__light_tree_nodes.width = nodes.size();
+    kg.__light_tree_emitters.data = kemitters.data();
+    kg.__light_tree_emitters.width = kemitters.size();
+    kg.__light_tree_distribution_to_emitter.data = distribution_to_emitter.data();
+    kg.__light_tree_distribution_to_emitter.width = distribution_to_emitter.size();
+    kg.__data.integrator.use_light_tree = true;
+    kg.__data.integrator.light_tree_num_local_emitters = num_emitters;
+    kg.__data.integrator.light_tree_num_infinite_emitters = 0;
+    kg.__data.integrator.light_tree_local_probability = 1.0f;
+  }
+
+  /* Probability of picking the entry of the light distribution with the tree. */
+  float probability(const float3 P, const int distribution_index)
+  {
+    const int emitter = distribution_to_emitter[distribution_index];
+    return light_tree_distribution_pdf_factor(&kg, P, distribution_index) *
+           kemitters[emitter].distribution_probability;
+  }
+
+  KernelGlobals kg;
+
+ private:
+  vector<KernelLightTreeNode> nodes;
+  vector<KernelLightTreeEmitter> kemitters;
+  vector<uint> distribution_to_emitter;
+};
+
+float3 random_float3(const uint seed, const uint index)
+{
+  return make_float3(hash_uint3_to_float(seed, index, 0),
+                     hash_uint3_to_float(seed, index, 1),
+                     hash_uint3_to_float(seed, index, 2));
+}
+
+/* Point lamps of different sizes and strengths scattered in a box. */
+vector<LightTreeEmitter> random_point_emitters(const int num_emitters)
+{
+  vector<LightTreeEmitter> emitters(num_emitters);
+  for (int i = 0; i < num_emitters; i++) {
+    const float3 co = 10.0f * random_float3(1, i);
+    emitters[i].bbox = BoundBox(co);
+    emitters[i].bbox.grow(co, 0.1f * hash_uint2_to_float(2, i));
+    emitters[i].energy = 0.1f + hash_uint2_to_float(3, i);
+  }
+  return emitters;
+}
+
+}  // namespace
+
+TEST(render_light_tree, pdfs_sum_to_one)
+{
+  LightTreeKernelGlobals globals(random_point_emitters(100));
+
+  for (int j = 0; j < 10; j++) {
+    const float3 P = 12.0f * random_float3(4, j) - make_float3(1.0f, 1.0f, 1.0f);
+    float probability_sum = 0.0f;
+    for (int i = 0; i < 100; i++) {
+      probability_sum += globals.probability(P, i);
+    }
+    EXPECT_NEAR(probability_sum, 1.0f, 1e-4f);
+  }
+}
+
+TEST(render_light_tree, sample_matches_pdf)
+{
+  LightTreeKernelGlobals globals(random_point_emitters(100));
+  KernelGlobals *kg = &globals.kg;
+
+  const float3 P = make_float3(5.0f, 5.0f, 5.0f);
+  for (int j = 0; j < 100; j++) {
+    float randu = (j + 0.5f) / 100.0f;
+    float pdf_factor = 0.0f;
+    const int distribution_index = light_tree_sample(kg, P, &randu, &pdf_factor);
+    ASSERT_NE(distribution_index, -1);
+    EXPECT_NEAR(pdf_factor, light_tree_distribution_pdf_factor(kg, P, distribution_index), 1e-4f);
+    EXPECT_GE(randu, 0.0f);
+    EXPECT_LT(randu, 1.0f);
+  }
+}
+
+TEST(render_light_tree, single_light_matches_distribution)
+{
+  LightTreeKernelGlobals globals(random_point_emitters(1));
+  KernelGlobals *kg = &globals.kg;
+
+  const float3 P = make_float3(-3.0f, 2.0f, 20.0f);
+  EXPECT_EQ(light_tree_distribution_pdf_factor(kg, P, 0), 1.0f);
+
+  float randu = 0.3f;
+  float pdf_factor = 0.0f;
+  EXPECT_EQ(light_tree_sample(kg, P, &randu, &pdf_factor), 0);
+  EXPECT_EQ(pdf_factor, 1.0f);
+  EXPECT_FLOAT_EQ(randu, 0.3f);
+}
+
+CCL_NAMESPACE_END
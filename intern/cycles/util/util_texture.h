@@ -95,6 +95,8 @@ typedef enum ExtensionType {
 typedef struct TextureInfo {
   /* Pointer, offset or texture depending on device. */
   uint64_t data;
+  /* Handle in the texture cache when pixels are read from the file on demand, CPU only. */
+  uint64_t cache_handle;
   /* Data Type */
   uint data_type;
   /* Buffer number for OpenCL. */
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+#include "util/util_logging.h"
+#include "util/util_texture.h"
+#include "util/util_thread.h"
+
+#include <OpenImageIO/texture.h>
+
+OIIO_NAMESPACE_USING
+
+CCL_NAMESPACE_BEGIN
+
+static thread_mutex texture_cache_mutex;
+static int texture_cache_users = 0;
+static TextureSystem *texture_system = NULL;
+
+void TextureCache::init(const int max_memory_mb)
+{
+  thread_scoped_lock lock(texture_cache_mutex);
+
+  if (texture_cache_users == 0) {
+    /* Not shared with OSL, which uses its own settings. */
+    texture_system = TextureSystem::create(false);
+    texture_system->attribute("automip", 1);
+    texture_system->attribute("autotile", 64);
+    texture_system->attribute("gray_to_rgb", 1);
+  }
+  texture_cache_users++;
+
+  /* The cache is shared, use the budget of the session that started most recently. Lowering it
+   * frees tiles as new ones are read. */
+  texture_system->attribute("max_memory_MB", (float)max_memory_mb);
+  VLOG(1) << "Texture cache memory budget " << max_memory_mb << " MB.";
+}
+
+void TextureCache::exit()
+{
+  thread_scoped_lock lock(texture_cache_mutex);
+
+  texture_cache_users--;
+  if (texture_cache_users == 0) {
+    VLOG(1) << "Texture cache statistics:\n" << texture_system->getstats();
+    TextureSystem::destroy(texture_system);
+    texture_system = NULL;
+  }
+}
+
+uint64_t TextureCache::get_handle(const string &filepath)
+{
+  return (uint64_t)texture_system->get_texture_handle(ustring(filepath));
+}
+
+void TextureCache::invalidate(const string &filepath)
+{
+  texture_system->invalidate(ustring(filepath));
+}
+
+void TextureCache::lookup(const uint64_t handle,
+                          const int interpolation,
+                          const int extension,
+                          const float x,
+                          const float y,
+                          float result[4])
+{
+  TextureOpt options;
+
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_CUBIC:
+      options.interpmode = TextureOpt::InterpBicubic;
+      break;
+    case INTERPOLATION_SMART:
+      options.interpmode = TextureOpt::InterpSmartBicubic;
+      break;
+    default:
+      options.interpmode = TextureOpt::InterpBilinear;
+      break;
+  }
+
+  switch (extension) {
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_CLIP:
+      options.swrap = options.twrap = TextureOpt::WrapBlack;
+      break;
+    default:
+      options.swrap = options.twrap = TextureOpt::WrapPeriodic;
+      break;
+  }
+
+  /* Opaque for images without alpha, transparent outside of clipped images. */
+  options.fill = (extension == EXTENSION_CLIP && (x < 0.0f || x > 1.0f || y < 0.0f || y > 1.0f)) ?
+                     0.0f :
+                     1.0f;
+
+  /* There are no texture coordinate differentials for the lookup, so the finest mip level is
+   * used. Images are stored bottom to top in Cycles. */
+  TextureSystem::Perthread *thread_info = texture_system->get_perthread_info();
+  if (!texture_system->texture((TextureSystem::TextureHandle *)handle,
+                               thread_info,
+                               options,
+                               x,
+                               1.0f - y,
+                               0.0f,
+                               0.0f,
+                               0.0f,
+                               0.0f,
+                               4,
+                               result)) {
+    result[0] = TEX_IMAGE_MISSING_R;
+    result[1] = TEX_IMAGE_MISSING_G;
+    result[2] = TEX_IMAGE_MISSING_B;
+    result[3] = TEX_IMAGE_MISSING_A;
+  }
+}
+
+CCL_NAMESPACE_END
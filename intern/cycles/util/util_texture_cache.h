@@ -0,0 +1,59 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util/util_string.h"
+#include "util/util_types.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Image files looked up through the OpenImageIO texture system, instead of being loaded into
+ * memory in full before rendering. Tiles are read from the file when the kernel first looks them
+ * up, and are generated along with mip levels for files that are not tiled already. The least
+ * recently used tiles are freed to stay within the memory budget.
+ *
+ * There is a single cache for the process, only used by CPU devices. */
+
+class TextureCache {
+ public:
+  /* Start using the cache, with the memory budget in megabytes. The cache is shared by all
+   * users, it uses the budget of the latest one. */
+  static void init(const int max_memory_mb);
+  static void exit();
+
+  /* Handle of the file for lookups, valid until the cache is no longer used. */
+  static uint64_t get_handle(const string &filepath);
+
+  /* Free cached tiles of the file, so they are read again if the file changed. */
+  static void invalidate(const string &filepath);
+
+  /* Look up RGBA at normalized image coordinates, with the Cycles interpolation and extension
+   * types. Images with fewer channels are expanded like the ones loaded in memory. */
+  static void lookup(const uint64_t handle,
+                     const int interpolation,
+                     const int extension,
+                     const float x,
+                     const float y,
+                     float result[4]);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
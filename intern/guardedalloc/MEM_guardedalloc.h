@@ -244,6 +244,20 @@ void MEM_use_lockfree_allocator(void);
  * NOTE: The switch between allocator types can only happen before any allocation did happen. */
 void MEM_use_guarded_allocator(void);
 
+/* Allocate small blocks of the lock-free allocator from per-thread free lists of fixed size
+ * blocks, instead of using the system allocator for every block. This avoids contention when
+ * many threads allocate and free small blocks at the same time. Memory of these blocks is kept
+ * for reuse and not returned to the system.
+ *
+ * Blocks allocated before the switch remain valid, so this can be changed at any time. It is
+ * enabled by default when building with WITH_MEM_SMALL_OBJECT_POOL. */
+void MEM_use_small_object_pool(bool enabled);
+
+/* Back blocks of several megabytes with transparent huge pages, which reduces the number of TLB
+ * misses when processing large arrays. Pages are still placed on the NUMA node of the thread that
+ * touches them first. Only supported on Linux. */
+void MEM_use_huge_pages(bool enabled);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
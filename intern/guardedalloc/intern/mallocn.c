@@ -27,6 +27,11 @@
 
 #include <assert.h>
 
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
 #include "mallocn_intern.h"
 
 #ifdef WITH_JEMALLOC_CONF
@@ -96,6 +101,36 @@ void aligned_free(void *ptr)
 #endif
 }
 
+static bool huge_pages_enabled = false;
+
+bool huge_pages_is_enabled(void)
+{
+  return huge_pages_enabled;
+}
+
+void huge_pages_advise_range(void *ptr, size_t len)
+{
+#ifdef MADV_HUGEPAGE
+  /* Only whole pages inside of the block can be advised, the pages at the start and end of the
+   * block might be shared with other blocks. The advice has to be given before the pages are
+   * touched the first time, they are not merged into huge pages right away afterwards. */
+  const uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+  const uintptr_t start = ((uintptr_t)ptr + page_size - 1) & ~(page_size - 1);
+  const uintptr_t end = ((uintptr_t)ptr + len) & ~(page_size - 1);
+  if (start < end) {
+    madvise((void *)start, (size_t)(end - start), MADV_HUGEPAGE);
+  }
+#else
+  (void)ptr;
+  (void)len;
+#endif
+}
+
+void MEM_use_huge_pages(bool enabled)
+{
+  huge_pages_enabled = enabled;
+}
+
 /* Perform assert checks on allocator type change.
  *
  * Helps catching issues (in debug build) caused by an unintended allocator type change when there
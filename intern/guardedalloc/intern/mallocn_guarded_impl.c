@@ -452,6 +452,7 @@ void *MEM_guarded_mallocN(size_t len, const char *str)
   len = SIZET_ALIGN_4(len);
 
   memh = (MemHead *)malloc(len + sizeof(MemHead) + sizeof(MemTail));
+  huge_pages_advise(memh, len + sizeof(MemHead) + sizeof(MemTail));
 
   if (LIKELY(memh)) {
     make_memhead_header(memh, len, str);
@@ -518,6 +519,7 @@ void *MEM_guarded_mallocN_aligned(size_t len, size_t alignment, const char *str)
 
   MemHead *memh = (MemHead *)aligned_malloc(
       len + extra_padding + sizeof(MemHead) + sizeof(MemTail), alignment);
+  huge_pages_advise(memh, len + extra_padding + sizeof(MemHead) + sizeof(MemTail));
 
   if (LIKELY(memh)) {
     /* We keep padding in the beginning of MemHead,
@@ -553,6 +555,7 @@ void *MEM_guarded_callocN(size_t len, const char *str)
   len = SIZET_ALIGN_4(len);
 
   memh = (MemHead *)calloc(len + sizeof(MemHead) + sizeof(MemTail), 1);
+  huge_pages_advise(memh, len + sizeof(MemHead) + sizeof(MemTail));
 
   if (memh) {
     make_memhead_header(memh, len, str);
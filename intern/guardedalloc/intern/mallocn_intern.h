@@ -112,6 +112,35 @@ void aligned_free(void *ptr);
 extern bool leak_detector_has_run;
 extern char free_after_leak_detection_message[];
 
+/* Per-thread counters of allocated blocks and memory, see memory_usage.cc. */
+void memory_usage_block_alloc(size_t size);
+void memory_usage_block_free(size_t size);
+size_t memory_usage_block_num(void) ATTR_WARN_UNUSED_RESULT;
+size_t memory_usage_current(void) ATTR_WARN_UNUSED_RESULT;
+size_t memory_usage_peak(void) ATTR_WARN_UNUSED_RESULT;
+void memory_usage_peak_reset(void);
+
+/* Blocks up to this size (including the MemHead) can be allocated from the small object pool,
+ * see small_object_pool.cc. */
+#define MEM_SMALL_OBJECT_POOL_MAX_SIZE 256
+
+void *small_object_pool_alloc(size_t size) ATTR_WARN_UNUSED_RESULT;
+void small_object_pool_free(void *ptr, size_t size);
+
+/* Blocks of at least this size are backed by huge pages, when enabled with
+ * #MEM_use_huge_pages. */
+#define MEM_HUGE_PAGES_MIN_SIZE ((size_t)4 << 20)
+
+bool huge_pages_is_enabled(void);
+void huge_pages_advise_range(void *ptr, size_t len);
+
+MEM_INLINE void huge_pages_advise(void *ptr, size_t len)
+{
+  if (len >= MEM_HUGE_PAGES_MIN_SIZE && ptr != NULL && huge_pages_is_enabled()) {
+    huge_pages_advise_range(ptr, len);
+  }
+}
+
 /* Prototypes for counted allocator functions */
 size_t MEM_lockfree_allocN_len(const void *vmemh) ATTR_WARN_UNUSED_RESULT;
 void MEM_lockfree_freeN(void *vmemh);
@@ -20,6 +20,7 @@
  * Memory allocation which keeps track on allocated memory counters
  */
 
+#include <assert.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h> /* memcpy */
@@ -30,7 +31,6 @@
 /* to ensure strict conversions */
 #include "../../source/blender/blenlib/BLI_strict_flags.h"
 
-#include "atomic_ops.h"
 #include "mallocn_intern.h"
 
 typedef struct MemHead {
@@ -43,31 +43,60 @@ typedef struct MemHeadAligned {
   size_t len;
 } MemHeadAligned;
 
-static unsigned int totblock = 0;
-static size_t mem_in_use = 0, peak_mem = 0;
 static bool malloc_debug_memset = false;
 
+#ifdef WITH_MEM_SMALL_OBJECT_POOL
+static bool use_small_object_pool = true;
+#else
+static bool use_small_object_pool = false;
+#endif
+
 static void (*error_callback)(const char *) = NULL;
 
 enum {
   MEMHEAD_ALIGN_FLAG = 1,
+  /* Block is allocated from the small object pool. */
+  MEMHEAD_POOL_FLAG = 2,
 };
 
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned *)ptr) - 1)
 #define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t)MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_POOLED(memhead) ((memhead)->len & (size_t)MEMHEAD_POOL_FLAG)
+#define MEMHEAD_FLAGS ((size_t)(MEMHEAD_ALIGN_FLAG | MEMHEAD_POOL_FLAG))
 
-/* Uncomment this to have proper peak counter. */
-#define USE_ATOMIC_MAX
+/* Allocate a block with room for the MemHead, from the small object pool when possible.
+ * The flag that has to be stored in the MemHead is returned in r_flag. */
+MEM_INLINE MemHead *memhead_malloc(size_t len, size_t *r_flag)
+{
+  const size_t size = len + sizeof(MemHead);
+  if (use_small_object_pool && size <= MEM_SMALL_OBJECT_POOL_MAX_SIZE) {
+    *r_flag = (size_t)MEMHEAD_POOL_FLAG;
+    return (MemHead *)small_object_pool_alloc(size);
+  }
+  *r_flag = 0;
+  MemHead *memh = (MemHead *)malloc(size);
+  huge_pages_advise(memh, size);
+  return memh;
+}
 
-MEM_INLINE void update_maximum(size_t *maximum_value, size_t value)
+/* Same as #memhead_malloc, with the memory initialized to zero. */
+MEM_INLINE MemHead *memhead_calloc(size_t len, size_t *r_flag)
 {
-#ifdef USE_ATOMIC_MAX
-  atomic_fetch_and_update_max_z(maximum_value, value);
-#else
-  *maximum_value = value > *maximum_value ? value : *maximum_value;
-#endif
+  const size_t size = len + sizeof(MemHead);
+  if (use_small_object_pool && size <= MEM_SMALL_OBJECT_POOL_MAX_SIZE) {
+    *r_flag = (size_t)MEMHEAD_POOL_FLAG;
+    void *mem = small_object_pool_alloc(size);
+    if (LIKELY(mem)) {
+      memset(mem, 0, size);
+    }
+    return (MemHead *)mem;
+  }
+  *r_flag = 0;
+  MemHead *memh = (MemHead *)calloc(1, size);
+  huge_pages_advise(memh, size);
+  return memh;
 }
 
 #ifdef __GNUC__
@@ -92,7 +121,7 @@ print_error(const char *str, ...)
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
   if (vmemh) {
-    return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t)(MEMHEAD_ALIGN_FLAG));
+    return MEMHEAD_FROM_PTR(vmemh)->len & ~MEMHEAD_FLAGS;
   }
 
   return 0;
@@ -115,8 +144,7 @@ void MEM_lockfree_freeN(void *vmemh)
     return;
   }
 
-  atomic_sub_and_fetch_u(&totblock, 1);
-  atomic_sub_and_fetch_z(&mem_in_use, len);
+  memory_usage_block_free(len);
 
   if (UNLIKELY(malloc_debug_memset && len)) {
     memset(memh + 1, 255, len);
@@ -125,6 +153,9 @@ void MEM_lockfree_freeN(void *vmemh)
     MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
     aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
   }
+  else if (MEMHEAD_IS_POOLED(memh)) {
+    small_object_pool_free(memh, len + sizeof(MemHead));
+  }
   else {
     free(memh);
   }
@@ -229,23 +260,22 @@ void *MEM_lockfree_recallocN_id(void *vmemh, size_t len, const char *str)
 void *MEM_lockfree_callocN(size_t len, const char *str)
 {
   MemHead *memh;
+  size_t flag;
 
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+  memh = memhead_calloc(len, &flag);
 
   if (LIKELY(memh)) {
-    memh->len = len;
-    atomic_add_and_fetch_u(&totblock, 1);
-    atomic_add_and_fetch_z(&mem_in_use, len);
-    update_maximum(&peak_mem, mem_in_use);
+    memh->len = len | flag;
+    memory_usage_block_alloc(len);
 
     return PTR_FROM_MEMHEAD(memh);
   }
   print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
               SIZET_ARG(len),
               str,
-              (unsigned int)mem_in_use);
+              (unsigned int)memory_usage_current());
   return NULL;
 }
 
@@ -259,7 +289,7 @@ void *MEM_lockfree_calloc_arrayN(size_t len, size_t size, const char *str)
         SIZET_ARG(len),
         SIZET_ARG(size),
         str,
-        (unsigned int)mem_in_use);
+        (unsigned int)memory_usage_current());
     abort();
     return NULL;
   }
@@ -270,27 +300,26 @@ void *MEM_lockfree_calloc_arrayN(size_t len, size_t size, const char *str)
 void *MEM_lockfree_mallocN(size_t len, const char *str)
 {
   MemHead *memh;
+  size_t flag;
 
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)malloc(len + sizeof(MemHead));
+  memh = memhead_malloc(len, &flag);
 
   if (LIKELY(memh)) {
     if (UNLIKELY(malloc_debug_memset && len)) {
       memset(memh + 1, 255, len);
     }
 
-    memh->len = len;
-    atomic_add_and_fetch_u(&totblock, 1);
-    atomic_add_and_fetch_z(&mem_in_use, len);
-    update_maximum(&peak_mem, mem_in_use);
+    memh->len = len | flag;
+    memory_usage_block_alloc(len);
 
     return PTR_FROM_MEMHEAD(memh);
   }
   print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
               SIZET_ARG(len),
               str,
-              (unsigned int)mem_in_use);
+              (unsigned int)memory_usage_current());
   return NULL;
 }
 
@@ -304,7 +333,7 @@ void *MEM_lockfree_malloc_arrayN(size_t len, size_t size, const char *str)
         SIZET_ARG(len),
         SIZET_ARG(size),
         str,
-        (unsigned int)mem_in_use);
+        (unsigned int)memory_usage_current());
     abort();
     return NULL;
   }
@@ -338,6 +367,7 @@ void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str
 
   MemHeadAligned *memh = (MemHeadAligned *)aligned_malloc(
       len + extra_padding + sizeof(MemHeadAligned), alignment);
+  huge_pages_advise(memh, len + extra_padding + sizeof(MemHeadAligned));
 
   if (LIKELY(memh)) {
     /* We keep padding in the beginning of MemHead,
@@ -352,16 +382,14 @@ void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str
 
     memh->len = len | (size_t)MEMHEAD_ALIGN_FLAG;
     memh->alignment = (short)alignment;
-    atomic_add_and_fetch_u(&totblock, 1);
-    atomic_add_and_fetch_z(&mem_in_use, len);
-    update_maximum(&peak_mem, mem_in_use);
+    memory_usage_block_alloc(len);
 
     return PTR_FROM_MEMHEAD(memh);
   }
   print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
               SIZET_ARG(len),
               str,
-              (unsigned int)mem_in_use);
+              (unsigned int)memory_usage_current());
   return NULL;
 }
 
@@ -381,8 +409,9 @@ void MEM_lockfree_callbackmemlist(void (*func)(void *))
 
 void MEM_lockfree_printmemlist_stats(void)
 {
-  printf("\ntotal memory len: %.3f MB\n", (double)mem_in_use / (double)(1024 * 1024));
-  printf("peak memory len: %.3f MB\n", (double)peak_mem / (double)(1024 * 1024));
+  printf("\ntotal memory len: %.3f MB\n",
+         (double)memory_usage_current() / (double)(1024 * 1024));
+  printf("peak memory len: %.3f MB\n", (double)memory_usage_peak() / (double)(1024 * 1024));
   printf(
       "\nFor more detailed per-block statistics run Blender with memory debugging command line "
       "argument.\n");
@@ -410,23 +439,27 @@ void MEM_lockfree_set_memory_debug(void)
 
 size_t MEM_lockfree_get_memory_in_use(void)
 {
-  return mem_in_use;
+  return memory_usage_current();
 }
 
 unsigned int MEM_lockfree_get_memory_blocks_in_use(void)
 {
-  return totblock;
+  return (unsigned int)memory_usage_block_num();
 }
 
-/* dummy */
 void MEM_lockfree_reset_peak_memory(void)
 {
-  peak_mem = mem_in_use;
+  memory_usage_peak_reset();
 }
 
 size_t MEM_lockfree_get_peak_memory(void)
 {
-  return peak_mem;
+  return memory_usage_peak();
+}
+
+void MEM_use_small_object_pool(bool enabled)
+{
+  use_small_object_pool = enabled;
 }
 
 #ifndef NDEBUG
@@ -0,0 +1,232 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup MEM
+ *
+ * Counters for the number of allocated blocks and the amount of memory in use.
+ *
+ * Updating shared counters with atomics on every allocation makes all threads compete for the
+ * same cache line. Instead, every thread has its own counters that are only written by that
+ * thread. The totals are computed by summing up the counters of all threads when they are
+ * queried, so they are still exact.
+ *
+ * The peak memory usage can not be tracked exactly without shared state, it is only updated when
+ * the memory used by a thread grew by a certain amount since the last update or since the lowest
+ * usage of the thread after that.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "MEM_guardedalloc.h"
+#include "mallocn_intern.h"
+
+namespace {
+
+/**
+ * The peak is updated when the memory used by a thread grew by this amount since the thread
+ * updated it the last time, or since it used the least memory after that. The reported peak is
+ * at most this amount per thread lower than the actual peak.
+ */
+constexpr int64_t peak_update_threshold = 1024 * 1024;
+
+struct Local {
+  /** Only written by the thread owning this data, but read by other threads to compute totals.
+   * These can become negative when blocks are freed by a different thread than the one that
+   * allocated them. */
+  std::atomic<int64_t> blocks_num{0};
+  std::atomic<int64_t> mem_in_use{0};
+  /** Lowest value of #mem_in_use since this thread updated the peak the last time. Freeing
+   * blocks of other threads lowers it, otherwise the memory they allocated would not be counted
+   * when this thread allocates it again. */
+  int64_t mem_in_use_min_since_peak_update = 0;
+
+  /** All thread-local data is kept in an intrusive list. It is not allowed to use any allocator
+   * here, because this code is called from within the allocator. */
+  Local *prev = nullptr;
+  Local *next = nullptr;
+
+  Local();
+  ~Local();
+};
+
+struct Global {
+  /** Protects the list of thread-local data and is held while the totals are computed. */
+  std::mutex locals_mutex;
+  Local *locals = nullptr;
+
+  /** Counters of threads that exited already and of allocations done after the thread-local data
+   * of the current thread has been destructed. */
+  std::atomic<int64_t> blocks_num_outside_locals{0};
+  std::atomic<int64_t> mem_in_use_outside_locals{0};
+
+  std::atomic<size_t> peak{0};
+};
+
+}  // namespace
+
+/* Constant initialized, so it can be used before any dynamic initialization happened. */
+static Global global;
+
+static thread_local Local *local_data = nullptr;
+static thread_local bool local_data_destructed = false;
+
+Local::Local()
+{
+  std::lock_guard<std::mutex> lock{global.locals_mutex};
+  next = global.locals;
+  if (next != nullptr) {
+    next->prev = this;
+  }
+  global.locals = this;
+  local_data = this;
+}
+
+Local::~Local()
+{
+  std::lock_guard<std::mutex> lock{global.locals_mutex};
+  /* Keep the counts of this thread, because its blocks might be freed by other threads. */
+  global.blocks_num_outside_locals.fetch_add(blocks_num.load(std::memory_order_relaxed),
+                                             std::memory_order_relaxed);
+  global.mem_in_use_outside_locals.fetch_add(mem_in_use.load(std::memory_order_relaxed),
+                                             std::memory_order_relaxed);
+  if (prev != nullptr) {
+    prev->next = next;
+  }
+  else {
+    global.locals = next;
+  }
+  if (next != nullptr) {
+    next->prev = prev;
+  }
+  local_data = nullptr;
+  local_data_destructed = true;
+}
+
+/**
+ * Get the counters of the current thread. Returns null when the thread-local data has been
+ * destructed already, which happens for allocations done by destructors running at thread exit.
+ */
+static Local *get_local_data()
+{
+  if (LIKELY(local_data != nullptr)) {
+    return local_data;
+  }
+  if (local_data_destructed) {
+    return nullptr;
+  }
+  static thread_local Local local;
+  return &local;
+}
+
+/** Only adds the value without an atomic read-modify-write, the counter is only written by the
+ * thread it belongs to. */
+static int64_t local_counter_add(std::atomic<int64_t> &counter, const int64_t value)
+{
+  const int64_t new_value = counter.load(std::memory_order_relaxed) + value;
+  counter.store(new_value, std::memory_order_relaxed);
+  return new_value;
+}
+
+/** Has to be called while #Global.locals_mutex is locked. */
+static void sum_counters(int64_t *r_blocks_num, int64_t *r_mem_in_use)
+{
+  int64_t blocks_num = global.blocks_num_outside_locals.load(std::memory_order_relaxed);
+  int64_t mem_in_use = global.mem_in_use_outside_locals.load(std::memory_order_relaxed);
+  for (const Local *local = global.locals; local != nullptr; local = local->next) {
+    blocks_num += local->blocks_num.load(std::memory_order_relaxed);
+    mem_in_use += local->mem_in_use.load(std::memory_order_relaxed);
+  }
+  *r_blocks_num = blocks_num;
+  *r_mem_in_use = mem_in_use;
+}
+
+static void update_global_peak()
+{
+  std::lock_guard<std::mutex> lock{global.locals_mutex};
+  int64_t blocks_num, mem_in_use;
+  sum_counters(&blocks_num, &mem_in_use);
+  size_t peak = global.peak.load(std::memory_order_relaxed);
+  while (mem_in_use > 0 && (size_t)mem_in_use > peak &&
+         !global.peak.compare_exchange_weak(peak, (size_t)mem_in_use, std::memory_order_relaxed)) {
+  }
+}
+
+void memory_usage_block_alloc(size_t size)
+{
+  Local *local = get_local_data();
+  if (LIKELY(local != nullptr)) {
+    local_counter_add(local->blocks_num, 1);
+    const int64_t mem_in_use = local_counter_add(local->mem_in_use, (int64_t)size);
+    if (mem_in_use - local->mem_in_use_min_since_peak_update > peak_update_threshold) {
+      local->mem_in_use_min_since_peak_update = mem_in_use;
+      update_global_peak();
+    }
+  }
+  else {
+    global.blocks_num_outside_locals.fetch_add(1, std::memory_order_relaxed);
+    global.mem_in_use_outside_locals.fetch_add((int64_t)size, std::memory_order_relaxed);
+  }
+}
+
+void memory_usage_block_free(size_t size)
+{
+  Local *local = get_local_data();
+  if (LIKELY(local != nullptr)) {
+    local_counter_add(local->blocks_num, -1);
+    const int64_t mem_in_use = local_counter_add(local->mem_in_use, -(int64_t)size);
+    if (mem_in_use < local->mem_in_use_min_since_peak_update) {
+      local->mem_in_use_min_since_peak_update = mem_in_use;
+    }
+  }
+  else {
+    global.blocks_num_outside_locals.fetch_sub(1, std::memory_order_relaxed);
+    global.mem_in_use_outside_locals.fetch_sub((int64_t)size, std::memory_order_relaxed);
+  }
+}
+
+size_t memory_usage_block_num(void)
+{
+  std::lock_guard<std::mutex> lock{global.locals_mutex};
+  int64_t blocks_num, mem_in_use;
+  sum_counters(&blocks_num, &mem_in_use);
+  return (size_t)blocks_num;
+}
+
+size_t memory_usage_current(void)
+{
+  std::lock_guard<std::mutex> lock{global.locals_mutex};
+  int64_t blocks_num, mem_in_use;
+  sum_counters(&blocks_num, &mem_in_use);
+  return (size_t)mem_in_use;
+}
+
+size_t memory_usage_peak(void)
+{
+  /* Make sure the peak is never lower than the current usage. */
+  update_global_peak();
+  return global.peak.load(std::memory_order_relaxed);
+}
+
+void memory_usage_peak_reset(void)
+{
+  std::lock_guard<std::mutex> lock{global.locals_mutex};
+  int64_t blocks_num, mem_in_use;
+  sum_counters(&blocks_num, &mem_in_use);
+  global.peak.store((size_t)mem_in_use, std::memory_order_relaxed);
+}
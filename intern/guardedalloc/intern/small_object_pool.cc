@@ -0,0 +1,235 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup MEM
+ *
+ * Pool for small allocations of the lock-free allocator.
+ *
+ * Blocks are grouped into size classes that are a multiple of #block_size_granularity. Every
+ * thread keeps a free list per size class, so that allocating and freeing a block usually does
+ * not touch any shared state. Blocks are moved between the thread-local lists and a shared list
+ * per size class in batches. New blocks are carved out of chunks allocated from the system.
+ *
+ * Chunks are never returned to the system, their blocks are reused for allocations of the same
+ * size class.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+
+#include "MEM_guardedalloc.h"
+#include "mallocn_intern.h"
+
+namespace {
+
+/** Also the alignment of all blocks. */
+constexpr size_t block_size_granularity = 16;
+constexpr int size_classes_num = MEM_SMALL_OBJECT_POOL_MAX_SIZE / block_size_granularity;
+constexpr size_t chunk_size = 64 * 1024;
+/** Size of the header of every chunk, keeps the blocks aligned. */
+constexpr size_t chunk_header_size = block_size_granularity;
+/** Number of blocks moved between the thread-local and the shared free lists at once. */
+constexpr int transfer_batch_size = 32;
+/** When a thread has more free blocks of a size class, a batch is given back to the shared list. */
+constexpr int local_blocks_max = 2 * transfer_batch_size;
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct FreeList {
+  FreeBlock *first = nullptr;
+  int len = 0;
+
+  void push(void *ptr)
+  {
+    FreeBlock *block = static_cast<FreeBlock *>(ptr);
+    block->next = first;
+    first = block;
+    len++;
+  }
+
+  void *pop()
+  {
+    FreeBlock *block = first;
+    first = block->next;
+    len--;
+    return block;
+  }
+
+  /** Move up to the given number of blocks to the other list. */
+  void move_to(FreeList &other, const int amount)
+  {
+    for (int i = 0; i < amount && first != nullptr; i++) {
+      other.push(this->pop());
+    }
+  }
+};
+
+struct Chunk {
+  /** All chunks are kept in a list, so that they stay reachable for memory checking tools. */
+  Chunk *next;
+};
+
+struct SharedSizeClass {
+  std::mutex mutex;
+  FreeList free_blocks;
+};
+
+struct Global {
+  SharedSizeClass size_classes[size_classes_num];
+
+  std::mutex chunks_mutex;
+  Chunk *chunks = nullptr;
+};
+
+struct Local {
+  FreeList free_blocks[size_classes_num];
+
+  Local();
+  ~Local();
+};
+
+}  // namespace
+
+/* Constant initialized, so it can be used before any dynamic initialization happened. */
+static Global global;
+
+static thread_local Local *local_pool = nullptr;
+static thread_local bool local_pool_destructed = false;
+
+static int size_class_index(const size_t size)
+{
+  return (int)((size - 1) / block_size_granularity);
+}
+
+static size_t size_class_block_size(const int index)
+{
+  return (size_t)(index + 1) * block_size_granularity;
+}
+
+/** Allocate a new chunk and add all its blocks to the list. */
+static bool add_blocks_from_new_chunk(const int index, FreeList &free_blocks)
+{
+  char *memory = static_cast<char *>(malloc(chunk_size));
+  if (memory == nullptr) {
+    return false;
+  }
+  Chunk *chunk = reinterpret_cast<Chunk *>(memory);
+  {
+    std::lock_guard<std::mutex> lock{global.chunks_mutex};
+    chunk->next = global.chunks;
+    global.chunks = chunk;
+  }
+
+  const size_t block_size = size_class_block_size(index);
+  for (size_t offset = chunk_header_size; offset + block_size <= chunk_size;
+       offset += block_size) {
+    free_blocks.push(memory + offset);
+  }
+  return true;
+}
+
+/** Move a batch of blocks from the shared list to the given list. */
+static void take_shared_blocks(const int index, FreeList &free_blocks, const int amount)
+{
+  SharedSizeClass &size_class = global.size_classes[index];
+  std::lock_guard<std::mutex> lock{size_class.mutex};
+  if (size_class.free_blocks.first == nullptr) {
+    if (!add_blocks_from_new_chunk(index, size_class.free_blocks)) {
+      return;
+    }
+  }
+  size_class.free_blocks.move_to(free_blocks, amount);
+}
+
+/** Move a batch of blocks from the given list to the shared list. */
+static void give_shared_blocks(const int index, FreeList &free_blocks, const int amount)
+{
+  SharedSizeClass &size_class = global.size_classes[index];
+  std::lock_guard<std::mutex> lock{size_class.mutex};
+  free_blocks.move_to(size_class.free_blocks, amount);
+}
+
+Local::Local()
+{
+  local_pool = this;
+}
+
+Local::~Local()
+{
+  for (int index = 0; index < size_classes_num; index++) {
+    give_shared_blocks(index, free_blocks[index], free_blocks[index].len);
+  }
+  local_pool = nullptr;
+  local_pool_destructed = true;
+}
+
+/**
+ * Get the free lists of the current thread. Returns null when the thread-local data has been
+ * destructed already, which happens for allocations done by destructors running at thread exit.
+ */
+static Local *get_local_pool()
+{
+  if (LIKELY(local_pool != nullptr)) {
+    return local_pool;
+  }
+  if (local_pool_destructed) {
+    return nullptr;
+  }
+  static thread_local Local local;
+  return &local;
+}
+
+void *small_object_pool_alloc(size_t size)
+{
+  const int index = size_class_index(size);
+  Local *local = get_local_pool();
+  if (UNLIKELY(local == nullptr)) {
+    FreeList free_blocks;
+    take_shared_blocks(index, free_blocks, 1);
+    return free_blocks.first;
+  }
+
+  FreeList &free_blocks = local->free_blocks[index];
+  if (UNLIKELY(free_blocks.first == nullptr)) {
+    take_shared_blocks(index, free_blocks, transfer_batch_size);
+    if (free_blocks.first == nullptr) {
+      return nullptr;
+    }
+  }
+  return free_blocks.pop();
+}
+
+void small_object_pool_free(void *ptr, size_t size)
+{
+  const int index = size_class_index(size);
+  Local *local = get_local_pool();
+  if (UNLIKELY(local == nullptr)) {
+    FreeList free_blocks;
+    free_blocks.push(ptr);
+    give_shared_blocks(index, free_blocks, 1);
+    return;
+  }
+
+  FreeList &free_blocks = local->free_blocks[index];
+  free_blocks.push(ptr);
+  if (UNLIKELY(free_blocks.len > local_blocks_max)) {
+    give_shared_blocks(index, free_blocks, transfer_batch_size);
+  }
+}
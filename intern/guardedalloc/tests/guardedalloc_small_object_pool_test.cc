@@ -0,0 +1,146 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "guardedalloc_test_base.h"
+
+namespace {
+
+class SmallObjectPoolTest : public LockFreeAllocatorTest {
+ protected:
+  void SetUp() override
+  {
+    LockFreeAllocatorTest::SetUp();
+    MEM_use_small_object_pool(true);
+  }
+
+  void TearDown() override
+  {
+    MEM_use_small_object_pool(false);
+  }
+};
+
+/* Allocate blocks of many different sizes from the given amount of threads, the blocks are
+ * freed by the calling thread. */
+void alloc_from_threads(const int threads_num, const int blocks_per_thread)
+{
+  const unsigned int blocks_before = MEM_get_memory_blocks_in_use();
+  const size_t mem_before = MEM_get_memory_in_use();
+
+  std::vector<std::vector<void *>> blocks(threads_num);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_num; i++) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < blocks_per_thread; j++) {
+        const size_t len = (size_t)(j % 300) + 1;
+        char *mem = (char *)MEM_mallocN(len, __func__);
+        mem[len - 1] = (char)j;
+        blocks[i].push_back(mem);
+      }
+    });
+  }
+  size_t expected_mem = 0;
+  for (int i = 0; i < threads_num; i++) {
+    threads[i].join();
+    for (const void *mem : blocks[i]) {
+      expected_mem += MEM_allocN_len(mem);
+    }
+  }
+
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_before + threads_num * blocks_per_thread);
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_before + expected_mem);
+  EXPECT_GE(MEM_get_peak_memory(), mem_before + expected_mem);
+
+  for (int i = 0; i < threads_num; i++) {
+    for (void *mem : blocks[i]) {
+      MEM_freeN(mem);
+    }
+  }
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_before);
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_before);
+}
+
+}  // namespace
+
+TEST_F(LockFreeAllocatorTest, MemoryUsageFromThreads)
+{
+  alloc_from_threads(4, 10000);
+}
+
+TEST_F(SmallObjectPoolTest, MemoryUsageFromThreads)
+{
+  alloc_from_threads(4, 10000);
+}
+
+TEST_F(LockFreeAllocatorTest, PeakAfterFreeingBlocksOfOtherThread)
+{
+  const size_t block_len = 1024 * 1024;
+  const int blocks_num = 16;
+  std::vector<void *> blocks;
+
+  /* Freeing blocks allocated by another thread lowers the memory usage of this thread. */
+  std::thread thread([&]() {
+    for (int i = 0; i < blocks_num; i++) {
+      blocks.push_back(MEM_mallocN(block_len, __func__));
+    }
+  });
+  thread.join();
+  for (void *mem : blocks) {
+    MEM_freeN(mem);
+  }
+  blocks.clear();
+
+  MEM_reset_peak_memory();
+  const size_t mem_before = MEM_get_memory_in_use();
+  for (int i = 0; i < blocks_num; i++) {
+    blocks.push_back(MEM_mallocN(block_len, __func__));
+  }
+  for (void *mem : blocks) {
+    MEM_freeN(mem);
+  }
+  /* The peak is only updated after every megabyte a thread allocated. */
+  EXPECT_GE(MEM_get_peak_memory() + block_len, mem_before + blocks_num * block_len);
+}
+
+TEST_F(SmallObjectPoolTest, AllocSizes)
+{
+  const unsigned int blocks_before = MEM_get_memory_blocks_in_use();
+  std::vector<void *> blocks;
+  for (size_t len = 1; len < 400; len++) {
+    char *mem = (char *)MEM_callocN(len, __func__);
+    EXPECT_EQ(MEM_allocN_len(mem), (len + 3) & ~(size_t)3);
+    for (size_t i = 0; i < len; i++) {
+      EXPECT_EQ(mem[i], 0);
+    }
+    memset(mem, 1, MEM_allocN_len(mem));
+    blocks.push_back(mem);
+  }
+  for (void *&mem : blocks) {
+    const size_t len = MEM_allocN_len(mem);
+    mem = MEM_reallocN(mem, len * 2);
+    EXPECT_EQ(MEM_allocN_len(mem), len * 2);
+    EXPECT_EQ(((char *)mem)[len - 1], 1);
+  }
+  for (void *mem : blocks) {
+    MEM_freeN(mem);
+  }
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_before);
+}
+
+TEST_F(SmallObjectPoolTest, SwitchWhileAllocated)
+{
+  const unsigned int blocks_before = MEM_get_memory_blocks_in_use();
+  void *pooled = MEM_mallocN(16, __func__);
+  MEM_use_small_object_pool(false);
+  void *not_pooled = MEM_mallocN(16, __func__);
+  MEM_use_small_object_pool(true);
+  MEM_freeN(not_pooled);
+  MEM_use_small_object_pool(false);
+  MEM_freeN(pooled);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_before);
+}
@@ -231,6 +231,8 @@ void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const int type,
                                                   const char *name,
                                                   const int totelem);
+/* duplicate data of all layers with flag NOFREE, so that no layer references external data */
+void CustomData_duplicate_referenced_layers(struct CustomData *data, const int totelem);
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
 
 /* set the CD_FLAG_NOCOPY flag in custom data layers where the mask is
@@ -129,6 +129,20 @@ class GeometryComponent {
   virtual blender::Set<std::string> attribute_names() const;
   virtual bool is_empty() const;
 
+  /* Compute a hash of the geometry stored in the component. Components with the same content hash
+   * are expected to contain the same data, independent of where that data is stored. This has to
+   * read all the data, so it is not free. */
+  virtual uint64_t content_hash() const = 0;
+  /* Returns true when the other component has the same type and stores the same data. Contrary
+   * to comparing content hashes, this stops reading data at the first difference. */
+  virtual bool content_equals(const GeometryComponent &other) const = 0;
+
+  /* Returns true when the component does not reference data that is owned by someone else. Such
+   * components stay valid when the data they have been created from is freed. */
+  virtual bool owns_direct_data() const;
+  /* Copy all data that is owned by someone else. The component has to be mutable. */
+  virtual void ensure_owns_direct_data();
+
   /* Get a read-only attribute for the given domain and data type.
    * Returns null when it does not exist. */
   blender::bke::ReadAttributePtr attribute_try_get_for_read(
@@ -237,6 +251,8 @@ struct GeometrySet {
 
   void add(const GeometryComponent &component);
 
+  void ensure_owns_direct_data();
+
   void compute_boundbox_without_instances(blender::float3 *r_min, blender::float3 *r_max) const;
 
   friend std::ostream &operator<<(std::ostream &stream, const GeometrySet &geometry_set);
@@ -273,6 +289,14 @@ class MeshComponent : public GeometryComponent {
    * group names are stored on an object. Since we don't have an object here, we copy over the
    * names into this map. */
   blender::Map<std::string, int> vertex_group_names_;
+  /* When the mesh has been copied from another component or from a read-only mesh, its custom
+   * data layers still reference the arrays of the original. A layer is only duplicated when it is
+   * modified, and all remaining layers are duplicated before the mesh is handed out for general
+   * modification. */
+  bool has_referenced_layers_ = false;
+  /* The component that owns the referenced layers, if any. It is kept alive as long as this
+   * component might reference its data. */
+  blender::UserCounter<const GeometryComponent> referenced_layers_owner_;
 
  public:
   MeshComponent();
@@ -307,8 +331,17 @@ class MeshComponent : public GeometryComponent {
 
   blender::Set<std::string> attribute_names() const final;
   bool is_empty() const final;
+  uint64_t content_hash() const final;
+  bool content_equals(const GeometryComponent &other) const final;
+
+  bool owns_direct_data() const final;
+  void ensure_owns_direct_data() final;
 
   static constexpr inline GeometryComponentType static_type = GeometryComponentType::Mesh;
+
+ private:
+  Mesh *get_for_write_with_referenced_layers();
+  void ensure_layers_are_owned();
 };
 
 /** A geometry component that stores a point cloud. */
@@ -316,6 +349,9 @@ class PointCloudComponent : public GeometryComponent {
  private:
   PointCloud *pointcloud_ = nullptr;
   GeometryOwnershipType ownership_ = GeometryOwnershipType::Owned;
+  /* See #MeshComponent. */
+  bool has_referenced_layers_ = false;
+  blender::UserCounter<const GeometryComponent> referenced_layers_owner_;
 
  public:
   PointCloudComponent();
@@ -349,8 +385,17 @@ class PointCloudComponent : public GeometryComponent {
 
   blender::Set<std::string> attribute_names() const final;
   bool is_empty() const final;
+  uint64_t content_hash() const final;
+  bool content_equals(const GeometryComponent &other) const final;
+
+  bool owns_direct_data() const final;
+  void ensure_owns_direct_data() final;
 
   static constexpr inline GeometryComponentType static_type = GeometryComponentType::PointCloud;
+
+ private:
+  PointCloud *get_for_write_with_referenced_layers();
+  void ensure_layers_are_owned();
 };
 
 /** A geometry component that stores instances. */
@@ -388,6 +433,8 @@ class InstancesComponent : public GeometryComponent {
   int instances_amount() const;
 
   bool is_empty() const final;
+  uint64_t content_hash() const final;
+  bool content_equals(const GeometryComponent &other) const final;
 
   static constexpr inline GeometryComponentType static_type = GeometryComponentType::Instances;
 };
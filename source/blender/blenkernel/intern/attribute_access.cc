@@ -798,7 +798,7 @@ ReadAttributePtr PointCloudComponent::attribute_try_get_for_read(
 
 WriteAttributePtr PointCloudComponent::attribute_try_get_for_write(const StringRef attribute_name)
 {
-  PointCloud *pointcloud = this->get_for_write();
+  PointCloud *pointcloud = this->get_for_write_with_referenced_layers();
   if (pointcloud == nullptr) {
     return {};
   }
@@ -814,7 +814,7 @@ bool PointCloudComponent::attribute_try_delete(const StringRef attribute_name)
   if (this->attribute_is_builtin(attribute_name)) {
     return false;
   }
-  PointCloud *pointcloud = this->get_for_write();
+  PointCloud *pointcloud = this->get_for_write_with_referenced_layers();
   if (pointcloud == nullptr) {
     return false;
   }
@@ -842,7 +842,7 @@ bool PointCloudComponent::attribute_try_create(const StringRef attribute_name,
   if (!this->attribute_domain_with_type_supported(domain, data_type)) {
     return false;
   }
-  PointCloud *pointcloud = this->get_for_write();
+  PointCloud *pointcloud = this->get_for_write_with_referenced_layers();
   if (pointcloud == nullptr) {
     return false;
   }
@@ -970,7 +970,7 @@ ReadAttributePtr MeshComponent::attribute_try_get_for_read(const StringRef attri
 
 WriteAttributePtr MeshComponent::attribute_try_get_for_write(const StringRef attribute_name)
 {
-  Mesh *mesh = this->get_for_write();
+  Mesh *mesh = this->get_for_write_with_referenced_layers();
   if (mesh == nullptr) {
     return {};
   }
@@ -1007,6 +1007,10 @@ WriteAttributePtr MeshComponent::attribute_try_get_for_write(const StringRef att
     if (mesh_->dvert == nullptr) {
       BKE_object_defgroup_data_create(&mesh_->id);
     }
+    else {
+      CustomData_duplicate_referenced_layer(&mesh_->vdata, CD_MDEFORMVERT, mesh_->totvert);
+      update_mesh_pointers();
+    }
     return std::make_unique<blender::bke::VertexWeightWriteAttribute>(
         mesh_->dvert, mesh_->totvert, vertex_group_index);
   }
@@ -1037,7 +1041,7 @@ bool MeshComponent::attribute_try_delete(const StringRef attribute_name)
   if (this->attribute_is_builtin(attribute_name)) {
     return false;
   }
-  Mesh *mesh = this->get_for_write();
+  Mesh *mesh = this->get_for_write_with_referenced_layers();
   if (mesh == nullptr) {
     return false;
   }
@@ -1049,6 +1053,8 @@ bool MeshComponent::attribute_try_delete(const StringRef attribute_name)
 
   const int vertex_group_index = vertex_group_names_.lookup_default_as(attribute_name, -1);
   if (vertex_group_index != -1) {
+    CustomData_duplicate_referenced_layer(&mesh_->vdata, CD_MDEFORMVERT, mesh_->totvert);
+    BKE_mesh_update_customdata_pointers(mesh_, false);
     for (MDeformVert &dvert : blender::MutableSpan(mesh_->dvert, mesh_->totvert)) {
       MDeformWeight *weight = BKE_defvert_find_index(&dvert, vertex_group_index);
       BKE_defvert_remove_group(&dvert, weight);
@@ -1069,7 +1075,7 @@ bool MeshComponent::attribute_try_create(const StringRef attribute_name,
   if (!this->attribute_domain_with_type_supported(domain, data_type)) {
     return false;
   }
-  Mesh *mesh = this->get_for_write();
+  Mesh *mesh = this->get_for_write_with_referenced_layers();
   if (mesh == nullptr) {
     return false;
   }
@@ -80,6 +80,18 @@ void BKE_callback_add(bCallbackFuncStore *funcstore, eCbEvent evt)
   BLI_addtail(lb, funcstore);
 }
 
+/* Whether executing the callbacks of the event may run any code. */
+bool BKE_callback_is_used(eCbEvent evt)
+{
+  ListBase *lb = &callback_slots[evt];
+  LISTBASE_FOREACH (bCallbackFuncStore *, funcstore, lb) {
+    if (funcstore->is_used == NULL || funcstore->is_used(funcstore->arg)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void BKE_callback_global_init(void)
 {
   /* do nothing */
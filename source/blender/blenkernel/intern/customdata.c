@@ -42,6 +42,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -2505,6 +2506,78 @@ static bool customData_resize(CustomData *data, int amount)
   return true;
 }
 
+/* Layers of at least this many bytes are initialized from multiple threads. Besides being faster,
+ * this makes worker threads touch the memory pages first. On systems with multiple NUMA nodes the
+ * pages are then spread over the nodes of the threads that process the layer later on, instead of
+ * all being placed on the node of the thread that added the layer. */
+#define CUSTOMDATA_PARALLEL_INIT_MIN_SIZE (4 << 20)
+/* Number of elements initialized by one task. */
+#define CUSTOMDATA_PARALLEL_INIT_CHUNK_SIZE 16384
+
+typedef struct LayerInitData {
+  const LayerTypeInfo *typeInfo;
+  const void *source;
+  void *dest;
+  int totelem;
+  int chunks_num;
+} LayerInitData;
+
+static void layer_init_chunk_cb(void *__restrict userdata,
+                                const int chunk,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const LayerInitData *data = userdata;
+  const int start = chunk * CUSTOMDATA_PARALLEL_INIT_CHUNK_SIZE;
+  const int count = min_ii(CUSTOMDATA_PARALLEL_INIT_CHUNK_SIZE, data->totelem - start);
+  const size_t offset = (size_t)start * data->typeInfo->size;
+  void *dest = POINTER_OFFSET(data->dest, offset);
+
+  if (data->source) {
+    memcpy(dest, POINTER_OFFSET(data->source, offset), (size_t)count * data->typeInfo->size);
+  }
+  else {
+    data->typeInfo->set_default(dest, count);
+  }
+}
+
+static void layer_init_parallel(void *userdata)
+{
+  LayerInitData *data = userdata;
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, data->chunks_num, data, layer_init_chunk_cb, &settings);
+}
+
+/* Copy the elements from source when given, otherwise set them to the default value. */
+static void customData_layer_init(const LayerTypeInfo *typeInfo,
+                                  const void *source,
+                                  void *dest,
+                                  int totelem)
+{
+  if ((size_t)totelem * typeInfo->size < CUSTOMDATA_PARALLEL_INIT_MIN_SIZE) {
+    if (source) {
+      memcpy(dest, source, (size_t)totelem * typeInfo->size);
+    }
+    else {
+      typeInfo->set_default(dest, totelem);
+    }
+    return;
+  }
+
+  LayerInitData data = {
+      .typeInfo = typeInfo,
+      .source = source,
+      .dest = dest,
+      .totelem = totelem,
+      .chunks_num = (totelem + CUSTOMDATA_PARALLEL_INIT_CHUNK_SIZE - 1) /
+                    CUSTOMDATA_PARALLEL_INIT_CHUNK_SIZE,
+  };
+  /* Layers are added while holding locks, e.g. the evaluation mutex of a mesh wrapper. Without
+   * isolation, this thread could pick up an unrelated task needing the same lock while waiting. */
+  BLI_task_isolate(layer_init_parallel, &data);
+}
+
 static CustomDataLayer *customData_add_layer__internal(CustomData *data,
                                                        int type,
                                                        eCDAllocType alloctype,
@@ -2547,13 +2620,13 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
         typeInfo->copy(layerdata, newlayerdata, totelem);
       }
       else {
-        memcpy(newlayerdata, layerdata, (size_t)totelem * typeInfo->size);
+        customData_layer_init(typeInfo, layerdata, newlayerdata, totelem);
       }
     }
   }
   else if (alloctype == CD_DEFAULT) {
     if (typeInfo->set_default) {
-      typeInfo->set_default(newlayerdata, totelem);
+      customData_layer_init(typeInfo, NULL, newlayerdata, totelem);
     }
   }
   else if (alloctype == CD_REFERENCE) {
@@ -2813,6 +2886,13 @@ void *CustomData_duplicate_referenced_layer_named(CustomData *data,
   return customData_duplicate_referenced_layer_index(data, layer_index, totelem);
 }
 
+void CustomData_duplicate_referenced_layers(CustomData *data, const int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    customData_duplicate_referenced_layer_index(data, i, totelem);
+  }
+}
+
 bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 {
   /* get the layer index of the first layer of type */
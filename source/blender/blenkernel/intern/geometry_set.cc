@@ -14,22 +14,222 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "BLI_bitmap.h"
+#include "BLI_hash_mm2a.h"
+
+#include "BKE_customdata.h"
 #include "BKE_geometry_set.hh"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_pointcloud.h"
 
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
 
 #include "MEM_guardedalloc.h"
 
 using blender::float3;
+using blender::hash_combine;
+using blender::hash_string;
 using blender::MutableSpan;
 using blender::Span;
 using blender::StringRef;
 using blender::Vector;
 
+/* -------------------------------------------------------------------- */
+/** \name Content Hashing
+ * \{ */
+
+/* Two 32 bit hashes with different seeds are combined, because a single one is not enough to
+ * reliably detect changes in large arrays. */
+static uint64_t hash_memory(const void *data, const int64_t size)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  const uint64_t hash1 = BLI_hash_mm2(bytes, static_cast<size_t>(size), 0);
+  const uint64_t hash2 = BLI_hash_mm2(bytes, static_cast<size_t>(size), 0x9e3779b9);
+  return (hash1 << 32) | hash2;
+}
+
+/* Number of elements in the data array of a grid paint mask, see #GridPaintMask. */
+static int64_t grid_paint_mask_size(const GridPaintMask &mask)
+{
+  if (mask.data == nullptr || mask.level == 0) {
+    return 0;
+  }
+  const int64_t grid_size = (1 << (mask.level - 1)) + 1;
+  return grid_size * grid_size;
+}
+
+static uint64_t hash_mdisps(const Span<MDisps> mdisps)
+{
+  uint64_t hash = 0;
+  for (const MDisps &md : mdisps) {
+    hash = hash_combine(hash, static_cast<uint64_t>(md.totdisp));
+    hash = hash_combine(hash, static_cast<uint64_t>(md.level));
+    if (md.disps != nullptr) {
+      hash = hash_combine(hash, hash_memory(md.disps, sizeof(float[3]) * md.totdisp));
+    }
+    if (md.hidden != nullptr) {
+      hash = hash_combine(hash, hash_memory(md.hidden, BLI_BITMAP_SIZE(md.totdisp)));
+    }
+  }
+  return hash;
+}
+
+static bool mdisps_equal(const Span<MDisps> mdisps_a, const Span<MDisps> mdisps_b)
+{
+  for (const int i : mdisps_a.index_range()) {
+    const MDisps &a = mdisps_a[i];
+    const MDisps &b = mdisps_b[i];
+    if (a.totdisp != b.totdisp || a.level != b.level) {
+      return false;
+    }
+    if ((a.disps == nullptr) != (b.disps == nullptr) ||
+        (a.hidden == nullptr) != (b.hidden == nullptr)) {
+      return false;
+    }
+    if (a.disps != nullptr && memcmp(a.disps, b.disps, sizeof(float[3]) * a.totdisp) != 0) {
+      return false;
+    }
+    if (a.hidden != nullptr && memcmp(a.hidden, b.hidden, BLI_BITMAP_SIZE(a.totdisp)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint64_t hash_grid_paint_masks(const Span<GridPaintMask> masks)
+{
+  uint64_t hash = 0;
+  for (const GridPaintMask &mask : masks) {
+    const int64_t size = grid_paint_mask_size(mask);
+    hash = hash_combine(hash, static_cast<uint64_t>(size));
+    if (size > 0) {
+      hash = hash_combine(hash, hash_memory(mask.data, sizeof(float) * size));
+    }
+  }
+  return hash;
+}
+
+static bool grid_paint_masks_equal(const Span<GridPaintMask> masks_a,
+                                   const Span<GridPaintMask> masks_b)
+{
+  for (const int i : masks_a.index_range()) {
+    const int64_t size = grid_paint_mask_size(masks_a[i]);
+    if (size != grid_paint_mask_size(masks_b[i])) {
+      return false;
+    }
+    if (size > 0 && memcmp(masks_a[i].data, masks_b[i].data, sizeof(float) * size) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint64_t hash_custom_data(const CustomData &custom_data, const int size)
+{
+  uint64_t hash = static_cast<uint64_t>(size);
+  for (const CustomDataLayer &layer : Span(custom_data.layers, custom_data.totlayer)) {
+    hash = hash_combine(hash, static_cast<uint64_t>(layer.type));
+    hash = hash_combine(hash, hash_string(layer.name));
+    if (layer.data == nullptr) {
+      continue;
+    }
+    switch (layer.type) {
+      case CD_MDEFORMVERT: {
+        for (const MDeformVert &dvert : Span(static_cast<const MDeformVert *>(layer.data), size)) {
+          hash = hash_combine(hash,
+                              hash_memory(dvert.dw, sizeof(MDeformWeight) * dvert.totweight));
+        }
+        break;
+      }
+      case CD_MDISPS: {
+        hash = hash_combine(hash, hash_mdisps({static_cast<const MDisps *>(layer.data), size}));
+        break;
+      }
+      case CD_GRID_PAINT_MASK: {
+        hash = hash_combine(
+            hash, hash_grid_paint_masks({static_cast<const GridPaintMask *>(layer.data), size}));
+        break;
+      }
+      default: {
+        const int64_t layer_size = static_cast<int64_t>(CustomData_sizeof(layer.type)) * size;
+        hash = hash_combine(hash, hash_memory(layer.data, layer_size));
+        break;
+      }
+    }
+  }
+  return hash;
+}
+
+/* Compare custom data in the same way as it is hashed in #hash_custom_data. */
+static bool custom_data_equal(const CustomData &a, const CustomData &b, const int size)
+{
+  if (a.totlayer != b.totlayer) {
+    return false;
+  }
+  for (const int i : blender::IndexRange(a.totlayer)) {
+    const CustomDataLayer &layer_a = a.layers[i];
+    const CustomDataLayer &layer_b = b.layers[i];
+    if (layer_a.type != layer_b.type || !STREQ(layer_a.name, layer_b.name)) {
+      return false;
+    }
+    if (layer_a.data == layer_b.data) {
+      /* Layers are shared between copies of a geometry. */
+      continue;
+    }
+    if (layer_a.data == nullptr || layer_b.data == nullptr) {
+      return false;
+    }
+    switch (layer_a.type) {
+      case CD_MDEFORMVERT: {
+        const MDeformVert *dverts_a = static_cast<const MDeformVert *>(layer_a.data);
+        const MDeformVert *dverts_b = static_cast<const MDeformVert *>(layer_b.data);
+        for (const int j : blender::IndexRange(size)) {
+          if (dverts_a[j].totweight != dverts_b[j].totweight) {
+            return false;
+          }
+          if (dverts_a[j].totweight > 0 &&
+              memcmp(dverts_a[j].dw,
+                     dverts_b[j].dw,
+                     sizeof(MDeformWeight) * static_cast<size_t>(dverts_a[j].totweight)) != 0) {
+            return false;
+          }
+        }
+        break;
+      }
+      case CD_MDISPS: {
+        if (!mdisps_equal({static_cast<const MDisps *>(layer_a.data), size},
+                          {static_cast<const MDisps *>(layer_b.data), size})) {
+          return false;
+        }
+        break;
+      }
+      case CD_GRID_PAINT_MASK: {
+        if (!grid_paint_masks_equal({static_cast<const GridPaintMask *>(layer_a.data), size},
+                                    {static_cast<const GridPaintMask *>(layer_b.data), size})) {
+          return false;
+        }
+        break;
+      }
+      default: {
+        const size_t layer_size = static_cast<size_t>(CustomData_sizeof(layer_a.type)) *
+                                  static_cast<size_t>(size);
+        if (memcmp(layer_a.data, layer_b.data, layer_size) != 0) {
+          return false;
+        }
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Geometry Component
  * \{ */
@@ -86,6 +286,15 @@ bool GeometryComponent::is_empty() const
   return false;
 }
 
+bool GeometryComponent::owns_direct_data() const
+{
+  return true;
+}
+
+void GeometryComponent::ensure_owns_direct_data()
+{
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -147,6 +356,21 @@ void GeometrySet::add(const GeometryComponent &component)
   components_.add_new(component.type(), std::move(component_ptr));
 }
 
+/* Make sure that the geometry stays valid when the data it has been created from is freed, e.g.
+ * when it is kept around for longer than a single evaluation. */
+void GeometrySet::ensure_owns_direct_data()
+{
+  Vector<GeometryComponentType> component_types;
+  for (const GeometryComponentType type : components_.keys()) {
+    component_types.append(type);
+  }
+  for (const GeometryComponentType type : component_types) {
+    if (!this->get_component_for_read(type)->owns_direct_data()) {
+      this->get_component_for_write(type).ensure_owns_direct_data();
+    }
+  }
+}
+
 void GeometrySet::compute_boundbox_without_instances(float3 *r_min, float3 *r_max) const
 {
   const PointCloud *pointcloud = this->get_pointcloud_for_read();
@@ -166,18 +390,40 @@ std::ostream &operator<<(std::ostream &stream, const GeometrySet &geometry_set)
   return stream;
 }
 
-/* This generally should not be used. It is necessary currently, so that GeometrySet can by used by
- * the CPPType system. */
-bool operator==(const GeometrySet &UNUSED(a), const GeometrySet &UNUSED(b))
+/* Geometry sets are equal when they have the same components and the components store the same
+ * data. Components that are shared between both sets are not compared. */
+bool operator==(const GeometrySet &a, const GeometrySet &b)
 {
-  return false;
+  if (a.components_.size() != b.components_.size()) {
+    return false;
+  }
+  for (const auto item : a.components_.items()) {
+    const GeometrySet::GeometryComponentPtr *component_b = b.components_.lookup_ptr(item.key);
+    if (component_b == nullptr) {
+      return false;
+    }
+    const GeometryComponent *component_a = item.value.get();
+    if (component_a == component_b->get()) {
+      continue;
+    }
+    if (!component_a->content_equals(*component_b->get())) {
+      return false;
+    }
+  }
+  return true;
 }
 
-/* This generally should not be used. It is necessary currently, so that GeometrySet can by used by
- * the CPPType system. */
+/* Compute a hash of the content of all components. Geometry sets that are equal have the same
+ * hash, so that they can be used as keys in hash tables. */
 uint64_t GeometrySet::hash() const
 {
-  return reinterpret_cast<uint64_t>(this);
+  uint64_t hash = 0;
+  for (const auto item : components_.items()) {
+    /* The order of the components in the map is arbitrary, so the component hashes are combined
+     * in a way that does not depend on the order. */
+    hash ^= hash_combine(static_cast<uint64_t>(item.key), item.value.get()->content_hash());
+  }
+  return hash;
 }
 
 /* Returns a read-only mesh or null. */
@@ -277,12 +523,17 @@ MeshComponent::~MeshComponent()
   this->clear();
 }
 
+/* The copy references the custom data layers of this mesh. They are only duplicated when the copy
+ * modifies them. This component is kept alive until then, which also makes it immutable. */
 GeometryComponent *MeshComponent::copy() const
 {
   MeshComponent *new_component = new MeshComponent();
   if (mesh_ != nullptr) {
-    new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, true);
     new_component->ownership_ = GeometryOwnershipType::Owned;
+    new_component->has_referenced_layers_ = true;
+    this->user_add();
+    new_component->referenced_layers_owner_ = blender::UserCounter<const GeometryComponent>(this);
   }
   return new_component;
 }
@@ -296,6 +547,8 @@ void MeshComponent::clear()
     }
     mesh_ = nullptr;
   }
+  has_referenced_layers_ = false;
+  referenced_layers_owner_.reset();
   vertex_group_names_.clear();
 }
 
@@ -318,6 +571,7 @@ void MeshComponent::replace(Mesh *mesh, GeometryOwnershipType ownership)
 Mesh *MeshComponent::release()
 {
   BLI_assert(this->is_mutable());
+  this->ensure_layers_are_owned();
   Mesh *mesh = mesh_;
   mesh_ = nullptr;
   return mesh;
@@ -344,20 +598,124 @@ const Mesh *MeshComponent::get_for_read() const
 /* Get the mesh from this component. This method can only be used when the component is mutable,
  * i.e. it is not shared. The returned mesh can be modified. No ownership is transferred. */
 Mesh *MeshComponent::get_for_write()
+{
+  this->get_for_write_with_referenced_layers();
+  this->ensure_layers_are_owned();
+  return mesh_;
+}
+
+/* Same as #get_for_write, but custom data layers might still reference data of another mesh. The
+ * caller is responsible for calling #CustomData_duplicate_referenced_layer (or a variant of it)
+ * before modifying a layer. */
+Mesh *MeshComponent::get_for_write_with_referenced_layers()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ == GeometryOwnershipType::ReadOnly) {
-    mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    mesh_ = BKE_mesh_copy_for_eval(mesh_, true);
     ownership_ = GeometryOwnershipType::Owned;
+    has_referenced_layers_ = true;
   }
   return mesh_;
 }
 
+void MeshComponent::ensure_layers_are_owned()
+{
+  if (!has_referenced_layers_) {
+    return;
+  }
+  if (mesh_ != nullptr) {
+    CustomData_duplicate_referenced_layers(&mesh_->vdata, mesh_->totvert);
+    CustomData_duplicate_referenced_layers(&mesh_->edata, mesh_->totedge);
+    CustomData_duplicate_referenced_layers(&mesh_->fdata, mesh_->totface);
+    CustomData_duplicate_referenced_layers(&mesh_->ldata, mesh_->totloop);
+    CustomData_duplicate_referenced_layers(&mesh_->pdata, mesh_->totpoly);
+    BKE_mesh_update_customdata_pointers(mesh_, false);
+  }
+  has_referenced_layers_ = false;
+  referenced_layers_owner_.reset();
+}
+
 bool MeshComponent::is_empty() const
 {
   return mesh_ == nullptr;
 }
 
+bool MeshComponent::owns_direct_data() const
+{
+  return ownership_ == GeometryOwnershipType::Owned && !has_referenced_layers_;
+}
+
+void MeshComponent::ensure_owns_direct_data()
+{
+  BLI_assert(this->is_mutable());
+  if (mesh_ != nullptr && ownership_ != GeometryOwnershipType::Owned) {
+    mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    ownership_ = GeometryOwnershipType::Owned;
+  }
+  this->ensure_layers_are_owned();
+}
+
+uint64_t MeshComponent::content_hash() const
+{
+  if (mesh_ == nullptr) {
+    return 0;
+  }
+  /* Tessellation faces are not hashed, they are derived from the polygons and are not kept when
+   * a mesh is copied. */
+  uint64_t hash = hash_custom_data(mesh_->vdata, mesh_->totvert);
+  hash = hash_combine(hash, hash_custom_data(mesh_->edata, mesh_->totedge));
+  hash = hash_combine(hash, hash_custom_data(mesh_->ldata, mesh_->totloop));
+  hash = hash_combine(hash, hash_custom_data(mesh_->pdata, mesh_->totpoly));
+  hash = hash_combine(hash, hash_memory(mesh_->mat, sizeof(Material *) * mesh_->totcol));
+  hash = hash_combine(hash, static_cast<uint64_t>(mesh_->flag));
+  hash = hash_combine(hash, blender::DefaultHash<float>{}(mesh_->smoothresh));
+  for (const auto item : vertex_group_names_.items()) {
+    hash ^= hash_combine(hash_string(item.key), static_cast<uint64_t>(item.value));
+  }
+  return hash;
+}
+
+bool MeshComponent::content_equals(const GeometryComponent &other) const
+{
+  if (other.type() != GeometryComponentType::Mesh) {
+    return false;
+  }
+  const MeshComponent &other_mesh_component = static_cast<const MeshComponent &>(other);
+  const Mesh *mesh_a = mesh_;
+  const Mesh *mesh_b = other_mesh_component.mesh_;
+  if (mesh_a == nullptr || mesh_b == nullptr) {
+    return mesh_a == mesh_b;
+  }
+  if (vertex_group_names_.size() != other_mesh_component.vertex_group_names_.size()) {
+    return false;
+  }
+  for (const auto item : vertex_group_names_.items()) {
+    const int *other_index = other_mesh_component.vertex_group_names_.lookup_ptr(item.key);
+    if (other_index == nullptr || *other_index != item.value) {
+      return false;
+    }
+  }
+  if (mesh_a == mesh_b) {
+    return true;
+  }
+  /* Compare the sizes and settings first, so that most changes are detected without reading the
+   * custom data arrays. */
+  if (mesh_a->totvert != mesh_b->totvert || mesh_a->totedge != mesh_b->totedge ||
+      mesh_a->totloop != mesh_b->totloop || mesh_a->totpoly != mesh_b->totpoly ||
+      mesh_a->totcol != mesh_b->totcol || mesh_a->flag != mesh_b->flag ||
+      mesh_a->smoothresh != mesh_b->smoothresh) {
+    return false;
+  }
+  const size_t materials_size = sizeof(Material *) * static_cast<size_t>(mesh_a->totcol);
+  if (materials_size > 0 && memcmp(mesh_a->mat, mesh_b->mat, materials_size) != 0) {
+    return false;
+  }
+  return custom_data_equal(mesh_a->vdata, mesh_b->vdata, mesh_a->totvert) &&
+         custom_data_equal(mesh_a->edata, mesh_b->edata, mesh_a->totedge) &&
+         custom_data_equal(mesh_a->pdata, mesh_b->pdata, mesh_a->totpoly) &&
+         custom_data_equal(mesh_a->ldata, mesh_b->ldata, mesh_a->totloop);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -373,12 +731,16 @@ PointCloudComponent::~PointCloudComponent()
   this->clear();
 }
 
+/* See #MeshComponent::copy. */
 GeometryComponent *PointCloudComponent::copy() const
 {
   PointCloudComponent *new_component = new PointCloudComponent();
   if (pointcloud_ != nullptr) {
-    new_component->pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    new_component->pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, true);
     new_component->ownership_ = GeometryOwnershipType::Owned;
+    new_component->has_referenced_layers_ = true;
+    this->user_add();
+    new_component->referenced_layers_owner_ = blender::UserCounter<const GeometryComponent>(this);
   }
   return new_component;
 }
@@ -392,6 +754,8 @@ void PointCloudComponent::clear()
     }
     pointcloud_ = nullptr;
   }
+  has_referenced_layers_ = false;
+  referenced_layers_owner_.reset();
 }
 
 bool PointCloudComponent::has_pointcloud() const
@@ -413,6 +777,7 @@ void PointCloudComponent::replace(PointCloud *pointcloud, GeometryOwnershipType
 PointCloud *PointCloudComponent::release()
 {
   BLI_assert(this->is_mutable());
+  this->ensure_layers_are_owned();
   PointCloud *pointcloud = pointcloud_;
   pointcloud_ = nullptr;
   return pointcloud;
@@ -430,20 +795,92 @@ const PointCloud *PointCloudComponent::get_for_read() const
  * mutable, i.e. it is not shared. The returned point cloud can be modified. No ownership is
  * transferred. */
 PointCloud *PointCloudComponent::get_for_write()
+{
+  this->get_for_write_with_referenced_layers();
+  this->ensure_layers_are_owned();
+  return pointcloud_;
+}
+
+/* See #MeshComponent::get_for_write_with_referenced_layers. */
+PointCloud *PointCloudComponent::get_for_write_with_referenced_layers()
 {
   BLI_assert(this->is_mutable());
   if (ownership_ == GeometryOwnershipType::ReadOnly) {
-    pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, true);
     ownership_ = GeometryOwnershipType::Owned;
+    has_referenced_layers_ = true;
   }
   return pointcloud_;
 }
 
+void PointCloudComponent::ensure_layers_are_owned()
+{
+  if (!has_referenced_layers_) {
+    return;
+  }
+  if (pointcloud_ != nullptr) {
+    CustomData_duplicate_referenced_layers(&pointcloud_->pdata, pointcloud_->totpoint);
+    BKE_pointcloud_update_customdata_pointers(pointcloud_);
+  }
+  has_referenced_layers_ = false;
+  referenced_layers_owner_.reset();
+}
+
 bool PointCloudComponent::is_empty() const
 {
   return pointcloud_ == nullptr;
 }
 
+bool PointCloudComponent::owns_direct_data() const
+{
+  return ownership_ == GeometryOwnershipType::Owned && !has_referenced_layers_;
+}
+
+void PointCloudComponent::ensure_owns_direct_data()
+{
+  BLI_assert(this->is_mutable());
+  if (pointcloud_ != nullptr && ownership_ != GeometryOwnershipType::Owned) {
+    pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
+    ownership_ = GeometryOwnershipType::Owned;
+  }
+  this->ensure_layers_are_owned();
+}
+
+uint64_t PointCloudComponent::content_hash() const
+{
+  if (pointcloud_ == nullptr) {
+    return 0;
+  }
+  uint64_t hash = hash_custom_data(pointcloud_->pdata, pointcloud_->totpoint);
+  hash = hash_combine(hash,
+                      hash_memory(pointcloud_->mat, sizeof(Material *) * pointcloud_->totcol));
+  return hash;
+}
+
+bool PointCloudComponent::content_equals(const GeometryComponent &other) const
+{
+  if (other.type() != GeometryComponentType::PointCloud) {
+    return false;
+  }
+  const PointCloud *pointcloud_a = pointcloud_;
+  const PointCloud *pointcloud_b = static_cast<const PointCloudComponent &>(other).pointcloud_;
+  if (pointcloud_a == pointcloud_b) {
+    return true;
+  }
+  if (pointcloud_a == nullptr || pointcloud_b == nullptr) {
+    return false;
+  }
+  if (pointcloud_a->totpoint != pointcloud_b->totpoint ||
+      pointcloud_a->totcol != pointcloud_b->totcol) {
+    return false;
+  }
+  const size_t materials_size = sizeof(Material *) * static_cast<size_t>(pointcloud_a->totcol);
+  if (materials_size > 0 && memcmp(pointcloud_a->mat, pointcloud_b->mat, materials_size) != 0) {
+    return false;
+  }
+  return custom_data_equal(pointcloud_a->pdata, pointcloud_b->pdata, pointcloud_a->totpoint);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -544,6 +981,42 @@ bool InstancesComponent::is_empty() const
   return positions_.size() == 0;
 }
 
+uint64_t InstancesComponent::content_hash() const
+{
+  uint64_t hash = static_cast<uint64_t>(positions_.size());
+  hash = hash_combine(hash, hash_memory(positions_.data(), positions_.as_span().size_in_bytes()));
+  hash = hash_combine(hash, hash_memory(rotations_.data(), rotations_.as_span().size_in_bytes()));
+  hash = hash_combine(hash, hash_memory(scales_.data(), scales_.as_span().size_in_bytes()));
+  for (const InstancedData &data : instanced_data_) {
+    /* Objects and collections are instanced by reference, so hashing the pointer is enough. */
+    hash = hash_combine(hash, static_cast<uint64_t>(data.type));
+    hash = hash_combine(hash, blender::DefaultHash<void *>{}(data.data.object));
+  }
+  return hash;
+}
+
+bool InstancesComponent::content_equals(const GeometryComponent &other) const
+{
+  if (other.type() != GeometryComponentType::Instances) {
+    return false;
+  }
+  const InstancesComponent &other_instances = static_cast<const InstancesComponent &>(other);
+  if (positions_.size() != other_instances.positions_.size()) {
+    return false;
+  }
+  for (const int i : instanced_data_.index_range()) {
+    const InstancedData &data_a = instanced_data_[i];
+    const InstancedData &data_b = other_instances.instanced_data_[i];
+    if (data_a.type != data_b.type || data_a.data.object != data_b.data.object) {
+      return false;
+    }
+  }
+  const size_t size = positions_.as_span().size_in_bytes();
+  return memcmp(positions_.data(), other_instances.positions_.data(), size) == 0 &&
+         memcmp(rotations_.data(), other_instances.rotations_.data(), size) == 0 &&
+         memcmp(scales_.data(), other_instances.scales_.data(), size) == 0;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -0,0 +1,201 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_attribute_access.hh"
+#include "BKE_customdata.h"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.h"
+#include "BKE_mesh.h"
+
+#include "BLI_map.hh"
+#include "BLI_math_vector.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+class GeometrySetTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/* Create a mesh with a single vertex at the given position. */
+static GeometrySet create_geometry_with_vertex(const float3 position)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(1, 0, 0, 0, 0);
+  copy_v3_v3(mesh->mvert[0].co, position);
+  return GeometrySet::create_with_mesh(mesh);
+}
+
+TEST_F(GeometrySetTest, ContentHashIsStable)
+{
+  GeometrySet geometry_set = create_geometry_with_vertex({1.0f, 2.0f, 3.0f});
+  const uint64_t hash = geometry_set.hash();
+  EXPECT_EQ(geometry_set.hash(), hash);
+
+  /* The hash only depends on the content, not on where it is stored. */
+  GeometrySet other_geometry_set = create_geometry_with_vertex({1.0f, 2.0f, 3.0f});
+  EXPECT_NE(geometry_set.get_mesh_for_read(), other_geometry_set.get_mesh_for_read());
+  EXPECT_EQ(other_geometry_set.hash(), hash);
+
+  /* Copies of the geometry have the same hash. */
+  GeometrySet copied_geometry_set = geometry_set;
+  copied_geometry_set.get_mesh_for_write();
+  EXPECT_EQ(copied_geometry_set.hash(), hash);
+}
+
+TEST_F(GeometrySetTest, ContentHashChanges)
+{
+  GeometrySet geometry_set = create_geometry_with_vertex({1.0f, 2.0f, 3.0f});
+  const uint64_t hash = geometry_set.hash();
+
+  geometry_set.get_mesh_for_write()->mvert[0].co[2] = 4.0f;
+  EXPECT_NE(geometry_set.hash(), hash);
+
+  GeometrySet empty_geometry_set;
+  EXPECT_NE(empty_geometry_set.hash(), hash);
+}
+
+TEST_F(GeometrySetTest, EqualityComparesContent)
+{
+  GeometrySet geometry_set = create_geometry_with_vertex({1.0f, 2.0f, 3.0f});
+  GeometrySet other_geometry_set = create_geometry_with_vertex({1.0f, 2.0f, 3.0f});
+  EXPECT_EQ(geometry_set, other_geometry_set);
+
+  other_geometry_set.get_mesh_for_write()->mvert[0].co[0] = 0.0f;
+  EXPECT_FALSE(geometry_set == other_geometry_set);
+
+  GeometrySet empty_geometry_set;
+  EXPECT_FALSE(geometry_set == empty_geometry_set);
+  EXPECT_EQ(empty_geometry_set, GeometrySet());
+}
+
+TEST_F(GeometrySetTest, CacheLookup)
+{
+  Map<GeometrySet, int> cache;
+  cache.add(create_geometry_with_vertex({1.0f, 2.0f, 3.0f}), 1);
+
+  /* A geometry with the same content finds the cached value. */
+  GeometrySet geometry_set = create_geometry_with_vertex({1.0f, 2.0f, 3.0f});
+  EXPECT_EQ(cache.lookup_default(geometry_set, 0), 1);
+
+  /* A changed geometry is not found. */
+  geometry_set.get_mesh_for_write()->mvert[0].co[1] = 5.0f;
+  EXPECT_EQ(cache.lookup_default(geometry_set, 0), 0);
+}
+
+/* Create a mesh with a single quad that has multires displacement on its corners. */
+static GeometrySet create_geometry_with_displacement(const float displacement)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(4, 0, 0, 4, 1);
+  MDisps *mdisps = static_cast<MDisps *>(
+      CustomData_add_layer(&mesh->ldata, CD_MDISPS, CD_CALLOC, nullptr, mesh->totloop));
+  for (MDisps &md : MutableSpan(mdisps, mesh->totloop)) {
+    md.level = 2;
+    md.totdisp = 9;
+    md.disps = static_cast<float(*)[3]>(MEM_calloc_arrayN(9, sizeof(float[3]), __func__));
+    md.disps[4][2] = displacement;
+  }
+  return GeometrySet::create_with_mesh(mesh);
+}
+
+TEST_F(GeometrySetTest, DisplacementHashAgreesWithEquality)
+{
+  GeometrySet geometry_set = create_geometry_with_displacement(1.0f);
+  GeometrySet other_geometry_set = create_geometry_with_displacement(1.0f);
+  EXPECT_EQ(geometry_set.hash(), geometry_set.hash());
+  EXPECT_EQ(geometry_set, other_geometry_set);
+  EXPECT_EQ(geometry_set.hash(), other_geometry_set.hash());
+
+  GeometrySet changed_geometry_set = create_geometry_with_displacement(2.0f);
+  EXPECT_FALSE(geometry_set == changed_geometry_set);
+  EXPECT_NE(geometry_set.hash(), changed_geometry_set.hash());
+}
+
+/* Create a mesh with a float attribute called "test" on every vertex. */
+static GeometrySet create_geometry_with_attribute(const int size)
+{
+  GeometrySet geometry_set = GeometrySet::create_with_mesh(BKE_mesh_new_nomain(size, 0, 0, 0, 0));
+  MeshComponent &component = geometry_set.get_component_for_write<MeshComponent>();
+  component.attribute_try_create("test", ATTR_DOMAIN_POINT, CD_PROP_FLOAT);
+  WriteAttributePtr attribute = component.attribute_try_get_for_write("test");
+  for (const int i : IndexRange(size)) {
+    const float value = static_cast<float>(i);
+    attribute->set(i, &value);
+  }
+  return geometry_set;
+}
+
+static const void *get_layer_data(const GeometrySet &geometry_set, const CustomDataType type)
+{
+  const Mesh *mesh = geometry_set.get_mesh_for_read();
+  return CustomData_get_layer(&mesh->vdata, type);
+}
+
+TEST_F(GeometrySetTest, WriteToCopyDoesNotChangeSource)
+{
+  const GeometrySet geometry_set = create_geometry_with_attribute(4);
+  GeometrySet copied_geometry_set = geometry_set;
+
+  MeshComponent &copied_component = copied_geometry_set.get_component_for_write<MeshComponent>();
+  WriteAttributePtr attribute = copied_component.attribute_try_get_for_write("test");
+  const float value = 10.0f;
+  attribute->set(2, &value);
+  attribute.reset();
+
+  const float *source_data = static_cast<const float *>(
+      get_layer_data(geometry_set, CD_PROP_FLOAT));
+  const float *copied_data = static_cast<const float *>(
+      get_layer_data(copied_geometry_set, CD_PROP_FLOAT));
+  EXPECT_NE(source_data, copied_data);
+  EXPECT_EQ(source_data[2], 2.0f);
+  EXPECT_EQ(copied_data[2], 10.0f);
+  /* Layers that have not been written are still shared. */
+  EXPECT_EQ(get_layer_data(geometry_set, CD_MVERT), get_layer_data(copied_geometry_set, CD_MVERT));
+
+  /* Changing the mesh directly duplicates the remaining layers. */
+  Mesh *copied_mesh = copied_geometry_set.get_mesh_for_write();
+  copied_mesh->mvert[0].co[0] = 5.0f;
+  EXPECT_NE(get_layer_data(geometry_set, CD_MVERT), get_layer_data(copied_geometry_set, CD_MVERT));
+  EXPECT_EQ(geometry_set.get_mesh_for_read()->mvert[0].co[0], 0.0f);
+}
+
+TEST_F(GeometrySetTest, ReadFromCopySharesLayers)
+{
+  const GeometrySet geometry_set = create_geometry_with_attribute(4);
+  GeometrySet copied_geometry_set = geometry_set;
+
+  /* Getting a mutable component copies it, but the data is still shared. */
+  MeshComponent &copied_component = copied_geometry_set.get_component_for_write<MeshComponent>();
+  ReadAttributePtr attribute = copied_component.attribute_try_get_for_read("test");
+  float value;
+  attribute->get(3, &value);
+  EXPECT_EQ(value, 3.0f);
+
+  EXPECT_NE(geometry_set.get_mesh_for_read(), copied_geometry_set.get_mesh_for_read());
+  EXPECT_EQ(get_layer_data(geometry_set, CD_PROP_FLOAT),
+            get_layer_data(copied_geometry_set, CD_PROP_FLOAT));
+  EXPECT_EQ(get_layer_data(geometry_set, CD_MVERT), get_layer_data(copied_geometry_set, CD_MVERT));
+}
+
+}  // namespace blender::bke::tests
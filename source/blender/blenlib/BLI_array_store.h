@@ -42,6 +42,8 @@ BArrayState *BLI_array_store_state_add(BArrayStore *bs,
                                        const BArrayState *state_reference);
 void BLI_array_store_state_remove(BArrayStore *bs, BArrayState *state);
 
+bool BLI_array_store_state_is_equal(const BArrayState *state_a, const BArrayState *state_b);
+
 size_t BLI_array_store_state_size_get(BArrayState *state);
 void BLI_array_store_state_data_get(BArrayState *state, void *data);
 void *BLI_array_store_state_data_get_alloc(BArrayState *state, size_t *r_data_len);
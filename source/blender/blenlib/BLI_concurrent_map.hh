@@ -0,0 +1,362 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A `blender::ConcurrentMap<Key, Value>` is an associative container that can be filled and
+ * queried from many threads at the same time, without a mutex. It is meant for parallel
+ * algorithms that build a lookup table, which otherwise have to serialize on a mutex or build a
+ * separate map per thread and merge them afterwards.
+ *
+ * Like blender::Map, it is implemented using open addressing in a slot array with a power-of-two
+ * size. Every slot is in one of three states: empty, writing or occupied. A thread adding a key
+ * claims an empty slot with an atomic compare-and-swap, constructs the key and value in it and
+ * then marks it as occupied. Threads that probe a slot that is being written wait until it is
+ * occupied, so the map is not lock-free: a thread that stalls while writing a slot blocks all
+ * other threads that probe that slot. Usually the wait is short, since only the key and the value
+ * are constructed in the meantime. When constructing the key or the value throws an exception,
+ * the slot becomes empty again.
+ *
+ * Compared to blender::Map there are some restrictions:
+ * - The maximum number of keys has to be known when the map is constructed, the slot array never
+ *   grows. Adding more keys than that is not allowed and only checked with an assert.
+ * - Keys can not be removed.
+ * - Pointers to values stay valid until the map is destructed. The map does not synchronize
+ *   changes of values done through those pointers, that has to be done by the caller.
+ * - It is neither copyable nor movable.
+ *
+ * A benchmark can be found in tests/performance/BLI_concurrent_map_performance_test.cc.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include "BLI_array.hh"
+#include "BLI_hash.hh"
+#include "BLI_hash_tables.hh"
+#include "BLI_memory_utils.hh"
+#include "BLI_probing_strategies.hh"
+#include "BLI_task.hh"
+#include "BLI_utildefines.h"
+#include "BLI_utility_mixins.hh"
+
+namespace blender {
+
+template<
+    /** Type of the keys stored in the map. Keys have to be movable. */
+    typename Key,
+    /** Type of the value that is stored per key. */
+    typename Value,
+    /** The strategy used to deal with collisions, see BLI_probing_strategies.hh. */
+    typename ProbingStrategy = DefaultProbingStrategy,
+    /** The hash function used to hash the keys, see BLI_hash.hh. */
+    typename Hash = DefaultHash<Key>,
+    /** The equality operator used to compare keys. */
+    typename IsEqual = DefaultEquality>
+class ConcurrentMap : NonCopyable, NonMovable {
+ private:
+  enum SlotState : uint8_t {
+    Empty = 0,
+    Writing = 1,
+    Occupied = 2,
+  };
+
+  struct Slot {
+    std::atomic<uint8_t> state{Empty};
+    TypedBuffer<Key> key;
+    TypedBuffer<Value> value;
+  };
+
+  /** The maximum number of keys is half the number of slots. */
+  static constexpr uint8_t MaxLoadFactorNumerator = 1;
+  static constexpr uint8_t MaxLoadFactorDenominator = 2;
+
+  Array<Slot> slots_;
+  uint64_t slot_mask_;
+  int64_t max_size_;
+
+  /** Number of claimed slots, only updated with relaxed atomics. */
+  std::atomic<int64_t> size_{0};
+
+  Hash hash_;
+  IsEqual is_equal_;
+
+ public:
+  /**
+   * Create a map that can hold up to max_size keys. This capacity is fixed, the caller has to
+   * make sure that no more keys are added.
+   */
+  explicit ConcurrentMap(const int64_t max_size)
+      : slots_(total_slot_amount_for_usable_slots(
+            std::max<int64_t>(max_size, 1), MaxLoadFactorNumerator, MaxLoadFactorDenominator)),
+        max_size_(max_size)
+  {
+    slot_mask_ = static_cast<uint64_t>(slots_.size()) - 1;
+  }
+
+  ~ConcurrentMap()
+  {
+    for (Slot &slot : slots_) {
+      if (slot.state.load(std::memory_order_relaxed) == Occupied) {
+        slot.key.ref().~Key();
+        slot.value.ref().~Value();
+      }
+    }
+  }
+
+  /**
+   * Add a key-value pair to the map, if the key does not exist yet. Returns true when the pair
+   * was added. The value of an existing key is not changed.
+   */
+  bool add(const Key &key, const Value &value)
+  {
+    return this->add_as(key, value);
+  }
+  bool add(Key &&key, Value &&value)
+  {
+    return this->add_as(std::move(key), std::move(value));
+  }
+  template<typename ForwardKey, typename ForwardValue>
+  bool add_as(ForwardKey &&key, ForwardValue &&value)
+  {
+    bool is_new = false;
+    this->lookup_or_add__impl(
+        std::forward<ForwardKey>(key),
+        [&]() { return Value(std::forward<ForwardValue>(value)); },
+        hash_(key),
+        &is_new);
+    return is_new;
+  }
+
+  /**
+   * Returns a reference to the value that corresponds to the given key. If the key is not in the
+   * map yet, the value is created by calling create_value. It is only called by the thread that
+   * adds the key, other threads looking up the same key wait until the value is created.
+   *
+   * create_value must not access the map. While it runs, the slot of the key is being written,
+   * so a lookup or add that probes this slot from within the callback waits forever.
+   */
+  template<typename CreateValueF>
+  Value &lookup_or_add_cb(const Key &key, const CreateValueF &create_value)
+  {
+    return this->lookup_or_add_cb_as(key, create_value);
+  }
+  template<typename CreateValueF>
+  Value &lookup_or_add_cb(Key &&key, const CreateValueF &create_value)
+  {
+    return this->lookup_or_add_cb_as(std::move(key), create_value);
+  }
+  template<typename ForwardKey, typename CreateValueF>
+  Value &lookup_or_add_cb_as(ForwardKey &&key, const CreateValueF &create_value)
+  {
+    bool is_new;
+    return this->lookup_or_add__impl(
+        std::forward<ForwardKey>(key), create_value, hash_(key), &is_new);
+  }
+
+  /**
+   * Returns a reference to the value that corresponds to the given key. If the key is not in the
+   * map yet, the value is default constructed.
+   */
+  Value &lookup_or_add_default(const Key &key)
+  {
+    return this->lookup_or_add_cb(key, []() { return Value(); });
+  }
+
+  /**
+   * Returns a pointer to the value that corresponds to the given key. If the key is not in the
+   * map, nullptr is returned.
+   */
+  const Value *lookup_ptr(const Key &key) const
+  {
+    return this->lookup_ptr_as(key);
+  }
+  Value *lookup_ptr(const Key &key)
+  {
+    return const_cast<Value *>(const_cast<const ConcurrentMap *>(this)->lookup_ptr_as(key));
+  }
+  template<typename ForwardKey> const Value *lookup_ptr_as(const ForwardKey &key) const
+  {
+    const uint64_t hash = hash_(key);
+    SLOT_PROBING_BEGIN (ProbingStrategy, hash, slot_mask_, slot_index) {
+      const Slot &slot = slots_[slot_index];
+      const uint8_t state = this->wait_for_slot(slot);
+      if (state == Empty) {
+        return nullptr;
+      }
+      if (is_equal_(key, *slot.key)) {
+        return slot.value;
+      }
+    }
+    SLOT_PROBING_END();
+  }
+
+  /**
+   * Returns a copy of the value that corresponds to the given key, or default_value if the key
+   * is not in the map.
+   */
+  Value lookup_default(const Key &key, const Value &default_value) const
+  {
+    const Value *ptr = this->lookup_ptr(key);
+    return (ptr != nullptr) ? *ptr : default_value;
+  }
+
+  /**
+   * Returns true if there is a key in the map that compares equal to the given key.
+   */
+  bool contains(const Key &key) const
+  {
+    return this->lookup_ptr(key) != nullptr;
+  }
+
+  /**
+   * Call the function for all key-value pairs in the map, from multiple threads. Keys that are
+   * added while this is running might not be visited.
+   */
+  template<typename FuncT> void parallel_foreach_item(const FuncT &func)
+  {
+    parallel_for(slots_.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        Slot &slot = slots_[i];
+        if (slot.state.load(std::memory_order_acquire) == Occupied) {
+          func(*slot.key, *slot.value);
+        }
+      }
+    });
+  }
+
+  /**
+   * Call the function for all key-value pairs in the map, from the calling thread.
+   */
+  template<typename FuncT> void foreach_item(const FuncT &func)
+  {
+    for (Slot &slot : slots_) {
+      if (slot.state.load(std::memory_order_acquire) == Occupied) {
+        func(*slot.key, *slot.value);
+      }
+    }
+  }
+
+  /**
+   * Return the number of keys in the map. Keys that are being added at the same time might
+   * already be counted.
+   */
+  int64_t size() const
+  {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  bool is_empty() const
+  {
+    return this->size() == 0;
+  }
+
+  /**
+   * Return the maximum number of keys that can be added to the map.
+   */
+  int64_t max_size() const
+  {
+    return max_size_;
+  }
+
+  /**
+   * Get the number of bytes used by the slot array.
+   */
+  int64_t size_in_bytes() const
+  {
+    return static_cast<int64_t>(sizeof(Slot) * slots_.size());
+  }
+
+ private:
+  /**
+   * Wait until the slot is not being written to anymore and return its state. Creating the value
+   * can take long, so the thread yields instead of spinning.
+   */
+  static uint8_t wait_for_slot(const Slot &slot)
+  {
+    uint8_t state = slot.state.load(std::memory_order_acquire);
+    while (state == Writing) {
+      std::this_thread::yield();
+      state = slot.state.load(std::memory_order_acquire);
+    }
+    return state;
+  }
+
+  /**
+   * Construct the key and value in a slot that has been claimed by this thread. When that fails,
+   * the slot is released again so that other threads can use it.
+   */
+  template<typename ForwardKey, typename CreateValueF>
+  void construct_in_claimed_slot(Slot &slot, ForwardKey &&key, const CreateValueF &create_value)
+  {
+    const int64_t old_size = size_.fetch_add(1, std::memory_order_relaxed);
+    BLI_assert(old_size < max_size_);
+    UNUSED_VARS_NDEBUG(old_size);
+    try {
+      new (&slot.key) Key(std::forward<ForwardKey>(key));
+    }
+    catch (...) {
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      slot.state.store(Empty, std::memory_order_release);
+      throw;
+    }
+    try {
+      new (&slot.value) Value(create_value());
+    }
+    catch (...) {
+      slot.key.ref().~Key();
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      slot.state.store(Empty, std::memory_order_release);
+      throw;
+    }
+    slot.state.store(Occupied, std::memory_order_release);
+  }
+
+  template<typename ForwardKey, typename CreateValueF>
+  Value &lookup_or_add__impl(ForwardKey &&key,
+                             const CreateValueF &create_value,
+                             const uint64_t hash,
+                             bool *r_is_new)
+  {
+    SLOT_PROBING_BEGIN (ProbingStrategy, hash, slot_mask_, slot_index) {
+      Slot &slot = slots_[slot_index];
+      uint8_t state = slot.state.load(std::memory_order_acquire);
+      /* A slot that is being written can become empty again when adding its key fails. */
+      while (state != Occupied) {
+        if (state == Writing) {
+          state = this->wait_for_slot(slot);
+          continue;
+        }
+        if (slot.state.compare_exchange_strong(state, Writing, std::memory_order_acquire)) {
+          this->construct_in_claimed_slot(slot, std::forward<ForwardKey>(key), create_value);
+          *r_is_new = true;
+          return *slot.value;
+        }
+        /* Another thread claimed the slot first, `state` contains its new state now. */
+      }
+      if (is_equal_(key, *slot.key)) {
+        *r_is_new = false;
+        return *slot.value;
+      }
+    }
+    SLOT_PROBING_END();
+  }
+};
+
+}  // namespace blender
@@ -155,6 +155,15 @@ inline uint64_t hash_string(StringRef str)
   return hash;
 }
 
+/**
+ * Mix another value into an existing hash. This can be used to compute the hash of a sequence of
+ * values, in which case the result depends on the order of the values.
+ */
+inline uint64_t hash_combine(const uint64_t hash, const uint64_t value)
+{
+  return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
 template<> struct DefaultHash<std::string> {
   /**
    * Take a #StringRef as parameter to support heterogeneous lookups in hash table implementations
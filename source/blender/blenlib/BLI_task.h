@@ -47,6 +47,14 @@ void BLI_task_scheduler_init(void);
 void BLI_task_scheduler_exit(void);
 int BLI_task_scheduler_num_threads(void);
 
+/* Task Isolation
+ *
+ * While waiting for the tasks it spawned, a thread can execute unrelated tasks of other pools or
+ * parallel loops. That deadlocks when the thread holds a lock which such a task needs too. While
+ * running the isolated function, the thread only executes tasks spawned from within it. */
+
+void BLI_task_isolate(void (*func)(void *userdata), void *userdata);
+
 /* Task Pool
  *
  * Pool of tasks that will be executed by the central task scheduler. For each
@@ -0,0 +1,314 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include "BLI_mmap.h"
+#include "BLI_fileops.h"
+#include "BLI_threads.h"
+#include "MEM_guardedalloc.h"
+
+#include "atomic_ops.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef WIN32
+#  include <sched.h>
+#  include <signal.h>
+#  include <stdlib.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#else
+#  include <io.h>
+#  include <windows.h>
+#endif
+
+struct BLI_mmap_file {
+  /* The address to which the file was mapped. */
+  char *memory;
+
+  /* The length of the file (and therefore the mapped region). */
+  size_t length;
+
+  /* Platform-specific handle for the mapping. */
+  void *handle;
+
+  /* Flag to indicate IO errors. Needs to be volatile since it's being set from
+   * within the signal handler, which is not part of the normal execution flow. */
+  volatile bool io_error;
+};
+
+#ifndef WIN32
+/* When using memory-mapped files, any IO errors will result in a SIGBUS signal.
+ * Therefore, we need to catch that signal and stop reading the file in question.
+ * To do so, we keep a table of all currently mapped files, and if a SIGBUS is caught,
+ * we check if the failed address is inside one of the mapped regions.
+ * If it is, we set a flag to indicate a failed read and remap the memory in
+ * question to a zero-backed region in order to avoid additional signals.
+ * The code that actually reads the memory area has to check whether the flag was
+ * set after it's done reading.
+ * If the error occurred outside of a memory-mapped region, we call the previous
+ * handler if one was configured and abort the process otherwise.
+ *
+ * Files are mapped from multiple threads, for example while reading previews of files.
+ * Changes to the table are protected by a mutex. The signal handler can't lock it, so it reads
+ * the table with atomic operations only. A file is only freed once no handler is running
+ * anymore, since a handler might still be looking at it.
+ */
+
+/* Files mapped beyond this number are read without memory mapping. */
+#  define MMAP_MAX_OPEN_FILES 64
+
+static struct error_handler_data {
+  /* Mapped files, empty slots are null. Only changed while holding the mutex. */
+  BLI_mmap_file *open_mmaps[MMAP_MAX_OPEN_FILES];
+  /* Number of signal handlers that are currently looking at the mapped files. */
+  int32_t handlers_running;
+  ThreadMutex mutex;
+  char configured;
+  void (*next_handler)(int, siginfo_t *, void *);
+} error_handler = {.mutex = BLI_MUTEX_INITIALIZER};
+
+/* Only async-signal-safe functions can be used in the handler. */
+static void sigbus_handler_print(const char *message)
+{
+  const ssize_t written = write(STDERR_FILENO, message, strlen(message));
+  UNUSED_VARS(written);
+}
+
+static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
+{
+  /* We only handle SIGBUS here for now. */
+  BLI_assert(sig == SIGBUS);
+
+  atomic_add_and_fetch_int32(&error_handler.handlers_running, 1);
+
+  char *error_addr = (char *)siginfo->si_addr;
+  /* Find the file that this error belongs to. */
+  for (int i = 0; i < MMAP_MAX_OPEN_FILES; i++) {
+    /* Atomic read of the slot. */
+    BLI_mmap_file *file = atomic_cas_ptr((void **)&error_handler.open_mmaps[i], NULL, NULL);
+    if (file == NULL) {
+      continue;
+    }
+
+    /* Is the address where the error occurred in this file's mapped range? */
+    if (error_addr >= file->memory && error_addr < file->memory + file->length) {
+      file->io_error = true;
+
+      /* Replace the mapped memory with zeroes. */
+      const void *mapped_memory = mmap(
+          file->memory, file->length, PROT_READ, MAP_FIXED | MAP_PRIVATE | MAP_ANON, -1, 0);
+      if (mapped_memory == MAP_FAILED) {
+        sigbus_handler_print("SIGBUS handler: Error replacing mapped file with zeros\n");
+      }
+
+      atomic_sub_and_fetch_int32(&error_handler.handlers_running, 1);
+      return;
+    }
+  }
+
+  atomic_sub_and_fetch_int32(&error_handler.handlers_running, 1);
+
+  /* Fall back to other handler if there was one. */
+  if (error_handler.next_handler) {
+    error_handler.next_handler(sig, siginfo, ptr);
+  }
+  else {
+    sigbus_handler_print("Unhandled SIGBUS caught\n");
+    abort();
+  }
+}
+
+/* Ensures that the error handler is set up and ready. Must be called with the mutex locked. */
+static bool sigbus_handler_setup(void)
+{
+  if (!error_handler.configured) {
+    struct sigaction newact = {0}, oldact = {0};
+
+    newact.sa_sigaction = sigbus_handler;
+    newact.sa_flags = SA_SIGINFO;
+
+    if (sigaction(SIGBUS, &newact, &oldact)) {
+      return false;
+    }
+
+    /* Remember the previously configured handler to fall back to it if the error
+     * does not belong to any of the mapped files. */
+    if (oldact.sa_flags & SA_SIGINFO) {
+      error_handler.next_handler = oldact.sa_sigaction;
+    }
+
+    error_handler.configured = 1;
+  }
+
+  return true;
+}
+
+/* Adds a file to the table that the error handler checks.
+ * Returns false when the handler can't be set up or all slots are in use. */
+static bool sigbus_handler_add(BLI_mmap_file *file)
+{
+  bool added = false;
+  BLI_mutex_lock(&error_handler.mutex);
+  if (sigbus_handler_setup()) {
+    for (int i = 0; i < MMAP_MAX_OPEN_FILES; i++) {
+      if (error_handler.open_mmaps[i] == NULL) {
+        atomic_cas_ptr((void **)&error_handler.open_mmaps[i], NULL, file);
+        added = true;
+        break;
+      }
+    }
+  }
+  BLI_mutex_unlock(&error_handler.mutex);
+  return added;
+}
+
+/* Removes a file from the table that the error handler checks. When this returns, no signal
+ * handler is accessing the file anymore. */
+static void sigbus_handler_remove(BLI_mmap_file *file)
+{
+  BLI_mutex_lock(&error_handler.mutex);
+  for (int i = 0; i < MMAP_MAX_OPEN_FILES; i++) {
+    if (error_handler.open_mmaps[i] == file) {
+      atomic_cas_ptr((void **)&error_handler.open_mmaps[i], file, NULL);
+      break;
+    }
+  }
+  BLI_mutex_unlock(&error_handler.mutex);
+
+  /* A handler that started before the file was removed might still be reading it. */
+  while (atomic_fetch_and_add_int32(&error_handler.handlers_running, 0) != 0) {
+    sched_yield();
+  }
+}
+#endif
+
+BLI_mmap_file *BLI_mmap_open(int fd)
+{
+  void *memory, *handle = NULL;
+  size_t length = (size_t)BLI_lseek(fd, 0, SEEK_END);
+
+  /* Mapping an empty file is not allowed on all platforms. */
+  if (length == 0 || length == (size_t)-1) {
+    return NULL;
+  }
+
+#ifndef WIN32
+  /* Map the given file to memory. */
+  memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (memory == MAP_FAILED) {
+    return NULL;
+  }
+#else
+  /* Convert the POSIX-style file descriptor to a Windows handle. */
+  void *file_handle = (void *)_get_osfhandle(fd);
+  /* Errors while accessing the mapped memory raise an exception, which is only handled by
+   * #BLI_mmap_read. Memory read through #BLI_mmap_get_pointer is not guarded, so don't map files
+   * on network drives, where the connection can be lost while reading. Getting the remote
+   * protocol info only succeeds for remote files. */
+  FILE_REMOTE_PROTOCOL_INFO remote_info;
+  if (GetFileInformationByHandleEx(
+          file_handle, FileRemoteProtocolInfo, &remote_info, sizeof(remote_info))) {
+    return NULL;
+  }
+  /* Memory mapping fails with zero length files, checked above. */
+  handle = CreateFileMapping(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (handle == NULL) {
+    return NULL;
+  }
+  memory = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+  if (memory == NULL) {
+    CloseHandle(handle);
+    return NULL;
+  }
+#endif
+
+  /* Now that the mapping was successful, allocate memory and set up the BLI_mmap_file. */
+  BLI_mmap_file *file = MEM_callocN(sizeof(BLI_mmap_file), __func__);
+  file->memory = memory;
+  file->handle = handle;
+  file->length = length;
+
+#ifndef WIN32
+  /* Register the file with the error handler. */
+  if (!sigbus_handler_add(file)) {
+    munmap(memory, length);
+    MEM_freeN(file);
+    return NULL;
+  }
+#endif
+
+  return file;
+}
+
+bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
+{
+  /* If a previous read has already failed or we try to read past the end,
+   * don't even attempt to read any further. */
+  if (file->io_error || (offset + length > file->length) || (offset + length < offset)) {
+    return false;
+  }
+
+#ifndef WIN32
+  /* If an error occurs in this call, sigbus_handler will be called and will set
+   * file->io_error to true. */
+  memcpy(dest, file->memory + offset, length);
+#else
+  /* On Windows, we use exception handling to be notified of errors. */
+  __try {
+    memcpy(dest, file->memory + offset, length);
+  }
+  __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER :
+                                                            EXCEPTION_CONTINUE_SEARCH) {
+    file->io_error = true;
+    return false;
+  }
+#endif
+
+  return !file->io_error;
+}
+
+void *BLI_mmap_get_pointer(BLI_mmap_file *file)
+{
+  return file->memory;
+}
+
+size_t BLI_mmap_get_length(const BLI_mmap_file *file)
+{
+  return file->length;
+}
+
+bool BLI_mmap_any_io_error(const BLI_mmap_file *file)
+{
+  return file->io_error;
+}
+
+void BLI_mmap_free(BLI_mmap_file *file)
+{
+#ifndef WIN32
+  sigbus_handler_remove(file);
+  munmap((void *)file->memory, file->length);
+#else
+  UnmapViewOfFile(file->memory);
+  CloseHandle(file->handle);
+#endif
+
+  MEM_freeN(file);
+}
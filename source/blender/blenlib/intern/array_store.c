@@ -1628,6 +1628,36 @@ size_t BLI_array_store_state_size_get(BArrayState *state)
   return state->chunk_list->total_size;
 }
 
+/**
+ * Fast check if both states store the same data, only comparing the chunks they reference.
+ *
+ * \note Equal data stored in different chunks (when not added with a reference state)
+ * is reported as different, so a false return value doesn't guarantee the data differs.
+ */
+bool BLI_array_store_state_is_equal(const BArrayState *state_a, const BArrayState *state_b)
+{
+  const BChunkList *chunk_list_a = state_a->chunk_list;
+  const BChunkList *chunk_list_b = state_b->chunk_list;
+  if (chunk_list_a == chunk_list_b) {
+    return true;
+  }
+  if ((chunk_list_a->total_size != chunk_list_b->total_size) ||
+      (chunk_list_a->chunk_refs_len != chunk_list_b->chunk_refs_len)) {
+    return false;
+  }
+
+  const BChunkRef *cref_a = chunk_list_a->chunk_refs.first;
+  const BChunkRef *cref_b = chunk_list_b->chunk_refs.first;
+  while (cref_a && cref_b) {
+    if (cref_a->link != cref_b->link) {
+      return false;
+    }
+    cref_a = cref_a->next;
+    cref_b = cref_b->next;
+  }
+  return (cref_a == NULL) && (cref_b == NULL);
+}
+
 /**
  * Fill in existing allocated memory with the contents of \a state.
  */
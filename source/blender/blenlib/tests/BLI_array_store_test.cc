@@ -359,6 +359,24 @@ TEST(array_store, DoubleNop)
   BLI_array_store_destroy(bs);
 }
 
+TEST(array_store, StateIsEqual)
+{
+  BArrayStore *bs = BLI_array_store_create(1, 4);
+  const char data_src_a[] = "test data for equality";
+  const char data_src_b[] = "test data for Equality";
+
+  BArrayState *state_a = BLI_array_store_state_add(bs, data_src_a, sizeof(data_src_a), nullptr);
+  BArrayState *state_b = BLI_array_store_state_add(bs, data_src_a, sizeof(data_src_a), state_a);
+  BArrayState *state_c = BLI_array_store_state_add(bs, data_src_b, sizeof(data_src_b), state_a);
+
+  EXPECT_TRUE(BLI_array_store_state_is_equal(state_a, state_a));
+  EXPECT_TRUE(BLI_array_store_state_is_equal(state_a, state_b));
+  EXPECT_FALSE(BLI_array_store_state_is_equal(state_a, state_c));
+  EXPECT_FALSE(BLI_array_store_state_is_equal(state_c, state_b));
+
+  BLI_array_store_destroy(bs);
+}
+
 TEST(array_store, DoubleDiff)
 {
   BArrayStore *bs = BLI_array_store_create(1, 32);
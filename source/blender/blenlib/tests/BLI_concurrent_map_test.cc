@@ -0,0 +1,165 @@
+/* Apache License, Version 2.0 */
+
+#include "BLI_concurrent_map.hh"
+#include "BLI_strict_flags.h"
+#include "BLI_vector.hh"
+#include "testing/testing.h"
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace blender::tests {
+
+TEST(concurrent_map, Empty)
+{
+  ConcurrentMap<int, float> map(10);
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_TRUE(map.is_empty());
+  EXPECT_EQ(map.max_size(), 10);
+  EXPECT_FALSE(map.contains(3));
+  EXPECT_EQ(map.lookup_ptr(3), nullptr);
+}
+
+TEST(concurrent_map, AddLookup)
+{
+  ConcurrentMap<int, float> map(10);
+  EXPECT_TRUE(map.add(2, 5.0f));
+  EXPECT_TRUE(map.add(6, 2.0f));
+  EXPECT_FALSE(map.add(2, 3.0f));
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(*map.lookup_ptr(2), 5.0f);
+  EXPECT_EQ(*map.lookup_ptr(6), 2.0f);
+  EXPECT_EQ(map.lookup_default(4, 1.0f), 1.0f);
+  EXPECT_TRUE(map.contains(6));
+  EXPECT_FALSE(map.contains(4));
+}
+
+TEST(concurrent_map, LookupOrAddCb)
+{
+  ConcurrentMap<std::string, Vector<int>> map(3);
+  int calls = 0;
+  auto create_value = [&]() {
+    calls++;
+    return Vector<int>({1, 2});
+  };
+  map.lookup_or_add_cb("a", create_value).append(3);
+  map.lookup_or_add_cb("a", create_value).append(4);
+  map.lookup_or_add_cb("b", create_value);
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.lookup_ptr("a")->size(), 4);
+  EXPECT_EQ(map.lookup_ptr("b")->size(), 2);
+}
+
+TEST(concurrent_map, LookupOrAddDefault)
+{
+  ConcurrentMap<int, int> map(4);
+  map.lookup_or_add_default(3) += 2;
+  map.lookup_or_add_default(3) += 2;
+  EXPECT_EQ(*map.lookup_ptr(3), 4);
+}
+
+TEST(concurrent_map, AddMaxSize)
+{
+  ConcurrentMap<int, int> map(3);
+  EXPECT_TRUE(map.add(1, 1));
+  EXPECT_TRUE(map.add(2, 2));
+  EXPECT_TRUE(map.add(3, 3));
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map.size(), map.max_size());
+  /* Existing keys can still be added and looked up in a full map. */
+  EXPECT_FALSE(map.add(2, 4));
+  EXPECT_EQ(map.lookup_default(2, 0), 2);
+  EXPECT_FALSE(map.contains(4));
+}
+
+TEST(concurrent_map, CreateValueThrows)
+{
+  ConcurrentMap<int, int> map(4);
+  EXPECT_ANY_THROW({ map.lookup_or_add_cb(5, []() -> int { throw std::runtime_error(""); }); });
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_FALSE(map.contains(5));
+
+  /* The key can be added afterwards. */
+  EXPECT_EQ(map.lookup_or_add_cb(5, []() { return 3; }), 3);
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map.lookup_default(5, 0), 3);
+}
+
+TEST(concurrent_map, ForeachItem)
+{
+  ConcurrentMap<int, int> map(1000);
+  for (int i = 0; i < 1000; i++) {
+    map.add(i, i * 2);
+  }
+  int64_t key_sum = 0;
+  int64_t value_sum = 0;
+  map.foreach_item([&](const int key, const int value) {
+    key_sum += key;
+    value_sum += value;
+  });
+  EXPECT_EQ(key_sum, 499500);
+  EXPECT_EQ(value_sum, 999000);
+}
+
+TEST(concurrent_map, AddFromThreads)
+{
+  const int num_threads = 8;
+  const int num_keys = 10000;
+  ConcurrentMap<int, int> map(num_keys);
+  std::atomic<int> added = 0;
+
+  /* Every thread adds all keys, only one of them should succeed for every key. */
+  Vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < num_threads; thread_index++) {
+    threads.append(std::thread([&, thread_index]() {
+      for (int i = 0; i < num_keys; i++) {
+        const int key = (i * 7 + thread_index * 101) % num_keys;
+        if (map.add(key, key + 1)) {
+          added++;
+        }
+      }
+    }));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(added, num_keys);
+  EXPECT_EQ(map.size(), num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_EQ(map.lookup_default(i, 0), i + 1);
+  }
+}
+
+TEST(concurrent_map, LookupOrAddCbFromThreads)
+{
+  const int num_threads = 8;
+  const int num_keys = 1000;
+  ConcurrentMap<int, std::atomic<int>> map(num_keys);
+  std::atomic<int> calls = 0;
+
+  Vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < num_threads; thread_index++) {
+    threads.append(std::thread([&]() {
+      for (int i = 0; i < num_keys; i++) {
+        std::atomic<int> &counter = map.lookup_or_add_cb(i, [&]() {
+          calls++;
+          return 0;
+        });
+        counter++;
+      }
+    }));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(calls, num_keys);
+  map.foreach_item([&](const int /*key*/, const std::atomic<int> &counter) {
+    EXPECT_EQ(counter, num_threads);
+  });
+}
+
+}  // namespace blender::tests
@@ -0,0 +1,141 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "BLI_mmap.h"
+#include "BLI_vector.hh"
+
+#ifndef WIN32
+#  include <unistd.h>
+#endif
+
+/* Write the given data to a temporary file, which is deleted when it is closed. */
+static FILE *mmap_test_file_create(const void *data, const size_t length)
+{
+  FILE *stream = tmpfile();
+  if (stream != nullptr) {
+    EXPECT_EQ(fwrite(data, 1, length, stream), length);
+    fflush(stream);
+  }
+  return stream;
+}
+
+TEST(mmap, OpenReadClose)
+{
+  const char data[] = "memory mapped file contents";
+  FILE *stream = mmap_test_file_create(data, sizeof(data));
+  ASSERT_NE(stream, nullptr);
+
+  BLI_mmap_file *file = BLI_mmap_open(fileno(stream));
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(BLI_mmap_get_length(file), sizeof(data));
+
+  char buffer[sizeof(data)];
+  EXPECT_TRUE(BLI_mmap_read(file, buffer, 0, sizeof(data)));
+  EXPECT_STREQ(buffer, data);
+
+  /* Read from an offset in the file. */
+  EXPECT_TRUE(BLI_mmap_read(file, buffer, 7, 6));
+  EXPECT_EQ(memcmp(buffer, "mapped", 6), 0);
+
+  /* The pointer gives access to the same data. */
+  EXPECT_EQ(memcmp(BLI_mmap_get_pointer(file), data, sizeof(data)), 0);
+  EXPECT_FALSE(BLI_mmap_any_io_error(file));
+
+  BLI_mmap_free(file);
+  fclose(stream);
+}
+
+TEST(mmap, ReadOutOfRange)
+{
+  const char data[] = "0123456789";
+  FILE *stream = mmap_test_file_create(data, sizeof(data));
+  ASSERT_NE(stream, nullptr);
+
+  BLI_mmap_file *file = BLI_mmap_open(fileno(stream));
+  ASSERT_NE(file, nullptr);
+
+  char buffer[32];
+  /* Reading up to the end is allowed, reading past it is not. */
+  EXPECT_TRUE(BLI_mmap_read(file, buffer, sizeof(data) - 1, 1));
+  EXPECT_FALSE(BLI_mmap_read(file, buffer, sizeof(data) - 1, 2));
+  EXPECT_FALSE(BLI_mmap_read(file, buffer, 0, sizeof(buffer)));
+  EXPECT_FALSE(BLI_mmap_read(file, buffer, sizeof(data) + 1, 0));
+  /* Offsets that overflow when the length is added. */
+  EXPECT_FALSE(BLI_mmap_read(file, buffer, SIZE_MAX, 2));
+
+  /* Failed reads are not IO errors, the file can still be read. */
+  EXPECT_FALSE(BLI_mmap_any_io_error(file));
+  EXPECT_TRUE(BLI_mmap_read(file, buffer, 0, sizeof(data)));
+  EXPECT_STREQ(buffer, data);
+
+  BLI_mmap_free(file);
+  fclose(stream);
+}
+
+TEST(mmap, OpenEmptyFile)
+{
+  FILE *stream = tmpfile();
+  ASSERT_NE(stream, nullptr);
+
+  /* Empty files can't be mapped. */
+  EXPECT_EQ(BLI_mmap_open(fileno(stream)), nullptr);
+
+  fclose(stream);
+}
+
+TEST(mmap, OpenFromMultipleThreads)
+{
+  const char data[] = "memory mapped file contents";
+  FILE *stream = mmap_test_file_create(data, sizeof(data));
+  ASSERT_NE(stream, nullptr);
+
+  /* Files are mapped and freed concurrently, each thread checks the files it mapped. */
+  blender::Vector<std::thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.append(std::thread([&]() {
+      for (int j = 0; j < 200; j++) {
+        BLI_mmap_file *file = BLI_mmap_open(fileno(stream));
+        if (file == nullptr) {
+          /* All slots may be used by other threads. */
+          continue;
+        }
+        char buffer[sizeof(data)];
+        EXPECT_TRUE(BLI_mmap_read(file, buffer, 0, sizeof(data)));
+        EXPECT_STREQ(buffer, data);
+        BLI_mmap_free(file);
+      }
+    }));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  fclose(stream);
+}
+
+#ifndef WIN32
+TEST(mmap, TruncatedFileIsIOError)
+{
+  const std::string data(1 << 16, 'x');
+  FILE *stream = mmap_test_file_create(data.data(), data.size());
+  ASSERT_NE(stream, nullptr);
+
+  BLI_mmap_file *file = BLI_mmap_open(fileno(stream));
+  ASSERT_NE(file, nullptr);
+
+  /* Reading pages of the mapping that are no longer part of the file raises SIGBUS. */
+  EXPECT_EQ(ftruncate(fileno(stream), 0), 0);
+  char buffer[16];
+  EXPECT_FALSE(BLI_mmap_read(file, buffer, data.size() / 2, sizeof(buffer)));
+  EXPECT_TRUE(BLI_mmap_any_io_error(file));
+
+  BLI_mmap_free(file);
+  fclose(stream);
+}
+#endif
@@ -0,0 +1,94 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <mutex>
+
+#include "BLI_concurrent_map.hh"
+#include "BLI_map.hh"
+#include "BLI_rand.hh"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
+#include "BLI_vector.hh"
+
+/* Compare filling a lookup table from multiple threads with different strategies. Every key is
+ * added several times, like vertex positions of a mesh shared by multiple faces. */
+
+namespace blender::tests {
+
+static Vector<int> random_keys(const int amount, const int duplicates)
+{
+  RandomNumberGenerator rng(0);
+  Vector<int> keys;
+  keys.reserve(amount * duplicates);
+  for (int i = 0; i < amount * duplicates; i++) {
+    keys.append(static_cast<int>(rng.get_uint32() % static_cast<uint32_t>(amount)));
+  }
+  return keys;
+}
+
+static void concurrent_map_performance(const int amount, const int duplicates)
+{
+  const Vector<int> keys = random_keys(amount, duplicates);
+  const int64_t grain_size = 4096;
+  printf("\n%d keys, each added about %d times:\n", amount, duplicates);
+
+  {
+    SCOPED_TIMER("Map, single thread          ");
+    Map<int, int> map;
+    for (const int key : keys) {
+      map.add(key, key);
+    }
+  }
+  {
+    SCOPED_TIMER("Map, locked by a mutex      ");
+    Map<int, int> map;
+    std::mutex mutex;
+    parallel_for(keys.index_range(), grain_size, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        std::lock_guard lock{mutex};
+        map.add(keys[i], keys[i]);
+      }
+    });
+  }
+  {
+    SCOPED_TIMER("Map, merged from threads    ");
+    Vector<Map<int, int>> thread_maps;
+    std::mutex mutex;
+    parallel_for(keys.index_range(), grain_size * 16, [&](const IndexRange range) {
+      Map<int, int> thread_map;
+      for (const int64_t i : range) {
+        thread_map.add(keys[i], keys[i]);
+      }
+      std::lock_guard lock{mutex};
+      thread_maps.append(std::move(thread_map));
+    });
+    Map<int, int> map;
+    for (const Map<int, int> &thread_map : thread_maps) {
+      for (const auto item : thread_map.items()) {
+        map.add(item.key, item.value);
+      }
+    }
+  }
+  {
+    SCOPED_TIMER("ConcurrentMap               ");
+    ConcurrentMap<int, int> map(amount);
+    parallel_for(keys.index_range(), grain_size, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        map.add(keys[i], keys[i]);
+      }
+    });
+  }
+}
+
+TEST(concurrent_map, Performance100000)
+{
+  concurrent_map_performance(100000, 4);
+}
+
+TEST(concurrent_map, Performance10000000)
+{
+  concurrent_map_performance(10000000, 4);
+}
+
+}  // namespace blender::tests
@@ -24,14 +24,20 @@
  * \ingroup blenloader
  */
 
+struct BArrayState;
 struct GHash;
 struct Scene;
 
 typedef struct {
   void *next, *prev;
+  /** NULL when the data is stored in #array_state. */
   const char *buf;
   /** Size in bytes. */
   size_t size;
+  /** Big chunks are de-duplicated in a shared array store, always owned by this chunk. */
+  struct BArrayState *array_state;
+  /** Hash of the whole content, used to find identical states of previous steps. */
+  uint array_hash;
   /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
@@ -57,6 +63,10 @@ typedef struct MemFileWriteData {
 
   /** Maps an ID session uuid to its first reference MemFileChunk, if existing. */
   struct GHash *id_session_uuid_mapping;
+
+  /** Big chunks that are added to the array store in the background, see #BLO_memfile_wait. */
+  struct MemFileDeferredChunk *deferred_chunks;
+  size_t deferred_chunks_len, deferred_chunks_alloc;
 } MemFileWriteData;
 
 typedef struct MemFileUndoData {
@@ -73,11 +83,13 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data);
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size);
+char *BLO_memfile_chunk_data_alloc(const MemFileChunk *chunk);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
 extern void BLO_memfile_clear_future(MemFile *memfile);
+extern void BLO_memfile_wait(void);
 
 /* utilities */
 extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
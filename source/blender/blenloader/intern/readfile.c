@@ -68,6 +68,8 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_mmap.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BLT_translation.h"
@@ -204,6 +206,11 @@ typedef struct BHeadN {
   bool has_data;
 #endif
   bool is_memchunk_identical;
+  /** The data was already switched to the endianness of this platform (in place). */
+  bool is_endian_switched;
+  /** Converted data computed in parallel for all blocks of an ID by #read_file_convert_structs,
+   * handed over (and cleared) by the first #read_struct call. */
+  void *converted_data;
   struct BHead bhead;
 } BHeadN;
 
@@ -816,6 +823,8 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->file_offset = fd->file_offset;
           new_bhead->has_data = false;
           new_bhead->is_memchunk_identical = false;
+          new_bhead->is_endian_switched = false;
+          new_bhead->converted_data = NULL;
           new_bhead->bhead = bhead;
           off64_t seek_new = fd->seek(fd, bhead.len, SEEK_CUR);
           if (seek_new == -1) {
@@ -839,6 +848,8 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->has_data = true;
 #endif
           new_bhead->is_memchunk_identical = false;
+          new_bhead->is_endian_switched = false;
+          new_bhead->converted_data = NULL;
           new_bhead->bhead = bhead;
 
           readsize = fd->read(
@@ -951,6 +962,8 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   new_bhead_data->file_offset = new_bhead->file_offset;
   new_bhead_data->has_data = true;
   new_bhead_data->is_memchunk_identical = false;
+  new_bhead_data->is_endian_switched = false;
+  new_bhead_data->converted_data = NULL;
   if (!blo_bhead_read_data(fd, thisblock, new_bhead_data + 1)) {
     MEM_freeN(new_bhead_data);
     return NULL;
@@ -1160,6 +1173,287 @@ static ssize_t fd_read_gzip_from_file(FileData *filedata,
   return readsize;
 }
 
+/* Block compressed GZip file reading, see #BLEND_GZIP_BLOCK_SIZE. */
+
+typedef struct GzipBlock {
+  /** Offset of the gzip member in the file and its total size. */
+  off64_t offset;
+  size_t size;
+  /** Decompressed data, points into #GzipBlockReader.raw while the block is in the batch. */
+  char *raw;
+  size_t raw_len;
+  bool error;
+} GzipBlock;
+
+typedef struct GzipBlockReader {
+  GzipBlock *blocks;
+  int blocks_len;
+  /** Number of blocks that are decompressed in parallel. */
+  int batch_len;
+  /** First block of the next batch. */
+  int block_next;
+
+  /** Compressed data of the current batch. */
+  char *compressed;
+  size_t compressed_alloc;
+  /** Decompressed data of the current batch. */
+  char *raw;
+  size_t raw_alloc;
+  size_t raw_len;
+  size_t raw_offset;
+
+  bool error;
+} GzipBlockReader;
+
+static uint read_u16_le(const uchar *buf)
+{
+  return (uint)buf[0] | ((uint)buf[1] << 8);
+}
+
+static uint read_u32_le(const uchar *buf)
+{
+  return read_u16_le(buf) | (read_u16_le(buf + 2) << 16);
+}
+
+static bool gzip_block_header_is_valid(const uchar header[BLEND_GZIP_HEADER_SIZE])
+{
+  /* Only members written by #BLO_write_file are accepted: deflate with only FEXTRA set,
+   * containing just the sub-field with the member size. */
+  return (header[0] == 0x1f && header[1] == 0x8b && header[2] == Z_DEFLATED &&
+          header[3] == 0x04 && read_u16_le(header + 10) == 8 &&
+          header[12] == BLEND_GZIP_SUBFIELD_ID1 && header[13] == BLEND_GZIP_SUBFIELD_ID2 &&
+          read_u16_le(header + 14) == 4);
+}
+
+static void gzip_blocks_reader_free(GzipBlockReader *reader)
+{
+  MEM_SAFE_FREE(reader->blocks);
+  MEM_SAFE_FREE(reader->compressed);
+  MEM_SAFE_FREE(reader->raw);
+  MEM_freeN(reader);
+}
+
+/**
+ * Find all gzip members of the file by following the sizes stored in their headers.
+ * \return NULL when the file is not block compressed, then it's read as a regular gzip stream.
+ */
+static GzipBlockReader *gzip_blocks_reader_create(int file)
+{
+  const off64_t file_size = (off64_t)BLI_file_descriptor_size(file);
+  GzipBlockReader *reader = MEM_callocN(sizeof(*reader), __func__);
+  int blocks_alloc = 0;
+  off64_t offset = 0;
+
+  while (offset < file_size) {
+    uchar header[BLEND_GZIP_HEADER_SIZE];
+    if ((BLI_lseek(file, offset, SEEK_SET) != offset) ||
+        (read(file, header, sizeof(header)) != sizeof(header)) ||
+        !gzip_block_header_is_valid(header)) {
+      break;
+    }
+    const size_t size = read_u32_le(header + 16);
+    if ((size < BLEND_GZIP_HEADER_SIZE + BLEND_GZIP_TRAILER_SIZE) ||
+        (offset + (off64_t)size > file_size)) {
+      break;
+    }
+
+    if (reader->blocks_len == blocks_alloc) {
+      blocks_alloc = MAX2(blocks_alloc * 2, 64);
+      reader->blocks = MEM_recallocN(reader->blocks, sizeof(*reader->blocks) * blocks_alloc);
+    }
+    GzipBlock *block = &reader->blocks[reader->blocks_len++];
+    block->offset = offset;
+    block->size = size;
+    offset += (off64_t)size;
+  }
+
+  BLI_lseek(file, 0, SEEK_SET);
+
+  if (offset != file_size || reader->blocks_len == 0) {
+    gzip_blocks_reader_free(reader);
+    return NULL;
+  }
+
+  reader->batch_len = MAX2(BLI_system_thread_count() * 2, 2);
+  return reader;
+}
+
+typedef struct GzipBlockBatchData {
+  GzipBlockReader *reader;
+  /** Offset in the file of the compressed data of the batch. */
+  off64_t offset;
+} GzipBlockBatchData;
+
+static void gzip_block_decompress_cb(void *__restrict userdata,
+                                     const int index,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const GzipBlockBatchData *data = userdata;
+  GzipBlock *block = &data->reader->blocks[index];
+  const uchar *member = (const uchar *)data->reader->compressed + (block->offset - data->offset);
+  const uchar *trailer = member + block->size - BLEND_GZIP_TRAILER_SIZE;
+  z_stream strm = {NULL};
+
+  if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+    block->error = true;
+    return;
+  }
+  strm.next_in = (Bytef *)(member + BLEND_GZIP_HEADER_SIZE);
+  strm.avail_in = (uInt)(block->size - BLEND_GZIP_HEADER_SIZE - BLEND_GZIP_TRAILER_SIZE);
+  strm.next_out = (Bytef *)block->raw;
+  strm.avail_out = (uInt)block->raw_len;
+
+  block->error = (inflate(&strm, Z_FINISH) != Z_STREAM_END) || (strm.total_out != block->raw_len);
+  inflateEnd(&strm);
+
+  if (!block->error) {
+    const uint crc = (uint)crc32(0, (const Bytef *)block->raw, (uInt)block->raw_len);
+    block->error = (crc != read_u32_le(trailer));
+  }
+}
+
+/**
+ * Read and decompress the next batch of blocks in parallel.
+ * \return false at the end of the file or on errors.
+ */
+static bool gzip_blocks_read_batch(GzipBlockReader *reader, int file)
+{
+  if (reader->error || reader->block_next == reader->blocks_len) {
+    return false;
+  }
+
+  const int block_first = reader->block_next;
+  const int block_end = MIN2(block_first + reader->batch_len, reader->blocks_len);
+  const GzipBlock *block_last = &reader->blocks[block_end - 1];
+  const off64_t offset = reader->blocks[block_first].offset;
+  const size_t compressed_len = (size_t)(block_last->offset - offset) + block_last->size;
+
+  if (compressed_len > reader->compressed_alloc) {
+    MEM_SAFE_FREE(reader->compressed);
+    reader->compressed = MEM_mallocN(compressed_len, __func__);
+    reader->compressed_alloc = compressed_len;
+  }
+  if ((BLI_lseek(file, offset, SEEK_SET) != offset) ||
+      (read(file, reader->compressed, compressed_len) != (ssize_t)compressed_len)) {
+    reader->error = true;
+    return false;
+  }
+
+  /* The uncompressed size of every member is stored at its end. It is only trusted up to the
+   * block size, the decompressed size is compared with it in #gzip_block_decompress_cb. */
+  size_t raw_len = 0;
+  for (int i = block_first; i < block_end; i++) {
+    GzipBlock *block = &reader->blocks[i];
+    const uchar *member = (const uchar *)reader->compressed + (block->offset - offset);
+    block->raw_len = read_u32_le(member + block->size - 4);
+    if (block->raw_len > BLEND_GZIP_BLOCK_SIZE) {
+      reader->error = true;
+      return false;
+    }
+    raw_len += block->raw_len;
+  }
+  if (raw_len > reader->raw_alloc) {
+    MEM_SAFE_FREE(reader->raw);
+    reader->raw = MEM_mallocN(raw_len, __func__);
+    reader->raw_alloc = raw_len;
+  }
+  char *raw = reader->raw;
+  for (int i = block_first; i < block_end; i++) {
+    reader->blocks[i].raw = raw;
+    raw += reader->blocks[i].raw_len;
+  }
+
+  GzipBlockBatchData data = {reader, offset};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(block_first, block_end, &data, gzip_block_decompress_cb, &settings);
+
+  for (int i = block_first; i < block_end; i++) {
+    if (reader->blocks[i].error) {
+      reader->error = true;
+      return false;
+    }
+  }
+
+  reader->block_next = block_end;
+  reader->raw_len = raw_len;
+  reader->raw_offset = 0;
+  return true;
+}
+
+static ssize_t fd_read_gzip_blocks_from_file(FileData *filedata,
+                                             void *buffer,
+                                             size_t size,
+                                             bool *UNUSED(r_is_memchunck_identical))
+{
+  GzipBlockReader *reader = filedata->gzip_blocks;
+  size_t readsize = 0;
+
+  while (readsize < size) {
+    if (reader->raw_offset == reader->raw_len) {
+      if (!gzip_blocks_read_batch(reader, filedata->filedes)) {
+        if (reader->error) {
+          return EOF;
+        }
+        break;
+      }
+    }
+    const size_t copy_len = MIN2(size - readsize, reader->raw_len - reader->raw_offset);
+    memcpy((char *)buffer + readsize, reader->raw + reader->raw_offset, copy_len);
+    reader->raw_offset += copy_len;
+    readsize += copy_len;
+  }
+
+  filedata->file_offset += (off64_t)readsize;
+  return (ssize_t)readsize;
+}
+
+/* Memory-mapped file reading. */
+
+static ssize_t fd_read_from_mmap(FileData *filedata,
+                                 void *buffer,
+                                 size_t size,
+                                 bool *UNUSED(r_is_memchunck_identical))
+{
+  /* don't read more bytes than there are available in the file */
+  const size_t length = BLI_mmap_get_length(filedata->mmap_file);
+  if ((size_t)filedata->file_offset >= length) {
+    return 0;
+  }
+  size = MIN2(size, length - (size_t)filedata->file_offset);
+
+  if (!BLI_mmap_read(filedata->mmap_file, buffer, (size_t)filedata->file_offset, size)) {
+    return 0;
+  }
+  filedata->file_offset += size;
+
+  return (ssize_t)size;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+  off64_t new_pos;
+  if (whence == SEEK_CUR) {
+    new_pos = filedata->file_offset + offset;
+  }
+  else if (whence == SEEK_SET) {
+    new_pos = offset;
+  }
+  else if (whence == SEEK_END) {
+    new_pos = (off64_t)BLI_mmap_get_length(filedata->mmap_file) + offset;
+  }
+  else {
+    return -1;
+  }
+
+  if (new_pos < 0 || new_pos > (off64_t)BLI_mmap_get_length(filedata->mmap_file)) {
+    return -1;
+  }
+  filedata->file_offset = new_pos;
+  return filedata->file_offset;
+}
+
 /* Memory reading. */
 
 static ssize_t fd_read_from_memory(FileData *filedata,
@@ -1237,7 +1531,18 @@ static ssize_t fd_read_from_memfile(FileData *filedata,
         readsize = chunk->size - chunkoffset;
       }
 
-      memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+      const char *chunk_buf = chunk->buf;
+      if (chunk->array_state != NULL) {
+        /* Expand de-duplicated chunks once, reads are mostly sequential. */
+        if (filedata->memchunk_expanded != chunk) {
+          MEM_SAFE_FREE(filedata->memchunk_expanded_buf);
+          filedata->memchunk_expanded_buf = BLO_memfile_chunk_data_alloc(chunk);
+          filedata->memchunk_expanded = chunk;
+        }
+        chunk_buf = filedata->memchunk_expanded_buf;
+      }
+
+      memcpy(POINTER_OFFSET(buffer, totread), chunk_buf + chunkoffset, readsize);
       totread += readsize;
       filedata->file_offset += readsize;
       seek += readsize;
@@ -1305,6 +1610,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
 
   gzFile gzfile = (gzFile)Z_NULL;
+  GzipBlockReader *gzip_blocks = NULL;
+  BLI_mmap_file *mmap_file = NULL;
 
   char header[7];
 
@@ -1323,8 +1630,28 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   /* Regular file. */
   if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
-    read_fn = fd_read_data_from_file;
-    seek_fn = fd_seek_data_from_file;
+    /* Map the file so blocks are only paged in once they are actually read,
+     * fall back to regular reads when mapping is not possible. */
+    mmap_file = BLI_mmap_open(file);
+    if (mmap_file != NULL) {
+      read_fn = fd_read_from_mmap;
+      seek_fn = fd_seek_from_mmap;
+    }
+    else {
+      BLI_lseek(file, 0, SEEK_SET);
+      read_fn = fd_read_data_from_file;
+      seek_fn = fd_seek_data_from_file;
+    }
+  }
+
+  /* Block compressed gzip file. */
+  if ((read_fn == NULL) &&
+      /* Check header magic. */
+      (header[0] == 0x1f && header[1] == 0x8b)) {
+    gzip_blocks = gzip_blocks_reader_create(file);
+    if (gzip_blocks != NULL) {
+      read_fn = fd_read_gzip_blocks_from_file;
+    }
   }
 
   /* Gzip file. */
@@ -1357,6 +1684,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   fd->filedes = file;
   fd->gzfiledes = gzfile;
+  fd->gzip_blocks = gzip_blocks;
+  fd->mmap_file = mmap_file;
 
   fd->read = read_fn;
   fd->seek = seek_fn;
@@ -1427,8 +1756,19 @@ static ssize_t fd_read_gzip_from_memory(FileData *filedata,
   /* Inflate another chunk. */
   err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
+  /* Compressed files consist of multiple gzip members, continue with the next one. */
+  while (err == Z_STREAM_END && filedata->strm.avail_in != 0 && filedata->strm.avail_out != 0) {
+    if (inflateReset(&filedata->strm) != Z_OK) {
+      break;
+    }
+    err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+  }
+
   if (err == Z_STREAM_END) {
-    return 0;
+    /* End of the last member, only return what was decompressed. */
+    const size_t readsize = size - filedata->strm.avail_out;
+    filedata->file_offset += (off64_t)readsize;
+    return (ssize_t)readsize;
   }
   if (err != Z_OK) {
     printf("fd_read_gzip_from_memory: zlib error\n");
@@ -1496,6 +1836,9 @@ FileData *blo_filedata_from_memfile(MemFile *memfile,
     return NULL;
   }
 
+  /* The chunks of the last undo step may still be de-duplicated in the background. */
+  BLO_memfile_wait();
+
   FileData *fd = filedata_new();
   fd->memfile = memfile;
   fd->undo_direction = params->undo_direction;
@@ -1517,18 +1860,34 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->gzip_blocks != NULL) {
+      gzip_blocks_reader_free(fd->gzip_blocks);
+    }
+
+    if (fd->mmap_file != NULL) {
+      BLI_mmap_free(fd->mmap_file);
+    }
+
     if (fd->strm.next_in) {
       if (inflateEnd(&fd->strm) != Z_OK) {
         printf("close gzip stream error\n");
       }
     }
 
+    if (fd->memchunk_expanded_buf != NULL) {
+      MEM_freeN(fd->memchunk_expanded_buf);
+    }
+
     if (fd->buffer && !(fd->flags & FD_FLAGS_NOT_MY_BUFFER)) {
       MEM_freeN((void *)fd->buffer);
       fd->buffer = NULL;
     }
 
     /* Free all BHeadN data blocks */
+    LISTBASE_FOREACH (BHeadN *, new_bhead, &fd->bhead_list) {
+      /* Converted ahead of time but never read. */
+      MEM_SAFE_FREE(new_bhead->converted_data);
+    }
 #ifndef NDEBUG
     BLI_freelistN(&fd->bhead_list);
 #else
@@ -2067,12 +2426,10 @@ void blo_cache_storage_end(FileData *fd)
 /** \name DNA Struct Loading
  * \{ */
 
-static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
+static void switch_endian_structs(const struct SDNA *filesdna, const BHead *bhead, char *data)
 {
   int blocksize, nblocks;
-  char *data;
 
-  data = (char *)(bhead + 1);
   blocksize = filesdna->types_size[filesdna->structs[bhead->SDNAnr]->type];
 
   nblocks = bhead->nr;
@@ -2083,6 +2440,29 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
   }
 }
 
+#ifdef USE_BHEAD_READ_ON_DEMAND
+/* Reconstruct the (not yet loaded) data of a block directly from the memory-mapped file. */
+static void *read_struct_reconstruct_from_mmap(FileData *fd, BHead *bh)
+{
+  const BHeadN *bhead_n = BHEADN_FROM_BHEAD(bh);
+  const size_t offset = (size_t)bhead_n->file_offset;
+  if (offset + (size_t)bh->len > BLI_mmap_get_length(fd->mmap_file) ||
+      BLI_mmap_any_io_error(fd->mmap_file)) {
+    return NULL;
+  }
+
+  const char *data = (const char *)BLI_mmap_get_pointer(fd->mmap_file) + offset;
+  void *temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, data);
+
+  /* Reading the mapped memory may have failed, the data read is zeroes in that case. */
+  if (UNLIKELY(BLI_mmap_any_io_error(fd->mmap_file))) {
+    MEM_freeN(temp);
+    return NULL;
+  }
+  return temp;
+}
+#endif
+
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 {
   void *temp = NULL;
@@ -2092,8 +2472,16 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
     BHead *bh_orig = bh;
 #endif
 
+    /* Already converted by #read_file_convert_structs. */
+    BHeadN *bhead_n = BHEADN_FROM_BHEAD(bh);
+    if (bhead_n->converted_data != NULL) {
+      temp = bhead_n->converted_data;
+      bhead_n->converted_data = NULL;
+      return temp;
+    }
+
     /* switch is based on file dna */
-    if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN)) {
+    if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN) && !bhead_n->is_endian_switched) {
 #ifdef USE_BHEAD_READ_ON_DEMAND
       if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
         bh = blo_bhead_read_full(fd, bh);
@@ -2103,13 +2491,22 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
         }
       }
 #endif
-      switch_endian_structs(fd->filesdna, bh);
+      switch_endian_structs(fd->filesdna, bh, (char *)(bh + 1));
+      BHEADN_FROM_BHEAD(bh)->is_endian_switched = true;
     }
 
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
+          if (fd->mmap_file != NULL) {
+            /* Reconstruct straight from the mapped file, avoiding a temporary copy. */
+            temp = read_struct_reconstruct_from_mmap(fd, bh);
+            if (UNLIKELY(temp == NULL)) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+            }
+            return temp;
+          }
           bh = blo_bhead_read_full(fd, bh);
           if (UNLIKELY(bh == NULL)) {
             fd->flags &= ~FD_FLAGS_FILE_OK;
@@ -2151,6 +2548,136 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
   return temp;
 }
 
+/* Parallel DNA conversion of the data blocks of an ID, ahead of reading them.
+ * The conversion tables (#FileData.reconstruct_info) are shared by all blocks. */
+
+typedef struct ConvertStructsData {
+  FileData *fd;
+  BHeadN **bheads;
+} ConvertStructsData;
+
+static bool read_file_struct_needs_conversion(const FileData *fd, const BHead *bh)
+{
+  if (bh->len == 0 || fd->compflags[bh->SDNAnr] == SDNA_CMP_REMOVED) {
+    return false;
+  }
+  if (!BHEADN_FROM_BHEAD(bh)->has_data && fd->mmap_file == NULL) {
+    /* Reading the block from other threads is only possible for memory-mapped files, the block
+     * is converted by #read_struct instead. */
+    return false;
+  }
+  return (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) ||
+         (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN));
+}
+
+static void read_file_convert_structs_cb(void *__restrict userdata,
+                                         const int index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ConvertStructsData *data = userdata;
+  FileData *fd = data->fd;
+  BHeadN *bhead_n = data->bheads[index];
+  const BHead *bh = &bhead_n->bhead;
+
+  const bool do_endian_swap = bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN);
+  const bool do_reconstruct = fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL;
+
+  if (bhead_n->has_data) {
+    char *bh_data = (char *)(bh + 1);
+    if (do_endian_swap) {
+      switch_endian_structs(fd->filesdna, bh, bh_data);
+      bhead_n->is_endian_switched = true;
+    }
+    if (do_reconstruct) {
+      bhead_n->converted_data = DNA_struct_reconstruct(
+          fd->reconstruct_info, bh->SDNAnr, bh->nr, bh_data);
+    }
+    return;
+  }
+
+  /* Not read yet, only memory-mapped files get here, see #read_file_struct_needs_conversion. */
+  BLI_assert(fd->mmap_file != NULL);
+  const size_t offset = (size_t)bhead_n->file_offset;
+  void *converted = NULL;
+  if (do_endian_swap) {
+    char *bh_data = MEM_mallocN((size_t)bh->len, __func__);
+    if (!BLI_mmap_read(fd->mmap_file, bh_data, offset, (size_t)bh->len)) {
+      MEM_freeN(bh_data);
+      return;
+    }
+    switch_endian_structs(fd->filesdna, bh, bh_data);
+    if (do_reconstruct) {
+      converted = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, bh_data);
+      MEM_freeN(bh_data);
+    }
+    else {
+      converted = bh_data;
+    }
+  }
+  else {
+    if (offset + (size_t)bh->len > BLI_mmap_get_length(fd->mmap_file)) {
+      return;
+    }
+    const char *bh_data = (const char *)BLI_mmap_get_pointer(fd->mmap_file) + offset;
+    converted = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, bh_data);
+  }
+
+  if (BLI_mmap_any_io_error(fd->mmap_file)) {
+    /* Leave error handling to #read_struct. */
+    MEM_freeN(converted);
+    return;
+  }
+  bhead_n->converted_data = converted;
+}
+
+/* Below this amount of data, converting the blocks in #read_struct is faster than starting
+ * parallel tasks. */
+#define CONVERT_STRUCTS_PARALLEL_MIN_SIZE (64 * 1024)
+
+/**
+ * Convert the data blocks of the ID stored in \a bhead_id in parallel, before #read_struct reads
+ * them one by one. Only the blocks of IDs that are read are converted, so the memory used by the
+ * converted data is only held until the ID has been read, and blocks of IDs that are skipped are
+ * not paged in from memory-mapped files.
+ */
+static void read_file_convert_structs(FileData *fd, BHead *bhead_id)
+{
+  if (fd->filesdna == NULL || fd->compflags == NULL) {
+    return;
+  }
+
+  int bheads_len = 0;
+  size_t bheads_size = 0;
+  for (BHead *bhead = blo_bhead_next(fd, bhead_id); bhead && bhead->code == DATA;
+       bhead = blo_bhead_next(fd, bhead)) {
+    if (read_file_struct_needs_conversion(fd, bhead)) {
+      bheads_len++;
+      bheads_size += (size_t)bhead->len;
+    }
+  }
+  if (bheads_len < 2 || bheads_size < CONVERT_STRUCTS_PARALLEL_MIN_SIZE) {
+    return;
+  }
+
+  BHeadN **bheads = MEM_malloc_arrayN((size_t)bheads_len, sizeof(*bheads), __func__);
+  int i = 0;
+  for (BHead *bhead = blo_bhead_next(fd, bhead_id); bhead && bhead->code == DATA;
+       bhead = blo_bhead_next(fd, bhead)) {
+    if (read_file_struct_needs_conversion(fd, bhead)) {
+      bheads[i++] = BHEADN_FROM_BHEAD(bhead);
+    }
+  }
+  BLI_assert(i == bheads_len);
+
+  ConvertStructsData data = {fd, bheads};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, bheads_len, &data, read_file_convert_structs_cb, &settings);
+
+  MEM_freeN(bheads);
+}
+
 /* Like read_struct, but gets a pointer without allocating. Only works for
  * undo since DNA must match. */
 static const void *peek_struct_undo(FileData *fd, BHead *bhead)
@@ -3249,6 +3776,9 @@ static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *
 /* Read all data associated with a datablock into datamap. */
 static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *allocname)
 {
+  /* Convert old or foreign DNA of the blocks in parallel, #read_struct uses the result. */
+  read_file_convert_structs(fd, bhead);
+
   bhead = blo_bhead_next(fd, bhead);
 
   while (bhead && bhead->code == DATA) {
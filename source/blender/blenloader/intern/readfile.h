@@ -63,6 +63,20 @@ enum eFileDataFlag {
 typedef int64_t off64_t;
 #endif
 
+/**
+ * Compressed files are written as a sequence of independent gzip members, so they can be
+ * compressed and decompressed in parallel while remaining regular gzip files.
+ * Each member stores its total size in an extra field (see RFC 1952) of the gzip header,
+ * this allows finding all members without decompressing them.
+ */
+#define BLEND_GZIP_BLOCK_SIZE (1 << 20)
+/** Gzip header with the #BLEND_GZIP_SUBFIELD_ID1 extra field. */
+#define BLEND_GZIP_HEADER_SIZE 20
+/** CRC32 and uncompressed size. */
+#define BLEND_GZIP_TRAILER_SIZE 8
+#define BLEND_GZIP_SUBFIELD_ID1 'B'
+#define BLEND_GZIP_SUBFIELD_ID2 'L'
+
 typedef ssize_t(FileDataReadFn)(struct FileData *filedata,
                                 void *buffer,
                                 size_t size,
@@ -87,12 +101,19 @@ typedef struct FileData {
   const char *buffer;
   /** Variables needed for reading from memfile (undo). */
   struct MemFile *memfile;
+  /** Current #MemFileChunk stored in an array store and its expanded data. */
+  const void *memchunk_expanded;
+  char *memchunk_expanded_buf;
   /** Whether we are undoing (< 0) or redoing (> 0), used to choose which 'unchanged' flag to use
    * to detect unchanged data from memfile. */
   short undo_direction;
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
+  /** Reading of block compressed gzip files, see #BLEND_GZIP_BLOCK_SIZE. */
+  struct GzipBlockReader *gzip_blocks;
+  /** Memory mapped reading of uncompressed files, blocks are paged in on access. */
+  struct BLI_mmap_file *mmap_file;
   /** Gzip stream for memory decompression. */
   z_stream strm;
 
@@ -40,8 +40,12 @@
 
 #include "DNA_listBase.h"
 
+#include "BLI_array_store.h"
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
@@ -55,12 +59,107 @@
 /* **************** support for memory-write, for undo buffers *************** */
 
 /* not memfile itself */
+/* -------------------------------------------------------------------- */
+/** \name Array Store for Big Chunks
+ *
+ * Chunks of at least #MEMFILE_ARRAY_STORE_MIN_SIZE bytes are de-duplicated using content
+ * defined chunking (see #BArrayStore), so that inserting or changing a few elements in a big
+ * array only stores the modified part again.
+ * All memfiles share a single store, states of previous undo steps are found
+ * by their position in the previous step, or by a hash of their whole content.
+ * \{ */
+
+#define MEMFILE_ARRAY_STORE_MIN_SIZE (1 << 15)
+#define MEMFILE_ARRAY_STORE_CHUNK_SIZE 4096
+
+static struct {
+  BArrayStore *bs;
+  /** Maps the content hash of a chunk to the most recent #BArrayState storing it. */
+  GHash *state_from_hash;
+  /** Number of states stored, the store is freed when unused. */
+  int users;
+} memfile_arraystore = {NULL};
+
+/** States are added by the background de-duplication while the store may be used by undo. */
+static ThreadMutex memfile_arraystore_mutex = BLI_MUTEX_INITIALIZER;
+
+static BArrayState *memfile_arraystore_state_add(const char *buf,
+                                                 size_t size,
+                                                 uint hash,
+                                                 const BArrayState *state_reference)
+{
+  BLI_mutex_lock(&memfile_arraystore_mutex);
+  if (memfile_arraystore.bs == NULL) {
+    BLI_assert(memfile_arraystore.users == 0);
+    memfile_arraystore.bs = BLI_array_store_create(1, MEMFILE_ARRAY_STORE_CHUNK_SIZE);
+    memfile_arraystore.state_from_hash = BLI_ghash_int_new(__func__);
+  }
+
+  /* Prefer a state with the same content from any previous step. */
+  BArrayState *state_identical = BLI_ghash_lookup(memfile_arraystore.state_from_hash,
+                                                  POINTER_FROM_UINT(hash));
+  if (state_identical != NULL && BLI_array_store_state_size_get(state_identical) == size) {
+    state_reference = state_identical;
+  }
+
+  BArrayState *state = BLI_array_store_state_add(
+      memfile_arraystore.bs, buf, size, state_reference);
+  BLI_ghash_reinsert(
+      memfile_arraystore.state_from_hash, POINTER_FROM_UINT(hash), state, NULL, NULL);
+  memfile_arraystore.users += 1;
+  BLI_mutex_unlock(&memfile_arraystore_mutex);
+  return state;
+}
+
+static void memfile_arraystore_state_remove(BArrayState *state, uint hash)
+{
+  BLI_mutex_lock(&memfile_arraystore_mutex);
+  BLI_assert(memfile_arraystore.users > 0);
+  if (BLI_ghash_lookup(memfile_arraystore.state_from_hash, POINTER_FROM_UINT(hash)) == state) {
+    BLI_ghash_remove(memfile_arraystore.state_from_hash, POINTER_FROM_UINT(hash), NULL, NULL);
+  }
+  BLI_array_store_state_remove(memfile_arraystore.bs, state);
+
+  memfile_arraystore.users -= 1;
+  if (memfile_arraystore.users == 0) {
+    BLI_array_store_destroy(memfile_arraystore.bs);
+    BLI_ghash_free(memfile_arraystore.state_from_hash, NULL, NULL);
+    memfile_arraystore.bs = NULL;
+    memfile_arraystore.state_from_hash = NULL;
+  }
+  BLI_mutex_unlock(&memfile_arraystore_mutex);
+}
+
+/**
+ * Get the data of a chunk stored in the array store (#MemFileChunk.array_state),
+ * the returned buffer must be freed by the caller.
+ */
+char *BLO_memfile_chunk_data_alloc(const MemFileChunk *chunk)
+{
+  BLI_assert(chunk->array_state != NULL);
+  size_t size;
+  BLI_mutex_lock(&memfile_arraystore_mutex);
+  char *buf = BLI_array_store_state_data_get_alloc(chunk->array_state, &size);
+  BLI_mutex_unlock(&memfile_arraystore_mutex);
+  BLI_assert(size == chunk->size);
+  UNUSED_VARS_NDEBUG(size);
+  return buf;
+}
+
+/** \} */
+
 void BLO_memfile_free(MemFile *memfile)
 {
   MemFileChunk *chunk;
 
+  BLO_memfile_wait();
+
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
+    if (chunk->array_state != NULL) {
+      /* Always owned, `is_identical` only tells the content is unchanged. */
+      memfile_arraystore_state_remove(chunk->array_state, chunk->array_hash);
+    }
+    else if (chunk->is_identical == false) {
       MEM_freeN((void *)chunk->buf);
     }
     MEM_freeN(chunk);
@@ -72,6 +171,8 @@ void BLO_memfile_free(MemFile *memfile)
 /* result is that 'first' is being freed */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
+  BLO_memfile_wait();
+
   /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
    * by it (i.e. shared with some previous memory steps). */
   GHash *buffer_to_second_memchunk = BLI_ghash_new(
@@ -79,7 +180,7 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
 
   /* First, detect all memchunks in second memfile that are not owned by it. */
   for (MemFileChunk *sc = second->chunks.first; sc != NULL; sc = sc->next) {
-    if (sc->is_identical) {
+    if (sc->is_identical && sc->array_state == NULL) {
       BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
     }
   }
@@ -87,7 +188,7 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
    * it is also used by the second memfile, transfer the ownership. */
   for (MemFileChunk *fc = first->chunks.first; fc != NULL; fc = fc->next) {
-    if (!fc->is_identical) {
+    if (!fc->is_identical && fc->array_state == NULL) {
       MemFileChunk *sc = BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf);
       if (sc != NULL) {
         BLI_assert(sc->is_identical);
@@ -108,6 +209,8 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
 /* Clear is_identical_future before adding next memfile. */
 void BLO_memfile_clear_future(MemFile *memfile)
 {
+  BLO_memfile_wait();
+
   LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
     chunk->is_identical_future = false;
   }
@@ -117,9 +220,15 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                             MemFile *written_memfile,
                             MemFile *reference_memfile)
 {
+  /* The reference memfile may still be de-duplicated. */
+  BLO_memfile_wait();
+
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
   mem_data->reference_current_chunk = reference_memfile ? reference_memfile->chunks.first : NULL;
+  mem_data->deferred_chunks = NULL;
+  mem_data->deferred_chunks_len = 0;
+  mem_data->deferred_chunks_alloc = 0;
 
   /* If we have a reference memfile, we generate a mapping between the session_uuid's of the
    * IDs stored in that previous undo step, and its first matching memchunk. This will allow
@@ -147,11 +256,117 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Background De-duplication
+ *
+ * Small chunks are compared with the chunk at the same position in the previous step while
+ * writing, so only changed chunks are copied. Big chunks are copied while writing, adding them
+ * to the array store (which hashes and compares all their data) happens in a background task
+ * afterwards, so the UI doesn't wait on it.
+ *
+ * Only a single step is de-duplicated at a time, everything reading or modifying the chunks
+ * of memfiles (including the reference memfile of the pending step) must call
+ * #BLO_memfile_wait first.
+ * \{ */
+
+/** A big chunk and the chunk of the previous step at the same position. */
+typedef struct MemFileDeferredChunk {
+  MemFileChunk *chunk;
+  MemFileChunk *compare_chunk;
+} MemFileDeferredChunk;
+
+typedef struct MemFileDedupData {
+  MemFile *memfile;
+  MemFileDeferredChunk *chunks;
+  size_t chunks_len;
+  /** Size of the big chunks that are not identical, added to the memfile once done. */
+  size_t size;
+} MemFileDedupData;
+
+static struct {
+  TaskPool *pool;
+  MemFileDedupData *data;
+} memfile_dedup = {NULL};
+
+static void memfile_chunk_deduplicate(MemFileChunk *curchunk,
+                                      MemFileChunk *compchunk,
+                                      size_t *r_size)
+{
+  const size_t size = curchunk->size;
+  char *buf = (char *)curchunk->buf;
+
+  if (compchunk != NULL && compchunk->array_state == NULL) {
+    compchunk = NULL;
+  }
+
+  curchunk->array_hash = BLI_hash_mm2((const uchar *)buf, size, 0);
+  curchunk->array_state = memfile_arraystore_state_add(
+      buf, size, curchunk->array_hash, compchunk ? compchunk->array_state : NULL);
+  curchunk->buf = NULL;
+  MEM_freeN(buf);
+
+  if (compchunk != NULL &&
+      BLI_array_store_state_is_equal(compchunk->array_state, curchunk->array_state)) {
+    curchunk->is_identical = true;
+    compchunk->is_identical_future = true;
+  }
+  else {
+    /* Only an estimate, the new state may still share most of its data. */
+    *r_size += size;
+  }
+}
+
+static void memfile_deduplicate_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  MemFileDedupData *data = taskdata;
+  for (size_t i = 0; i < data->chunks_len; i++) {
+    memfile_chunk_deduplicate(data->chunks[i].chunk, data->chunks[i].compare_chunk, &data->size);
+  }
+}
+
+/**
+ * Wait for the de-duplication of the last written memfile to be done.
+ */
+void BLO_memfile_wait(void)
+{
+  if (memfile_dedup.pool == NULL) {
+    return;
+  }
+
+  BLI_task_pool_work_and_wait(memfile_dedup.pool);
+  BLI_task_pool_free(memfile_dedup.pool);
+  memfile_dedup.pool = NULL;
+
+  MemFileDedupData *data = memfile_dedup.data;
+  data->memfile->size += data->size;
+  MEM_freeN(data->chunks);
+  MEM_freeN(data);
+  memfile_dedup.data = NULL;
+}
+
+/** \} */
+
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
 {
   if (mem_data->id_session_uuid_mapping != NULL) {
     BLI_ghash_free(mem_data->id_session_uuid_mapping, NULL, NULL);
   }
+
+  BLI_assert(memfile_dedup.pool == NULL);
+  if (mem_data->deferred_chunks_len == 0) {
+    MEM_SAFE_FREE(mem_data->deferred_chunks);
+    return;
+  }
+
+  MemFileDedupData *data = MEM_callocN(sizeof(*data), __func__);
+  data->memfile = mem_data->written_memfile;
+  data->chunks = mem_data->deferred_chunks;
+  data->chunks_len = mem_data->deferred_chunks_len;
+  mem_data->deferred_chunks = NULL;
+
+  memfile_dedup.data = data;
+  memfile_dedup.pool = BLI_task_pool_create_background(NULL, TASK_PRIORITY_HIGH);
+  BLI_task_pool_push(memfile_dedup.pool, memfile_deduplicate_task, data, false, NULL);
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -162,6 +377,8 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
   curchunk->size = size;
   curchunk->buf = NULL;
+  curchunk->array_state = NULL;
+  curchunk->array_hash = 0;
   curchunk->is_identical = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
@@ -170,26 +387,46 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->id_session_uuid = mem_data->current_id_session_uuid;
   BLI_addtail(&memfile->chunks, curchunk);
 
-  /* we compare compchunk with buf */
-  if (*compchunk_step != NULL) {
-    MemFileChunk *compchunk = *compchunk_step;
-    if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
-        compchunk->is_identical_future = true;
-      }
-    }
+  MemFileChunk *compchunk = *compchunk_step;
+  if (compchunk != NULL) {
     *compchunk_step = compchunk->next;
   }
 
-  /* not equal... */
-  if (curchunk->buf == NULL) {
+  if (size >= MEMFILE_ARRAY_STORE_MIN_SIZE) {
+    /* The written buffer is reused, so the data is copied until
+     * #memfile_deduplicate_task has added it to the array store. */
+    if (mem_data->deferred_chunks_len == mem_data->deferred_chunks_alloc) {
+      mem_data->deferred_chunks_alloc = MAX2(mem_data->deferred_chunks_alloc * 2, (size_t)64);
+      mem_data->deferred_chunks = MEM_reallocN(
+          mem_data->deferred_chunks,
+          sizeof(*mem_data->deferred_chunks) * mem_data->deferred_chunks_alloc);
+    }
+    MemFileDeferredChunk *deferred_chunk =
+        &mem_data->deferred_chunks[mem_data->deferred_chunks_len++];
+    deferred_chunk->chunk = curchunk;
+    deferred_chunk->compare_chunk = compchunk;
+
     char *buf_new = MEM_mallocN(size, "Chunk buffer");
     memcpy(buf_new, buf, size);
     curchunk->buf = buf_new;
-    memfile->size += size;
+    return;
   }
+
+  /* we compare compchunk with buf */
+  if (compchunk != NULL && compchunk->size == curchunk->size && compchunk->array_state == NULL) {
+    if (memcmp(compchunk->buf, buf, size) == 0) {
+      curchunk->buf = compchunk->buf;
+      curchunk->is_identical = true;
+      compchunk->is_identical_future = true;
+      return;
+    }
+  }
+
+  /* not equal... */
+  char *buf_new = MEM_mallocN(size, "Chunk buffer");
+  memcpy(buf_new, buf, size);
+  curchunk->buf = buf_new;
+  memfile->size += size;
 }
 
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
@@ -225,6 +462,8 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
   MemFileChunk *chunk;
   int file, oflags;
 
+  BLO_memfile_wait();
+
   /* note: This is currently used for autosave and 'quit.blend',
    * where _not_ following symlinks is OK,
    * however if this is ever executed explicitly by the user,
@@ -252,12 +491,17 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
   }
 
   for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+    const char *buf = (chunk->array_state != NULL) ? BLO_memfile_chunk_data_alloc(chunk) :
+                                                     chunk->buf;
 #ifdef _WIN32
-    if ((size_t)write(file, chunk->buf, (uint)chunk->size) != chunk->size)
+    const bool ok = (size_t)write(file, buf, (uint)chunk->size) == chunk->size;
 #else
-    if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size)
+    const bool ok = (size_t)write(file, buf, chunk->size) == chunk->size;
 #endif
-    {
+    if (buf != chunk->buf) {
+      MEM_freeN((void *)buf);
+    }
+    if (!ok) {
       break;
     }
   }
@@ -101,6 +101,8 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
 #include "BKE_blender_version.h"
@@ -162,7 +164,7 @@ struct WriteWrap {
   /* internal */
   union {
     int file_handle;
-    gzFile gz_handle;
+    struct WriteWrapZlib *zlib;
   } _user_data;
 };
 
@@ -193,30 +195,242 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 #undef FILE_HANDLE
 
 /* zlib */
-#define FILE_HANDLE(ww) (ww)->_user_data.gz_handle
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+/**
+ * Data is split in blocks of #BLEND_GZIP_BLOCK_SIZE which are compressed in parallel into
+ * independent gzip members. Concatenated members are a valid gzip file.
+ *
+ * Blocks are written to the file by the compression tasks as soon as all previous blocks have
+ * been written, so writing overlaps with the compression of the following blocks and with
+ * filling the next block.
+ */
+typedef struct ZlibBlock {
+  char *in;
+  size_t in_len;
+  char *out;
+  size_t out_len;
+  bool error;
+  /** Compressed and waiting for the previous blocks to be written. */
+  bool compressed;
+} ZlibBlock;
+
+typedef struct WriteWrapZlib {
+  int file_handle;
+  TaskPool *task_pool;
+  /** Ring buffer of blocks, the n-th block of the file uses `blocks[n % blocks_len]`. */
+  ZlibBlock *blocks;
+  int blocks_len;
+  /** Block that is being filled, it is not in the task pool yet. */
+  ZlibBlock *block_filling;
+  /** Number of blocks pushed to the task pool and number of blocks written to the file. */
+  int blocks_submitted;
+  int blocks_written;
+  /** Protects the counters, the file and #error. */
+  ThreadMutex mutex;
+  /** Notified when blocks have been written, so their buffers can be reused. */
+  ThreadCondition blocks_written_cond;
+  bool error;
+} WriteWrapZlib;
+
+#define ZLIB_HANDLE(ww) (ww)->_user_data.zlib
+
+static void write_u16_le(uchar *buf, const uint value)
 {
-  gzFile file;
+  buf[0] = (uchar)(value & 0xff);
+  buf[1] = (uchar)((value >> 8) & 0xff);
+}
 
-  file = BLI_gzopen(filepath, "wb1");
+static void write_u32_le(uchar *buf, const uint value)
+{
+  write_u16_le(buf, value & 0xffff);
+  write_u16_le(buf + 2, value >> 16);
+}
 
-  if (file != Z_NULL) {
-    FILE_HANDLE(ww) = file;
-    return true;
+static bool ww_zlib_compress_block(ZlibBlock *block)
+{
+  z_stream strm = {NULL};
+
+  /* Raw deflate, the gzip header and trailer are written here so the header can store the size
+   * of the member. Use the fastest level, same as before blocks were introduced. */
+  if (deflateInit2(&strm, 1, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
   }
 
-  return false;
+  /* Allocate for a full block, so the output buffer can be reused for any block. */
+  const size_t out_len_max = BLEND_GZIP_HEADER_SIZE + deflateBound(&strm, BLEND_GZIP_BLOCK_SIZE) +
+                             BLEND_GZIP_TRAILER_SIZE;
+  if (block->out == NULL) {
+    block->out = MEM_mallocN(out_len_max, __func__);
+  }
+
+  uchar *header = (uchar *)block->out;
+  strm.next_in = (Bytef *)block->in;
+  strm.avail_in = (uInt)block->in_len;
+  strm.next_out = (Bytef *)(header + BLEND_GZIP_HEADER_SIZE);
+  strm.avail_out = (uInt)(out_len_max - BLEND_GZIP_HEADER_SIZE - BLEND_GZIP_TRAILER_SIZE);
+
+  const bool ok = (deflate(&strm, Z_FINISH) == Z_STREAM_END);
+  const size_t compressed_len = strm.total_out;
+  deflateEnd(&strm);
+  if (!ok) {
+    return false;
+  }
+
+  block->out_len = BLEND_GZIP_HEADER_SIZE + compressed_len + BLEND_GZIP_TRAILER_SIZE;
+
+  /* Magic, deflate method, FEXTRA flag. */
+  header[0] = 0x1f;
+  header[1] = 0x8b;
+  header[2] = Z_DEFLATED;
+  header[3] = 0x04;
+  /* Modification time, extra flags and unknown OS. */
+  write_u32_le(header + 4, 0);
+  header[8] = 0;
+  header[9] = 0xff;
+  /* Extra field with a single sub-field containing the size of this member. */
+  write_u16_le(header + 10, 8);
+  header[12] = BLEND_GZIP_SUBFIELD_ID1;
+  header[13] = BLEND_GZIP_SUBFIELD_ID2;
+  write_u16_le(header + 14, 4);
+  write_u32_le(header + 16, (uint)block->out_len);
+
+  uchar *trailer = header + BLEND_GZIP_HEADER_SIZE + compressed_len;
+  write_u32_le(trailer, (uint)crc32(0, (const Bytef *)block->in, (uInt)block->in_len));
+  write_u32_le(trailer + 4, (uint)block->in_len);
+  return true;
+}
+
+static void ww_zlib_compress_block_task(TaskPool *__restrict pool, void *taskdata)
+{
+  WriteWrapZlib *zlib = BLI_task_pool_user_data(pool);
+  ZlibBlock *block = taskdata;
+
+  block->error = !ww_zlib_compress_block(block);
+
+  BLI_mutex_lock(&zlib->mutex);
+  block->compressed = true;
+  /* Write this block and the blocks after it that are compressed already, unless an earlier
+   * block is still being compressed. Its task writes them once it is done. */
+  while (zlib->blocks_written < zlib->blocks_submitted) {
+    ZlibBlock *block_next = &zlib->blocks[zlib->blocks_written % zlib->blocks_len];
+    if (!block_next->compressed) {
+      break;
+    }
+    if (block_next->error || write(zlib->file_handle, block_next->out, block_next->out_len) !=
+                                 (ssize_t)block_next->out_len) {
+      zlib->error = true;
+    }
+    block_next->compressed = false;
+    block_next->in_len = 0;
+    zlib->blocks_written++;
+  }
+  BLI_condition_notify_all(&zlib->blocks_written_cond);
+  BLI_mutex_unlock(&zlib->mutex);
+}
+
+/** Get a block to fill, waits until a block has been written when all of them are in use. */
+static ZlibBlock *ww_zlib_block_acquire(WriteWrapZlib *zlib)
+{
+  BLI_mutex_lock(&zlib->mutex);
+  while (zlib->blocks_submitted - zlib->blocks_written == zlib->blocks_len) {
+    BLI_condition_wait(&zlib->blocks_written_cond, &zlib->mutex);
+  }
+  ZlibBlock *block = &zlib->blocks[zlib->blocks_submitted % zlib->blocks_len];
+  BLI_mutex_unlock(&zlib->mutex);
+
+  if (block->in == NULL) {
+    block->in = MEM_mallocN(BLEND_GZIP_BLOCK_SIZE, __func__);
+  }
+  block->in_len = 0;
+  block->error = false;
+  return block;
+}
+
+static void ww_zlib_block_submit(WriteWrapZlib *zlib)
+{
+  ZlibBlock *block = zlib->block_filling;
+  zlib->block_filling = NULL;
+
+  /* Count the block before it is pushed, so that its task knows it has to be written. */
+  BLI_mutex_lock(&zlib->mutex);
+  zlib->blocks_submitted++;
+  BLI_mutex_unlock(&zlib->mutex);
+
+  BLI_task_pool_push(zlib->task_pool, ww_zlib_compress_block_task, block, false, NULL);
+}
+
+static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+{
+  int file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+  if (file == -1) {
+    return false;
+  }
+
+  WriteWrapZlib *zlib = MEM_callocN(sizeof(*zlib), __func__);
+  zlib->file_handle = file;
+  zlib->task_pool = BLI_task_pool_create(zlib, TASK_PRIORITY_HIGH);
+  /* Enough blocks to keep all threads busy while earlier blocks are written. */
+  zlib->blocks_len = MAX2(BLI_system_thread_count() * 2, 2);
+  zlib->blocks = MEM_callocN(sizeof(*zlib->blocks) * (size_t)zlib->blocks_len, __func__);
+  BLI_mutex_init(&zlib->mutex);
+  BLI_condition_init(&zlib->blocks_written_cond);
+  ZLIB_HANDLE(ww) = zlib;
+  return true;
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-  return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+  WriteWrapZlib *zlib = ZLIB_HANDLE(ww);
+
+  if (zlib->block_filling != NULL && zlib->block_filling->in_len != 0) {
+    ww_zlib_block_submit(zlib);
+  }
+  BLI_task_pool_work_and_wait(zlib->task_pool);
+  bool ok = !zlib->error && (zlib->blocks_written == zlib->blocks_submitted);
+
+  BLI_task_pool_free(zlib->task_pool);
+  BLI_condition_end(&zlib->blocks_written_cond);
+  BLI_mutex_end(&zlib->mutex);
+  for (int i = 0; i < zlib->blocks_len; i++) {
+    MEM_SAFE_FREE(zlib->blocks[i].in);
+    MEM_SAFE_FREE(zlib->blocks[i].out);
+  }
+  MEM_freeN(zlib->blocks);
+  if (close(zlib->file_handle) == -1) {
+    ok = false;
+  }
+  MEM_freeN(zlib);
+  ZLIB_HANDLE(ww) = NULL;
+  return ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-  return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+  WriteWrapZlib *zlib = ZLIB_HANDLE(ww);
+  const size_t buf_len_total = buf_len;
+
+  while (buf_len != 0) {
+    if (zlib->block_filling == NULL) {
+      zlib->block_filling = ww_zlib_block_acquire(zlib);
+    }
+
+    ZlibBlock *block = zlib->block_filling;
+    const size_t copy_len = MIN2(buf_len, BLEND_GZIP_BLOCK_SIZE - block->in_len);
+    memcpy(block->in + block->in_len, buf, copy_len);
+    block->in_len += copy_len;
+    buf += copy_len;
+    buf_len -= copy_len;
+
+    if (block->in_len == BLEND_GZIP_BLOCK_SIZE) {
+      ww_zlib_block_submit(zlib);
+    }
+  }
+
+  BLI_mutex_lock(&zlib->mutex);
+  const bool error = zlib->error;
+  BLI_mutex_unlock(&zlib->mutex);
+  return error ? 0 : buf_len_total;
 }
-#undef FILE_HANDLE
+#undef ZLIB_HANDLE
 
 /* --- end compression types --- */
 
@@ -380,6 +594,13 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
         wd->buf_used_len = 0;
       }
 
+      /* Undo de-duplicates big chunks by their content (see #BArrayStore),
+       * keep the whole block together so changes don't shift the chunk boundaries. */
+      if (wd->use_memfile && len <= INT_MAX) {
+        writedata_do_write(wd, adr, len);
+        return;
+      }
+
       do {
         size_t writelen = MIN2(len, MYWRITE_MAX_CHUNK);
         writedata_do_write(wd, adr, writelen);
@@ -0,0 +1,144 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_vector.hh"
+
+#include <string>
+
+extern "C" {
+#include "BLO_undofile.h"
+}
+
+namespace blender::blenloader::tests {
+
+/* Big enough to be stored in the array store. */
+static constexpr size_t big_chunk_size = 1 << 16;
+static constexpr size_t small_chunk_size = 64;
+
+/* Write one memfile with the given chunks, using the previous memfile as reference. */
+static void write_memfile(MemFile *memfile,
+                          MemFile *reference_memfile,
+                          const Vector<std::string> &chunks)
+{
+  if (reference_memfile != nullptr) {
+    BLO_memfile_clear_future(reference_memfile);
+  }
+  MemFileWriteData mem_data = {nullptr};
+  BLO_memfile_write_init(&mem_data, memfile, reference_memfile);
+  for (const std::string &chunk : chunks) {
+    BLO_memfile_chunk_add(&mem_data, chunk.data(), chunk.size());
+  }
+  BLO_memfile_write_finalize(&mem_data);
+}
+
+static std::string chunk_data(const size_t size, const char value)
+{
+  return std::string(size, value);
+}
+
+static std::string memfile_chunk_data(const MemFileChunk *chunk)
+{
+  if (chunk->buf != nullptr) {
+    return std::string(chunk->buf, chunk->size);
+  }
+  char *buf = BLO_memfile_chunk_data_alloc(chunk);
+  std::string data(buf, chunk->size);
+  MEM_freeN(buf);
+  return data;
+}
+
+static const MemFileChunk *first_chunk(const MemFile *memfile)
+{
+  return static_cast<const MemFileChunk *>(memfile->chunks.first);
+}
+
+static const MemFileChunk *next_chunk(const MemFileChunk *chunk)
+{
+  return static_cast<const MemFileChunk *>(chunk->next);
+}
+
+TEST(undofile, SmallChunksAreShared)
+{
+  MemFile memfile_a = {{nullptr}};
+  MemFile memfile_b = {{nullptr}};
+  write_memfile(&memfile_a, nullptr, {chunk_data(small_chunk_size, 1), chunk_data(32, 2)});
+  EXPECT_EQ(memfile_a.size, small_chunk_size + 32);
+
+  write_memfile(&memfile_b, &memfile_a, {chunk_data(small_chunk_size, 1), chunk_data(32, 3)});
+  /* Only the changed chunk is counted. */
+  EXPECT_EQ(memfile_b.size, 32);
+
+  const MemFileChunk *chunk_a = first_chunk(&memfile_a);
+  const MemFileChunk *chunk_b = first_chunk(&memfile_b);
+  EXPECT_TRUE(chunk_b->is_identical);
+  EXPECT_TRUE(chunk_a->is_identical_future);
+  EXPECT_EQ(chunk_a->buf, chunk_b->buf);
+
+  EXPECT_FALSE(next_chunk(chunk_b)->is_identical);
+  EXPECT_FALSE(next_chunk(chunk_a)->is_identical_future);
+  EXPECT_NE(next_chunk(chunk_a)->buf, next_chunk(chunk_b)->buf);
+  EXPECT_EQ(memfile_chunk_data(next_chunk(chunk_b)), chunk_data(32, 3));
+
+  BLO_memfile_merge(&memfile_a, &memfile_b);
+  EXPECT_EQ(memfile_chunk_data(chunk_b), chunk_data(small_chunk_size, 1));
+  BLO_memfile_free(&memfile_b);
+}
+
+TEST(undofile, BigChunksAreDeduplicated)
+{
+  MemFile memfile_a = {{nullptr}};
+  MemFile memfile_b = {{nullptr}};
+  write_memfile(
+      &memfile_a, nullptr, {chunk_data(big_chunk_size, 1), chunk_data(big_chunk_size, 2)});
+  BLO_memfile_wait();
+  EXPECT_EQ(memfile_a.size, 2 * big_chunk_size);
+
+  write_memfile(
+      &memfile_b, &memfile_a, {chunk_data(big_chunk_size, 1), chunk_data(big_chunk_size, 3)});
+  BLO_memfile_wait();
+  EXPECT_EQ(memfile_b.size, big_chunk_size);
+
+  const MemFileChunk *chunk_a = first_chunk(&memfile_a);
+  const MemFileChunk *chunk_b = first_chunk(&memfile_b);
+  EXPECT_TRUE(chunk_b->is_identical);
+  EXPECT_TRUE(chunk_a->is_identical_future);
+  EXPECT_FALSE(next_chunk(chunk_b)->is_identical);
+  EXPECT_FALSE(next_chunk(chunk_a)->is_identical_future);
+
+  EXPECT_EQ(memfile_chunk_data(chunk_b), chunk_data(big_chunk_size, 1));
+  EXPECT_EQ(memfile_chunk_data(next_chunk(chunk_b)), chunk_data(big_chunk_size, 3));
+
+  BLO_memfile_merge(&memfile_a, &memfile_b);
+  EXPECT_EQ(memfile_chunk_data(next_chunk(chunk_b)), chunk_data(big_chunk_size, 3));
+  BLO_memfile_free(&memfile_b);
+}
+
+TEST(undofile, FreeWhileDeduplicating)
+{
+  MemFile memfile = {{nullptr}};
+  write_memfile(
+      &memfile, nullptr, {chunk_data(big_chunk_size, 1), chunk_data(small_chunk_size, 1)});
+  /* Freeing waits for the pending de-duplication. */
+  BLO_memfile_free(&memfile);
+  EXPECT_EQ(memfile.size, 0);
+  EXPECT_TRUE(BLI_listbase_is_empty(&memfile.chunks));
+}
+
+}  // namespace blender::blenloader::tests
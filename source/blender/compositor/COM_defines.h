@@ -68,10 +68,17 @@ typedef enum CompositorPriority {
 // workscheduler threading models
 /**
  * COM_TM_QUEUE is a multi-threaded model, which uses the BLI_thread_queue pattern.
- * This is the default option.
+ * Every CPUDevice has its own thread that pops work from a shared queue.
  */
 #define COM_TM_QUEUE 1
 
+/**
+ * COM_TM_TASK is a multi-threaded model, which pushes every work package to a BLI_task pool.
+ * Packages are executed by the (work-stealing) task scheduler that is shared with the rest of
+ * Blender. This is the default option.
+ */
+#define COM_TM_TASK 2
+
 /**
  * COM_TM_NOTHREAD is a single threading model, everything is executed in the caller thread.
  * easy for debugging
@@ -79,9 +86,28 @@ typedef enum CompositorPriority {
 #define COM_TM_NOTHREAD 0
 
 /**
- * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_QUEUE is currently default.
+ * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_TASK is currently default.
+ */
+#define COM_CURRENT_THREADING_MODEL COM_TM_TASK
+
+// execution models
+/**
+ * COM_EM_PIXEL evaluates every chunk by reading the output operation pixel by pixel.
+ * Every read is forwarded to the input operations through virtual calls.
+ */
+#define COM_EM_PIXEL 0
+
+/**
+ * COM_EM_BUFFER evaluates every chunk by rendering whole areas of the operations into buffers.
+ * Operations that support it process the buffers of their inputs in row-contiguous loops,
+ * other operations fall back to per pixel reads, see NodeOperation.renderArea.
+ */
+#define COM_EM_BUFFER 1
+
+/**
+ * COM_CURRENT_EXECUTION_MODEL can be one of the above, COM_EM_BUFFER is currently default.
  */
-#define COM_CURRENT_THREADING_MODEL COM_TM_QUEUE
+#define COM_CURRENT_EXECUTION_MODEL COM_EM_BUFFER
 // chunk order
 /**
  * \brief The order of chunks to be scheduled
@@ -46,6 +46,8 @@ ExecutionGroup::ExecutionGroup()
   this->m_isOutput = false;
   this->m_complex = false;
   this->m_chunkExecutionStates = nullptr;
+  this->m_chunkOrder = nullptr;
+  this->m_scheduleStartIndex = 0;
   this->m_bTree = nullptr;
   this->m_height = 0;
   this->m_width = 0;
@@ -122,15 +124,14 @@ NodeOperation *ExecutionGroup::getOutputOperation() const
 void ExecutionGroup::initExecution()
 {
   if (this->m_chunkExecutionStates != nullptr) {
-    MEM_freeN(this->m_chunkExecutionStates);
+    delete[] this->m_chunkExecutionStates;
   }
   unsigned int index;
   determineNumberOfChunks();
 
   this->m_chunkExecutionStates = nullptr;
   if (this->m_numberOfChunks != 0) {
-    this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(
-        sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
+    this->m_chunkExecutionStates = new std::atomic<ChunkExecutionState>[this->m_numberOfChunks];
     for (index = 0; index < this->m_numberOfChunks; index++) {
       this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
     }
@@ -153,7 +154,7 @@ void ExecutionGroup::initExecution()
 void ExecutionGroup::deinitExecution()
 {
   if (this->m_chunkExecutionStates != nullptr) {
-    MEM_freeN(this->m_chunkExecutionStates);
+    delete[] this->m_chunkExecutionStates;
     this->m_chunkExecutionStates = nullptr;
   }
   this->m_numberOfChunks = 0;
@@ -193,17 +194,37 @@ void ExecutionGroup::determineNumberOfChunks()
  * preview node or the viewer node)
  */
 void ExecutionGroup::execute(ExecutionSystem *graph)
+{
+  if (!beginExecution(graph)) {
+    return;
+  }
+
+  const bNodeTree *bTree = graph->getContext().getbNodeTree();
+  while (!scheduleChunks(graph)) {
+    /* Reschedule as soon as any chunk finished instead of waiting for the whole window. */
+    WorkScheduler::wait_for_progress();
+
+    if (bTree->test_break && bTree->test_break(bTree->tbh)) {
+      break;
+    }
+  }
+  WorkScheduler::finish();
+
+  endExecution(graph);
+}
+
+bool ExecutionGroup::beginExecution(ExecutionSystem *graph)
 {
   const CompositorContext &context = graph->getContext();
   const bNodeTree *bTree = context.getbNodeTree();
   if (this->m_width == 0 || this->m_height == 0) {
-    return;
+    return false;
   } /** \note Break out... no pixels to calculate. */
   if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-    return;
+    return false;
   } /** \note Early break out for blur and preview nodes. */
   if (this->m_numberOfChunks == 0) {
-    return;
+    return false;
   } /** \note Early break out. */
   unsigned int chunkNumber;
 
@@ -322,53 +343,56 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
   DebugInfo::execution_group_started(this);
   DebugInfo::graphviz(graph);
 
-  bool breaked = false;
-  bool finished = false;
-  unsigned int startIndex = 0;
-  const int maxNumberEvaluated = BLI_system_thread_count() * 2;
+  this->m_chunkOrder = chunkOrder;
+  this->m_scheduleStartIndex = 0;
+  return true;
+}
 
-  while (!finished && !breaked) {
-    bool startEvaluated = false;
-    finished = true;
-    int numberEvaluated = 0;
-
-    for (index = startIndex;
-         index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated;
-         index++) {
-      chunkNumber = chunkOrder[index];
-      int yChunk = chunkNumber / this->m_numberOfXChunks;
-      int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-      const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-      if (state == COM_ES_NOT_SCHEDULED) {
-        scheduleChunkWhenPossible(graph, xChunk, yChunk);
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-
-        if (bTree->update_draw) {
-          bTree->update_draw(bTree->udh);
-        }
-      }
-      else if (state == COM_ES_SCHEDULED) {
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-      }
-      else if (state == COM_ES_EXECUTED && !startEvaluated) {
-        startIndex = index + 1;
+bool ExecutionGroup::scheduleChunks(ExecutionSystem *graph)
+{
+  const bNodeTree *bTree = graph->getContext().getbNodeTree();
+  const int maxNumberEvaluated = BLI_system_thread_count() * 2;
+  bool startEvaluated = false;
+  bool finished = true;
+  int numberEvaluated = 0;
+
+  for (unsigned int index = this->m_scheduleStartIndex;
+       index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated;
+       index++) {
+    const unsigned int chunkNumber = this->m_chunkOrder[index];
+    int yChunk = chunkNumber / this->m_numberOfXChunks;
+    int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+    const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
+    if (state == COM_ES_NOT_SCHEDULED) {
+      scheduleChunkWhenPossible(graph, xChunk, yChunk);
+      finished = false;
+      startEvaluated = true;
+      numberEvaluated++;
+
+      if (bTree->update_draw) {
+        bTree->update_draw(bTree->udh);
       }
     }
-
-    WorkScheduler::finish();
-
-    if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-      breaked = true;
+    else if (state == COM_ES_SCHEDULED) {
+      finished = false;
+      startEvaluated = true;
+      numberEvaluated++;
+    }
+    else if (state == COM_ES_EXECUTED && !startEvaluated) {
+      this->m_scheduleStartIndex = index + 1;
     }
   }
+
+  return finished;
+}
+
+void ExecutionGroup::endExecution(ExecutionSystem *graph)
+{
   DebugInfo::execution_group_finished(this);
   DebugInfo::graphviz(graph);
 
-  MEM_freeN(chunkOrder);
+  MEM_freeN(this->m_chunkOrder);
+  this->m_chunkOrder = nullptr;
 }
 
 MemoryBuffer **ExecutionGroup::getInputBuffersOpenCL(int chunkNumber)
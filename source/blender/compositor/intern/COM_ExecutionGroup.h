@@ -28,6 +28,7 @@
 #include "COM_MemoryProxy.h"
 #include "COM_Node.h"
 #include "COM_NodeOperation.h"
+#include <atomic>
 #include <vector>
 
 using std::vector;
@@ -155,8 +156,19 @@ class ExecutionGroup {
    *   - COM_ES_NOT_SCHEDULED: not scheduled
    *   - COM_ES_SCHEDULED: scheduled
    *   - COM_ES_EXECUTED: executed
+   * \note states are written by the worker threads and read while scheduling.
    */
-  ChunkExecutionState *m_chunkExecutionStates;
+  std::atomic<ChunkExecutionState> *m_chunkExecutionStates;
+
+  /**
+   * \brief order in which the chunks are scheduled, determined in #beginExecution.
+   */
+  unsigned int *m_chunkOrder;
+
+  /**
+   * \brief index in #m_chunkOrder of the first chunk that is not executed yet.
+   */
+  unsigned int m_scheduleStartIndex;
 
   /**
    * \brief indicator when this ExecutionGroup has valid Operations in its vector for Execution
@@ -399,6 +411,26 @@ class ExecutionGroup {
    */
   void execute(ExecutionSystem *graph);
 
+  /**
+   * \brief prepare the execution of this ExecutionGroup
+   * determines the order of the chunks. Returns false when there is nothing to execute,
+   * in that case #scheduleChunks and #endExecution must not be called.
+   */
+  bool beginExecution(ExecutionSystem *graph);
+
+  /**
+   * \brief schedule the next window of chunks whose dependencies are available
+   * does not wait for the scheduled work, so multiple groups can be scheduled interleaved.
+   * \return true when all chunks of this group have been executed.
+   */
+  bool scheduleChunks(ExecutionSystem *graph);
+
+  /**
+   * \brief free the data of #beginExecution.
+   * \note all scheduled work must be finished before calling this.
+   */
+  void endExecution(ExecutionSystem *graph);
+
   /**
    * \brief this method determines the MemoryProxy's where this execution group depends on.
    * \note After this method determineDependingAreaOfInterest can be called to determine
@@ -205,9 +205,41 @@ void ExecutionSystem::executeGroups(CompositorPriority priority)
   vector<ExecutionGroup *> executionGroups;
   this->findOutputExecutionGroup(&executionGroups, priority);
 
+  /* Schedule all output groups of this priority interleaved, so chunks of independent groups
+   * keep the worker threads busy instead of waiting for one group to finish completely. */
+  vector<ExecutionGroup *> startedGroups;
   for (index = 0; index < executionGroups.size(); index++) {
     ExecutionGroup *group = executionGroups[index];
-    group->execute(this);
+    if (group->beginExecution(this)) {
+      startedGroups.push_back(group);
+    }
+  }
+
+  const bNodeTree *bTree = this->m_context.getbNodeTree();
+  vector<ExecutionGroup *> activeGroups = startedGroups;
+  while (!activeGroups.empty()) {
+    for (index = 0; index < activeGroups.size();) {
+      if (activeGroups[index]->scheduleChunks(this)) {
+        activeGroups.erase(activeGroups.begin() + index);
+      }
+      else {
+        index++;
+      }
+    }
+    if (activeGroups.empty()) {
+      break;
+    }
+
+    WorkScheduler::wait_for_progress();
+
+    if (bTree->test_break && bTree->test_break(bTree->tbh)) {
+      break;
+    }
+  }
+  WorkScheduler::finish();
+
+  for (index = 0; index < startedGroups.size(); index++) {
+    startedGroups[index]->endExecution(this);
   }
 }
 
@@ -137,6 +137,20 @@ class MemoryBuffer {
     return this->m_buffer;
   }
 
+  /**
+   * \brief get the address of the element at the given coordinate
+   * \note the coordinate should be inside the rect of this buffer.
+   * Elements of a row are stored contiguous, so this can be used to walk whole rows.
+   */
+  float *getElem(int x, int y)
+  {
+    BLI_assert(x >= this->m_rect.xmin && x < this->m_rect.xmax);
+    BLI_assert(y >= this->m_rect.ymin && y < this->m_rect.ymax);
+    const int offset = (this->m_width * (y - this->m_rect.ymin) + (x - this->m_rect.xmin)) *
+                       this->m_num_channels;
+    return this->m_buffer + offset;
+  }
+
   /**
    * \brief after execution the state will be set to available by calling this method
    */
@@ -17,6 +17,7 @@
  */
 
 #include <cstdio>
+#include <cstring>
 #include <typeinfo>
 
 #include "COM_ExecutionSystem.h"
@@ -36,6 +37,7 @@ NodeOperation::NodeOperation()
   this->m_height = 0;
   this->m_isResolutionSet = false;
   this->m_openCL = false;
+  this->m_bufferExecution = false;
   this->m_btree = nullptr;
 }
 
@@ -149,6 +151,57 @@ NodeOperation *NodeOperation::getInputOperation(unsigned int inputSocketIndex)
   return nullptr;
 }
 
+void NodeOperation::renderArea(MemoryBuffer *output, rcti *area)
+{
+  if (BLI_rcti_is_empty(area)) {
+    return;
+  }
+
+  if (!this->m_bufferExecution) {
+    const int num_channels = output->get_num_channels();
+    for (int y = area->ymin; y < area->ymax; y++) {
+      float *elem = output->getElem(area->xmin, y);
+      for (int x = area->xmin; x < area->xmax; x++) {
+        /* Samplers always write 4 values, the output buffer might have less channels. */
+        float color[4];
+        this->readSampled(color, x, y, COM_PS_NEAREST);
+        memcpy(elem, color, sizeof(float) * num_channels);
+        elem += num_channels;
+      }
+      if (isBraked()) {
+        break;
+      }
+    }
+    return;
+  }
+
+  std::vector<MemoryBuffer *> inputs(m_inputs.size(), nullptr);
+  for (unsigned int index = 0; index < m_inputs.size(); index++) {
+    NodeOperationInput *input = m_inputs[index];
+    if (!input->isConnected()) {
+      continue;
+    }
+    rcti inputArea;
+    this->getAreaOfInterest(index, area, &inputArea);
+    inputs[index] = new MemoryBuffer(input->getLink()->getDataType(), &inputArea);
+    input->getLink()->getOperation().renderArea(inputs[index], &inputArea);
+  }
+
+  /* Inputs might be incomplete when the execution was stopped. */
+  if (!isBraked()) {
+    this->updateMemoryBuffer(output, area, inputs.data());
+  }
+
+  for (MemoryBuffer *buffer : inputs) {
+    delete buffer;
+  }
+}
+
+void NodeOperation::getAreaOfInterest(int /*inputIndex*/, rcti *outputArea, rcti *r_inputArea)
+{
+  *r_inputArea = *outputArea;
+}
+
 void NodeOperation::getConnectedInputSockets(Inputs *sockets)
 {
   for (Inputs::const_iterator it = m_inputs.begin(); it != m_inputs.end(); ++it) {
@@ -102,6 +102,12 @@ class NodeOperation : public SocketReader {
    */
   bool m_openCL;
 
+  /**
+   * \brief can this operation process whole buffers.
+   * \see NodeOperation.updateMemoryBuffer
+   */
+  bool m_bufferExecution;
+
   /**
    * \brief mutex reference for very special node initializations
    * \note only use when you really know what you are doing.
@@ -313,6 +319,42 @@ class NodeOperation : public SocketReader {
     return false;
   }
 
+  /**
+   * \brief render the area of this operation into output.
+   *
+   * When this operation supports buffer execution its inputs are rendered into temporary buffers
+   * first and #updateMemoryBuffer processes them. Otherwise every pixel of the area is read with
+   * the nearest sampler, the same way the tiled execution does. Rendering stops early when the
+   * execution is braked, the output is incomplete in that case.
+   * \param output: buffer to write to, the area must be inside its rect.
+   * \param area: area to render.
+   */
+  void renderArea(MemoryBuffer *output, rcti *area);
+
+  /**
+   * \brief determine the area of an input that is needed to render an area of this operation
+   * The default implementation uses the same area, which is correct for pixel-wise operations.
+   */
+  virtual void getAreaOfInterest(int inputIndex, rcti *outputArea, rcti *r_inputArea);
+
+  /**
+   * \brief process a whole area
+   * \note only called when buffer execution is enabled for this operation.
+   * \param output: buffer to write to, the area is inside its rect.
+   * \param area: area to calculate.
+   * \param inputs: buffers of the inputs, covering their area of interest.
+   */
+  virtual void updateMemoryBuffer(MemoryBuffer * /*output*/,
+                                  rcti * /*area*/,
+                                  MemoryBuffer ** /*inputs*/)
+  {
+  }
+
+  bool isBufferExecution() const
+  {
+    return this->m_bufferExecution;
+  }
+
   virtual bool determineDependingAreaOfInterest(rcti *input,
                                                 ReadBufferOperation *readOperation,
                                                 rcti *output);
@@ -420,6 +462,14 @@ class NodeOperation : public SocketReader {
     this->m_openCL = openCL;
   }
 
+  /**
+   * \brief set if this NodeOperation implements #updateMemoryBuffer
+   */
+  void setBufferExecution(bool bufferExecution)
+  {
+    this->m_bufferExecution = bufferExecution;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
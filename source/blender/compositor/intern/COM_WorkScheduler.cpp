@@ -29,7 +29,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_task.h"
 #include "BLI_threads.h"
+#include "BLI_utildefines.h"
 #include "PIL_time.h"
 
 #include "BKE_global.h"
@@ -39,6 +41,8 @@
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
 #  endif
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+/* do nothing */
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 /* do nothing - default */
 #else
 #  error COM_CURRENT_THREADING_MODEL No threading model selected
@@ -48,12 +52,32 @@
 static vector<CPUDevice *> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+static bool g_cpuInitialized = false;
+#endif
+
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 /** \brief list of all thread for every CPUDevice in cpudevices a thread exists. */
 static ListBase g_cputhreads;
-static bool g_cpuInitialized = false;
 /** \brief all scheduled work for the cpu */
 static ThreadQueue *g_cpuqueue;
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+/** \brief all scheduled work for the cpu, executed by the work-stealing task scheduler. */
+static TaskPool *g_cpupool;
+#endif
+
+/**
+ * \brief number of scheduled and finished work packages.
+ * Used by #WorkScheduler::wait_for_progress to wake up as soon as any chunk finished.
+ */
+static ThreadMutex g_progress_mutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition g_progress_cond;
+static bool g_progress_initialized = false;
+static int g_packages_scheduled = 0;
+static int g_packages_finished = 0;
+static int g_packages_finished_seen = 0;
+
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 static ThreadQueue *g_gpuqueue;
 #  ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -69,6 +93,14 @@ static bool g_openclInitialized = false;
 #  endif
 #endif
 
+static void work_package_finished()
+{
+  BLI_mutex_lock(&g_progress_mutex);
+  g_packages_finished++;
+  BLI_condition_notify_all(&g_progress_cond);
+  BLI_mutex_unlock(&g_progress_mutex);
+}
+
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
@@ -78,11 +110,27 @@ void *WorkScheduler::thread_execute_cpu(void *data)
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
     device->execute(work);
     delete work;
+    work_package_finished();
   }
 
   return nullptr;
 }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+void WorkScheduler::thread_execute_cpu_task(TaskPool *__restrict /*pool*/, void *data)
+{
+  WorkPackage *work = (WorkPackage *)data;
+  /* Devices are stateless, so a device is created for the worker thread that picked up the
+   * package. The thread id stays stable per worker so per-thread data can be indexed by it. */
+  CPUDevice device(BLI_task_parallel_thread_id(nullptr));
+  BLI_thread_local_set(g_thread_device, &device);
+  device.execute(work);
+  BLI_thread_local_set(g_thread_device, nullptr);
+  delete work;
+  work_package_finished();
+}
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 void *WorkScheduler::thread_execute_gpu(void *data)
 {
   Device *device = (Device *)data;
@@ -91,6 +139,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
     device->execute(work);
     delete work;
+    work_package_finished();
   }
 
   return nullptr;
@@ -100,34 +149,53 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 {
   WorkPackage *package = new WorkPackage(group, chunkNumber);
+  BLI_mutex_lock(&g_progress_mutex);
+  g_packages_scheduled++;
+  BLI_mutex_unlock(&g_progress_mutex);
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
   CPUDevice device(0);
   device.execute(package);
   delete package;
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+  work_package_finished();
+#else
 #  ifdef COM_OPENCL_ENABLED
   if (group->isOpenCL() && g_openclActive) {
     BLI_thread_queue_push(g_gpuqueue, package);
+    return;
   }
-  else {
-    BLI_thread_queue_push(g_cpuqueue, package);
-  }
-#  else
+#  endif
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   BLI_thread_queue_push(g_cpuqueue, package);
+#  elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  BLI_task_pool_push(g_cpupool, thread_execute_cpu_task, package, false, nullptr);
 #  endif
 #endif
 }
 
 void WorkScheduler::start(CompositorContext &context)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+  if (!g_progress_initialized) {
+    BLI_condition_init(&g_progress_cond);
+    g_progress_initialized = true;
+  }
+  g_packages_scheduled = 0;
+  g_packages_finished = 0;
+  g_packages_finished_seen = 0;
+
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
   unsigned int index;
+#endif
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   g_cpuqueue = BLI_thread_queue_init();
   BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
   for (index = 0; index < g_cpudevices.size(); index++) {
     Device *device = g_cpudevices[index];
     BLI_threadpool_insert(&g_cputhreads, device);
   }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  g_cpupool = BLI_task_pool_create(nullptr, TASK_PRIORITY_HIGH);
+#endif
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   if (context.getHasActiveOpenCLDevices()) {
     g_gpuqueue = BLI_thread_queue_init();
@@ -146,19 +214,28 @@ void WorkScheduler::start(CompositorContext &context)
 }
 void WorkScheduler::finish()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_wait_finish(g_gpuqueue);
-    BLI_thread_queue_wait_finish(g_cpuqueue);
   }
-  else {
-    BLI_thread_queue_wait_finish(g_cpuqueue);
-  }
-#  else
-  BLI_thread_queue_wait_finish(cpuqueue);
 #  endif
 #endif
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+  BLI_thread_queue_wait_finish(g_cpuqueue);
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  BLI_task_pool_work_and_wait(g_cpupool);
+#endif
+}
+void WorkScheduler::wait_for_progress()
+{
+  BLI_mutex_lock(&g_progress_mutex);
+  while (g_packages_finished == g_packages_finished_seen &&
+         g_packages_finished != g_packages_scheduled) {
+    BLI_condition_wait(&g_progress_cond, &g_progress_mutex);
+  }
+  g_packages_finished_seen = g_packages_finished;
+  BLI_mutex_unlock(&g_progress_mutex);
 }
 void WorkScheduler::stop()
 {
@@ -167,6 +244,12 @@ void WorkScheduler::stop()
   BLI_threadpool_end(&g_cputhreads);
   BLI_thread_queue_free(g_cpuqueue);
   g_cpuqueue = nullptr;
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  BLI_task_pool_work_and_wait(g_cpupool);
+  BLI_task_pool_free(g_cpupool);
+  g_cpupool = nullptr;
+#endif
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_nowait(g_gpuqueue);
@@ -180,7 +263,7 @@ void WorkScheduler::stop()
 
 bool WorkScheduler::hasGPUDevices()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   return !g_gpudevices.empty();
 #  else
@@ -191,7 +274,7 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -230,7 +313,16 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
     BLI_thread_local_create(g_thread_device);
     g_cpuInitialized = true;
   }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /* The task scheduler owns the worker threads, devices are created per work package. */
+  UNUSED_VARS(num_cpu_threads);
+  if (!g_cpuInitialized) {
+    BLI_thread_local_create(g_thread_device);
+    g_cpuInitialized = true;
+  }
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   /* deinitialize OpenCL GPU's */
   if (use_opencl && !g_openclInitialized) {
@@ -338,7 +430,14 @@ void WorkScheduler::deinitialize()
     BLI_thread_local_delete(g_thread_device);
     g_cpuInitialized = false;
   }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  if (g_cpuInitialized) {
+    BLI_thread_local_delete(g_thread_device);
+    g_cpuInitialized = false;
+  }
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   /* deinitialize OpenCL GPU's */
   if (g_openclInitialized) {
@@ -20,6 +20,7 @@
 
 #include "COM_ExecutionGroup.h"
 
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "COM_Device.h"
@@ -42,7 +43,15 @@ class WorkScheduler {
    * inside this loop new work is queried and being executed
    */
   static void *thread_execute_cpu(void *data);
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /**
+   * \brief task for a single work package
+   * executed by whichever worker thread of the task scheduler picks it up.
+   */
+  static void thread_execute_cpu_task(TaskPool *__restrict pool, void *data);
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
   /**
    * \brief main thread loop for gpudevices
    * inside this loop new work is queried and being executed
@@ -101,6 +110,13 @@ class WorkScheduler {
    */
   static void finish();
 
+  /**
+   * \brief wait until at least one work package finished since the previous call.
+   * Returns immediately when no scheduled work is pending. This allows the caller to schedule
+   * chunks whose dependencies just became available without waiting for all work to finish.
+   */
+  static void wait_for_progress();
+
   /**
    * \brief Are there OpenCL capable GPU devices initialized?
    * the result of this method is stored in the CompositorContext
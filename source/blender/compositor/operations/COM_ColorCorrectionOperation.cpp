@@ -26,6 +26,7 @@ ColorCorrectionOperation::ColorCorrectionOperation()
   this->addInputSocket(COM_DT_COLOR);
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_COLOR);
+  this->setBufferExecution(true);
   this->m_inputImage = nullptr;
   this->m_inputMask = nullptr;
   this->m_redChannelEnabled = true;
@@ -57,6 +58,30 @@ void ColorCorrectionOperation::executePixelSampled(float output[4],
   this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
   this->m_inputMask->readSampled(inputMask, x, y, sampler);
 
+  correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+void ColorCorrectionOperation::updateMemoryBuffer(MemoryBuffer *output,
+                                                  rcti *area,
+                                                  MemoryBuffer **inputs)
+{
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    const float *color = inputs[0]->getElem(area->xmin, y);
+    const float *mask = inputs[1]->getElem(area->xmin, y);
+    for (int x = area->xmin; x < area->xmax; x++) {
+      correctPixel(out, color, *mask);
+      out += 4;
+      color += 4;
+      mask++;
+    }
+  }
+}
+
+void ColorCorrectionOperation::correctPixel(float output[4],
+                                            const float inputImageColor[4],
+                                            const float mask)
+{
   float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
   float contrast = this->m_data->master.contrast;
   float saturation = this->m_data->master.saturation;
@@ -65,8 +90,7 @@ void ColorCorrectionOperation::executePixelSampled(float output[4],
   float lift = this->m_data->master.lift;
   float r, g, b;
 
-  float value = inputMask[0];
-  value = min(1.0f, value);
+  float value = min(1.0f, mask);
   const float mvalue = 1.0f - value;
 
   float levelShadows = 0.0;
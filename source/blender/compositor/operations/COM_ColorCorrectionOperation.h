@@ -33,6 +33,11 @@ class ColorCorrectionOperation : public NodeOperation {
   bool m_greenChannelEnabled;
   bool m_blueChannelEnabled;
 
+  /**
+   * Correct a single pixel, shared by the pixel and the buffer execution.
+   */
+  void correctPixel(float output[4], const float inputImageColor[4], const float mask);
+
  public:
   ColorCorrectionOperation();
 
@@ -41,6 +46,8 @@ class ColorCorrectionOperation : public NodeOperation {
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 
+  void updateMemoryBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
   /**
    * Initialize the execution
    */
@@ -192,11 +192,24 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   }
 #endif
 
+  MemoryBuffer *imageBuffer = nullptr;
+#if COM_CURRENT_EXECUTION_MODEL == COM_EM_BUFFER
+  rcti inputRect;
+  BLI_rcti_init(&inputRect, x1 + dx, x2 + dx, y1 + dy, y2 + dy);
+  imageBuffer = new MemoryBuffer(COM_DT_COLOR, &inputRect);
+  this->getInputOperation(0)->renderArea(imageBuffer, &inputRect);
+#endif
+
   for (y = y1; y < y2 && (!breaked); y++) {
     for (x = x1; x < x2 && (!breaked); x++) {
       int input_x = x + dx, input_y = y + dy;
 
-      this->m_imageInput->readSampled(color, input_x, input_y, COM_PS_NEAREST);
+      if (imageBuffer) {
+        copy_v4_v4(color, imageBuffer->getElem(input_x, input_y));
+      }
+      else {
+        this->m_imageInput->readSampled(color, input_x, input_y, COM_PS_NEAREST);
+      }
       if (this->m_useAlphaInput) {
         this->m_alphaInput->readSampled(&(color[3]), input_x, input_y, COM_PS_NEAREST);
       }
@@ -214,6 +227,7 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
     offset += add;
     offset4 += add * COM_NUM_CHANNELS_COLOR;
   }
+  delete imageBuffer;
 }
 
 void CompositorOperation::determineResolution(unsigned int resolution[2],
@@ -71,6 +71,27 @@ void MathBaseOperation::clampIfNeeded(float *color)
   }
 }
 
+void MathBaseOperation::clampRowIfNeeded(float *row, int width)
+{
+  if (this->m_useClamp) {
+    for (int i = 0; i < width; i++) {
+      CLAMP(row[i], 0.0f, 1.0f);
+    }
+  }
+}
+
+void MathBaseOperation::updateMemoryBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    this->updateRow(output->getElem(area->xmin, y),
+                    inputs[0]->getElem(area->xmin, y),
+                    inputs[1]->getElem(area->xmin, y),
+                    inputs[2]->getElem(area->xmin, y),
+                    width);
+  }
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
   float inputValue1[4];
@@ -84,6 +105,19 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+void MathAddOperation::updateRow(float *output,
+                                 const float *input1,
+                                 const float *input2,
+                                 const float * /*input3*/,
+                                 int width)
+{
+  for (int i = 0; i < width; i++) {
+    output[i] = input1[i] + input2[i];
+  }
+
+  clampRowIfNeeded(output, width);
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -100,6 +134,19 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathSubtractOperation::updateRow(float *output,
+                                      const float *input1,
+                                      const float *input2,
+                                      const float * /*input3*/,
+                                      int width)
+{
+  for (int i = 0; i < width; i++) {
+    output[i] = input1[i] - input2[i];
+  }
+
+  clampRowIfNeeded(output, width);
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -116,6 +163,19 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::updateRow(float *output,
+                                      const float *input1,
+                                      const float *input2,
+                                      const float * /*input3*/,
+                                      int width)
+{
+  for (int i = 0; i < width; i++) {
+    output[i] = input1[i] * input2[i];
+  }
+
+  clampRowIfNeeded(output, width);
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -137,6 +197,20 @@ void MathDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathDivideOperation::updateRow(float *output,
+                                    const float *input1,
+                                    const float *input2,
+                                    const float * /*input3*/,
+                                    int width)
+{
+  for (int i = 0; i < width; i++) {
+    /* We don't want to divide by zero. */
+    output[i] = (input2[i] == 0) ? 0.0f : input1[i] / input2[i];
+  }
+
+  clampRowIfNeeded(output, width);
+}
+
 void MathSineOperation::executePixelSampled(float output[4],
                                             float x,
                                             float y,
@@ -356,6 +430,19 @@ void MathMinimumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMinimumOperation::updateRow(float *output,
+                                     const float *input1,
+                                     const float *input2,
+                                     const float * /*input3*/,
+                                     int width)
+{
+  for (int i = 0; i < width; i++) {
+    output[i] = min(input1[i], input2[i]);
+  }
+
+  clampRowIfNeeded(output, width);
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4],
                                                float x,
                                                float y,
@@ -372,6 +459,19 @@ void MathMaximumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMaximumOperation::updateRow(float *output,
+                                     const float *input1,
+                                     const float *input2,
+                                     const float * /*input3*/,
+                                     int width)
+{
+  for (int i = 0; i < width; i++) {
+    output[i] = max(input1[i], input2[i]);
+  }
+
+  clampRowIfNeeded(output, width);
+}
+
 void MathRoundOperation::executePixelSampled(float output[4],
                                              float x,
                                              float y,
@@ -42,6 +42,19 @@ class MathBaseOperation : public NodeOperation {
   MathBaseOperation();
 
   void clampIfNeeded(float color[4]);
+  void clampRowIfNeeded(float *row, int width);
+
+  /**
+   * \brief calculate a row of values for #updateMemoryBuffer
+   * Subclasses that implement this enable buffer execution in their constructor.
+   */
+  virtual void updateRow(float * /*output*/,
+                         const float * /*input1*/,
+                         const float * /*input2*/,
+                         const float * /*input3*/,
+                         int /*width*/)
+  {
+  }
 
  public:
   /**
@@ -64,6 +77,8 @@ class MathBaseOperation : public NodeOperation {
    */
   void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 
+  void updateMemoryBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
   void setUseClamp(bool value)
   {
     this->m_useClamp = value;
@@ -74,29 +89,53 @@ class MathAddOperation : public MathBaseOperation {
  public:
   MathAddOperation() : MathBaseOperation()
   {
+    this->setBufferExecution(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *input1,
+                 const float *input2,
+                 const float *input3,
+                 int width);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
   MathSubtractOperation() : MathBaseOperation()
   {
+    this->setBufferExecution(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *input1,
+                 const float *input2,
+                 const float *input3,
+                 int width);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
   MathMultiplyOperation() : MathBaseOperation()
   {
+    this->setBufferExecution(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *input1,
+                 const float *input2,
+                 const float *input3,
+                 int width);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
   MathDivideOperation() : MathBaseOperation()
   {
+    this->setBufferExecution(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *input1,
+                 const float *input2,
+                 const float *input3,
+                 int width);
 };
 class MathSineOperation : public MathBaseOperation {
  public:
@@ -181,15 +220,27 @@ class MathMinimumOperation : public MathBaseOperation {
  public:
   MathMinimumOperation() : MathBaseOperation()
   {
+    this->setBufferExecution(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *input1,
+                 const float *input2,
+                 const float *input3,
+                 int width);
 };
 class MathMaximumOperation : public MathBaseOperation {
  public:
   MathMaximumOperation() : MathBaseOperation()
   {
+    this->setBufferExecution(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *input1,
+                 const float *input2,
+                 const float *input3,
+                 int width);
 };
 class MathRoundOperation : public MathBaseOperation {
  public:
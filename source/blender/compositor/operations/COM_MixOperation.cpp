@@ -88,6 +88,18 @@ void MixBaseOperation::determineResolution(unsigned int resolution[2],
   NodeOperation::determineResolution(resolution, preferredResolution);
 }
 
+void MixBaseOperation::updateMemoryBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    this->updateRow(output->getElem(area->xmin, y),
+                    inputs[0]->getElem(area->xmin, y),
+                    inputs[1]->getElem(area->xmin, y),
+                    inputs[2]->getElem(area->xmin, y),
+                    width);
+  }
+}
+
 void MixBaseOperation::deinitExecution()
 {
   this->m_inputValueOperation = nullptr;
@@ -99,7 +111,7 @@ void MixBaseOperation::deinitExecution()
 
 MixAddOperation::MixAddOperation()
 {
-  /* pass */
+  this->setBufferExecution(true);
 }
 
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -124,11 +136,37 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+void MixAddOperation::updateRow(float *output,
+                                const float *values,
+                                const float *color1,
+                                const float *color2,
+                                int width)
+{
+  float *row = output;
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int i = 0; i < width; i++) {
+    float value = values[i];
+    if (value_alpha_multiply) {
+      value *= color2[3];
+    }
+    output[0] = color1[0] + value * color2[0];
+    output[1] = color1[1] + value * color2[1];
+    output[2] = color1[2] + value * color2[2];
+    output[3] = color1[3];
+
+    output += 4;
+    color1 += 4;
+    color2 += 4;
+  }
+
+  clampRowIfNeeded(row, width);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation()
 {
-  /* pass */
+  this->setBufferExecution(true);
 }
 
 void MixBlendOperation::executePixelSampled(float output[4],
@@ -158,6 +196,33 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixBlendOperation::updateRow(float *output,
+                                  const float *values,
+                                  const float *color1,
+                                  const float *color2,
+                                  int width)
+{
+  float *row = output;
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int i = 0; i < width; i++) {
+    float value = values[i];
+    if (value_alpha_multiply) {
+      value *= color2[3];
+    }
+    const float valuem = 1.0f - value;
+    output[0] = valuem * (color1[0]) + value * (color2[0]);
+    output[1] = valuem * (color1[1]) + value * (color2[1]);
+    output[2] = valuem * (color1[2]) + value * (color2[2]);
+    output[3] = color1[3];
+
+    output += 4;
+    color1 += 4;
+    color2 += 4;
+  }
+
+  clampRowIfNeeded(row, width);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixColorBurnOperation::MixColorBurnOperation()
@@ -323,7 +388,7 @@ void MixDarkenOperation::executePixelSampled(float output[4],
 
 MixDifferenceOperation::MixDifferenceOperation()
 {
-  /* pass */
+  this->setBufferExecution(true);
 }
 
 void MixDifferenceOperation::executePixelSampled(float output[4],
@@ -352,6 +417,33 @@ void MixDifferenceOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixDifferenceOperation::updateRow(float *output,
+                                       const float *values,
+                                       const float *color1,
+                                       const float *color2,
+                                       int width)
+{
+  float *row = output;
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int i = 0; i < width; i++) {
+    float value = values[i];
+    if (value_alpha_multiply) {
+      value *= color2[3];
+    }
+    const float valuem = 1.0f - value;
+    output[0] = valuem * color1[0] + value * fabsf(color1[0] - color2[0]);
+    output[1] = valuem * color1[1] + value * fabsf(color1[1] - color2[1]);
+    output[2] = valuem * color1[2] + value * fabsf(color1[2] - color2[2]);
+    output[3] = color1[3];
+
+    output += 4;
+    color1 += 4;
+    color2 += 4;
+  }
+
+  clampRowIfNeeded(row, width);
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation()
@@ -676,7 +768,7 @@ void MixLinearLightOperation::executePixelSampled(float output[4],
 
 MixMultiplyOperation::MixMultiplyOperation()
 {
-  /* pass */
+  this->setBufferExecution(true);
 }
 
 void MixMultiplyOperation::executePixelSampled(float output[4],
@@ -705,6 +797,33 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::updateRow(float *output,
+                                     const float *values,
+                                     const float *color1,
+                                     const float *color2,
+                                     int width)
+{
+  float *row = output;
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int i = 0; i < width; i++) {
+    float value = values[i];
+    if (value_alpha_multiply) {
+      value *= color2[3];
+    }
+    const float valuem = 1.0f - value;
+    output[0] = color1[0] * (valuem + value * color2[0]);
+    output[1] = color1[1] * (valuem + value * color2[1]);
+    output[2] = color1[2] * (valuem + value * color2[2]);
+    output[3] = color1[3];
+
+    output += 4;
+    color1 += 4;
+    color2 += 4;
+  }
+
+  clampRowIfNeeded(row, width);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation()
@@ -801,7 +920,7 @@ void MixSaturationOperation::executePixelSampled(float output[4],
 
 MixScreenOperation::MixScreenOperation()
 {
-  /* pass */
+  this->setBufferExecution(true);
 }
 
 void MixScreenOperation::executePixelSampled(float output[4],
@@ -831,6 +950,33 @@ void MixScreenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixScreenOperation::updateRow(float *output,
+                                   const float *values,
+                                   const float *color1,
+                                   const float *color2,
+                                   int width)
+{
+  float *row = output;
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int i = 0; i < width; i++) {
+    float value = values[i];
+    if (value_alpha_multiply) {
+      value *= color2[3];
+    }
+    const float valuem = 1.0f - value;
+    output[0] = 1.0f - (valuem + value * (1.0f - color2[0])) * (1.0f - color1[0]);
+    output[1] = 1.0f - (valuem + value * (1.0f - color2[1])) * (1.0f - color1[1]);
+    output[2] = 1.0f - (valuem + value * (1.0f - color2[2])) * (1.0f - color1[2]);
+    output[3] = color1[3];
+
+    output += 4;
+    color1 += 4;
+    color2 += 4;
+  }
+
+  clampRowIfNeeded(row, width);
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation()
@@ -881,7 +1027,7 @@ void MixSoftLightOperation::executePixelSampled(float output[4],
 
 MixSubtractOperation::MixSubtractOperation()
 {
-  /* pass */
+  this->setBufferExecution(true);
 }
 
 void MixSubtractOperation::executePixelSampled(float output[4],
@@ -909,6 +1055,32 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixSubtractOperation::updateRow(float *output,
+                                     const float *values,
+                                     const float *color1,
+                                     const float *color2,
+                                     int width)
+{
+  float *row = output;
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int i = 0; i < width; i++) {
+    float value = values[i];
+    if (value_alpha_multiply) {
+      value *= color2[3];
+    }
+    output[0] = color1[0] - value * (color2[0]);
+    output[1] = color1[1] - value * (color2[1]);
+    output[2] = color1[2] - value * (color2[2]);
+    output[3] = color1[3];
+
+    output += 4;
+    color1 += 4;
+    color2 += 4;
+  }
+
+  clampRowIfNeeded(row, width);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation()
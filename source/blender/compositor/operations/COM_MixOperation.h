@@ -43,6 +43,29 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  inline void clampRowIfNeeded(float *row, int width)
+  {
+    if (m_useClamp) {
+      for (int i = 0; i < width; i++) {
+        clamp_v4(&row[i * 4], 0.0f, 1.0f);
+      }
+    }
+  }
+
+  /**
+   * \brief calculate a row of pixels for #updateMemoryBuffer
+   * Subclasses that implement this enable buffer execution in their constructor.
+   * \param values: row of single channel mix factors.
+   * \param color1, color2: rows of RGBA colors.
+   */
+  virtual void updateRow(float * /*output*/,
+                         const float * /*values*/,
+                         const float * /*color1*/,
+                         const float * /*color2*/,
+                         int /*width*/)
+  {
+  }
+
  public:
   /**
    * Default constructor
@@ -66,6 +89,8 @@ class MixBaseOperation : public NodeOperation {
 
   void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 
+  void updateMemoryBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
   void setUseValueAlphaMultiply(const bool value)
   {
     this->m_valueAlphaMultiply = value;
@@ -84,12 +109,22 @@ class MixAddOperation : public MixBaseOperation {
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *values,
+                 const float *color1,
+                 const float *color2,
+                 int width);
 };
 
 class MixBlendOperation : public MixBaseOperation {
  public:
   MixBlendOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *values,
+                 const float *color1,
+                 const float *color2,
+                 int width);
 };
 
 class MixColorBurnOperation : public MixBaseOperation {
@@ -114,6 +149,11 @@ class MixDifferenceOperation : public MixBaseOperation {
  public:
   MixDifferenceOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *values,
+                 const float *color1,
+                 const float *color2,
+                 int width);
 };
 
 class MixDivideOperation : public MixBaseOperation {
@@ -156,6 +196,11 @@ class MixMultiplyOperation : public MixBaseOperation {
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *values,
+                 const float *color1,
+                 const float *color2,
+                 int width);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +219,11 @@ class MixScreenOperation : public MixBaseOperation {
  public:
   MixScreenOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *values,
+                 const float *color1,
+                 const float *color2,
+                 int width);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +236,11 @@ class MixSubtractOperation : public MixBaseOperation {
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void updateRow(float *output,
+                 const float *values,
+                 const float *color1,
+                 const float *color2,
+                 int width);
 };
 
 class MixValueOperation : public MixBaseOperation {
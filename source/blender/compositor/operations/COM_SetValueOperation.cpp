@@ -21,6 +21,7 @@
 SetValueOperation::SetValueOperation()
 {
   this->addOutputSocket(COM_DT_VALUE);
+  this->setBufferExecution(true);
 }
 
 void SetValueOperation::executePixelSampled(float output[4],
@@ -31,6 +32,18 @@ void SetValueOperation::executePixelSampled(float output[4],
   output[0] = this->m_value;
 }
 
+void SetValueOperation::updateMemoryBuffer(MemoryBuffer *output,
+                                       rcti *area,
+                                       MemoryBuffer ** /*inputs*/)
+{
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    for (int x = area->xmin; x < area->xmax; x++) {
+      *out++ = this->m_value;
+    }
+  }
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
@@ -96,9 +96,20 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   int y;
   bool breaked = false;
 
+  MemoryBuffer *imageBuffer = nullptr;
+#if COM_CURRENT_EXECUTION_MODEL == COM_EM_BUFFER
+  imageBuffer = new MemoryBuffer(COM_DT_COLOR, rect);
+  this->getInputOperation(0)->renderArea(imageBuffer, rect);
+#endif
+
   for (y = y1; y < y2 && (!breaked); y++) {
     for (x = x1; x < x2; x++) {
-      this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+      if (imageBuffer) {
+        copy_v4_v4(&buffer[offset4], imageBuffer->getElem(x, y));
+      }
+      else {
+        this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+      }
       if (this->m_useAlphaInput) {
         this->m_alphaInput->readSampled(alpha, x, y, COM_PS_NEAREST);
         buffer[offset4 + 3] = alpha[0];
@@ -115,6 +126,7 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
     offset += offsetadd;
     offset4 += offsetadd4;
   }
+  delete imageBuffer;
   updateImage(rect);
 }
 
@@ -86,6 +86,10 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
     }
   }
   else {
+#if COM_CURRENT_EXECUTION_MODEL == COM_EM_BUFFER
+    /* Like the loop below, renderArea stops after the current row when execution is braked. */
+    this->m_input->renderArea(memoryBuffer, rect);
+#else
     int x1 = rect->xmin;
     int y1 = rect->ymin;
     int x2 = rect->xmax;
@@ -104,6 +108,7 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
         breaked = true;
       }
     }
+#endif
   }
   memoryBuffer->setCreatedState();
 }
@@ -47,6 +47,7 @@
 #include "intern/depsgraph_update.h"
 
 #include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/eval/deg_eval_schedule.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -232,6 +233,7 @@ void Depsgraph::add_entry_tag(OperationNode *node)
 
 void Depsgraph::clear_all_nodes()
 {
+  schedule.reset();
   clear_id_nodes();
   delete time_source;
   time_source = nullptr;
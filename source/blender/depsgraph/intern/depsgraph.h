@@ -52,6 +52,7 @@ struct ViewLayer;
 namespace blender {
 namespace deg {
 
+struct EvaluationSchedule;
 struct IDNode;
 struct Node;
 struct OperationNode;
@@ -127,6 +128,9 @@ struct Depsgraph {
   /* All operation nodes, sorted in order of single-thread traversal order. */
   OperationNodes operations;
 
+  /* Scheduling state of the operations, built on evaluation after relations were updated. */
+  unique_ptr<EvaluationSchedule> schedule;
+
   /* Spin lock for threading-critical operations.
    * Mainly used by graph evaluation. */
   SpinLock lock;
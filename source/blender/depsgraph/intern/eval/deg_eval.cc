@@ -29,7 +29,9 @@
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
+#include "BLI_heap.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -47,6 +49,7 @@
 #include "intern/depsgraph_relation.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_schedule.h"
 #include "intern/eval/deg_eval_stats.h"
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -56,6 +59,11 @@
 
 namespace blender::deg {
 
+/* Operation timings used to prioritize the critical path are only gathered in the first
+ * evaluation after relations were updated and then every this many evaluations, unless the
+ * statistics are enabled. */
+#define DEG_EVAL_TIMING_SAMPLE_INTERVAL 64
+
 namespace {
 
 struct DepsgraphEvalState;
@@ -64,14 +72,11 @@ void deg_task_run_func(TaskPool *pool, void *taskdata);
 
 template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_children(DepsgraphEvalState *state,
-                       OperationNode *node,
+                       const int operation_index,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args);
 
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
-{
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-}
+void schedule_node_to_pool(OperationNode *node, const int thread_id, TaskPool *pool);
 
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
@@ -92,9 +97,19 @@ enum class EvaluationStage {
 
 struct DepsgraphEvalState {
   Depsgraph *graph;
+  EvaluationSchedule *schedule;
   bool do_stats;
+  /* Gather timing of operations, either for statistics or to update the critical path. */
+  bool do_timing;
+  bool update_critical_path;
   EvaluationStage stage;
   bool need_single_thread_pass;
+
+  /* Operations which are ready to be evaluated, ordered by their critical path time so that
+   * the longest chains of operations are started first. Every task pushed to the pool
+   * evaluates the operation with the highest priority at the time it runs. */
+  Heap *ready_operations;
+  SpinLock ready_operations_lock;
 };
 
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
@@ -104,7 +119,7 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
   /* Perform operation. */
-  if (state->do_stats) {
+  if (state->do_timing) {
     const double start_time = PIL_check_seconds_timer();
     operation_node->evaluate(depsgraph);
     operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
@@ -114,106 +129,63 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   }
 }
 
-void deg_task_run_func(TaskPool *pool, void *taskdata)
+void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+  /* Heap is sorted by the smallest value first. */
+  BLI_spin_lock(&state->ready_operations_lock);
+  BLI_heap_insert(state->ready_operations, (float)-node->critical_path_time, node);
+  BLI_spin_unlock(&state->ready_operations_lock);
+
+  BLI_task_pool_push(pool, deg_task_run_func, nullptr, false, nullptr);
+}
+
+void deg_task_run_func(TaskPool *pool, void *UNUSED(taskdata))
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
+  /* Every task evaluates a single operation, not necessarily the one it was pushed for. */
+  BLI_spin_lock(&state->ready_operations_lock);
+  OperationNode *operation_node = (OperationNode *)BLI_heap_pop_min(state->ready_operations);
+  BLI_spin_unlock(&state->ready_operations_lock);
+
   /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
-  schedule_children(state, operation_node, schedule_node_to_pool, pool);
-}
-
-bool check_operation_node_visible(OperationNode *op_node)
-{
-  const ComponentNode *comp_node = op_node->owner;
-  /* Special exception, copy on write component is to be always evaluated,
-   * to keep copied "database" in a consistent state. */
-  if (comp_node->type == NodeType::COPY_ON_WRITE) {
-    return true;
-  }
-  return comp_node->affects_directly_visible;
-}
-
-void calculate_pending_parents_for_node(OperationNode *node)
-{
-  /* Update counters, applies for both visible and invisible IDs. */
-  node->num_links_pending = 0;
-  node->scheduled = false;
-  /* Invisible IDs requires no pending operations. */
-  if (!check_operation_node_visible(node)) {
-    return;
-  }
-  /* No need to bother with anything if node is not tagged for update. */
-  if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-    return;
-  }
-  for (Relation *rel : node->inlinks) {
-    if (rel->from->type == NodeType::OPERATION && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
-      OperationNode *from = (OperationNode *)rel->from;
-      /* TODO(sergey): This is how old layer system was checking for the
-       * calculation, but how is it possible that visible object depends
-       * on an invisible? This is something what is prohibited after
-       * deg_graph_build_flush_layers(). */
-      if (!check_operation_node_visible(from)) {
-        continue;
-      }
-      /* No need to wait for operation which is up to date. */
-      if ((from->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-        continue;
-      }
-      ++node->num_links_pending;
-    }
-  }
-}
-
-void calculate_pending_parents(Depsgraph *graph)
-{
-  for (OperationNode *node : graph->operations) {
-    calculate_pending_parents_for_node(node);
-  }
+  schedule_children(state, operation_node->index, schedule_node_to_pool, pool);
 }
 
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
-  const bool do_stats = state->do_stats;
-  calculate_pending_parents(graph);
+  /* Calculate pending parents and clear scheduling state. */
+  EvaluationSchedule *schedule = deg_eval_schedule_prepare(graph);
+  state->schedule = schedule;
+  state->update_critical_path = schedule->num_evaluations % DEG_EVAL_TIMING_SAMPLE_INTERVAL == 0;
+  state->do_timing = state->do_stats || state->update_critical_path;
   /* Clear tags and other things which needs to be clear. */
-  for (OperationNode *node : graph->operations) {
-    if (do_stats) {
+  if (state->do_timing) {
+    for (OperationNode *node : graph->operations) {
       node->stats.reset_current();
     }
   }
 }
 
-bool is_metaball_object_operation(const OperationNode *operation_node)
+bool need_evaluate_operation_at_stage(DepsgraphEvalState *state, const int operation_index)
 {
-  const ComponentNode *component_node = operation_node->owner;
-  const IDNode *id_node = component_node->owner;
-  if (GS(id_node->id_cow->name) != ID_OB) {
-    return false;
-  }
-  const Object *object = reinterpret_cast<const Object *>(id_node->id_cow);
-  return object->type == OB_MBALL;
-}
-
-bool need_evaluate_operation_at_stage(DepsgraphEvalState *state,
-                                      const OperationNode *operation_node)
-{
-  const ComponentNode *component_node = operation_node->owner;
+  const uint8_t flags = state->schedule->flags[operation_index];
   switch (state->stage) {
     case EvaluationStage::COPY_ON_WRITE:
-      return (component_node->type == NodeType::COPY_ON_WRITE);
+      return (flags & SCHEDULE_OPERATION_COPY_ON_WRITE);
 
     case EvaluationStage::THREADED_EVALUATION:
       /* Sanity check: copy-on-write node should be evaluated already. This will be indicated by
        * scheduled flag (we assume that scheduled operations have been actually handled by previous
        * stage). */
-      BLI_assert(operation_node->scheduled || component_node->type != NodeType::COPY_ON_WRITE);
-      if (is_metaball_object_operation(operation_node)) {
+      BLI_assert(state->schedule->scheduled[operation_index] ||
+                 (flags & SCHEDULE_OPERATION_COPY_ON_WRITE) == 0);
+      if (flags & SCHEDULE_OPERATION_METABALL) {
         state->need_single_thread_pass = true;
         return false;
       }
@@ -232,45 +204,42 @@ bool need_evaluate_operation_at_stage(DepsgraphEvalState *state,
  */
 template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_node(DepsgraphEvalState *state,
-                   OperationNode *node,
+                   const int operation_index,
                    bool dec_parents,
                    ScheduleFunction *schedule_function,
                    ScheduleFunctionArgs... schedule_function_args)
 {
-  /* No need to schedule nodes of invisible ID. */
-  if (!check_operation_node_visible(node)) {
+  EvaluationSchedule *schedule = state->schedule;
+  /* No need to schedule operations of invisible IDs or which are not tagged for update, they
+   * are considered to be up to date. */
+  if (!schedule->needs_evaluation[operation_index]) {
     return;
   }
-  /* No need to schedule operations which are not tagged for update, they are
-   * considered to be up to date. */
-  if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-    return;
-  }
-  /* TODO(sergey): This is not strictly speaking safe to read
-   * num_links_pending. */
+  /* Can not schedule operation while its dependencies are not yet evaluated. */
   if (dec_parents) {
-    BLI_assert(node->num_links_pending > 0);
-    atomic_sub_and_fetch_uint32(&node->num_links_pending, 1);
+    BLI_assert(schedule->num_links_pending[operation_index] > 0);
+    if (atomic_sub_and_fetch_uint32(&schedule->num_links_pending[operation_index], 1) != 0) {
+      return;
+    }
   }
-  /* Cal not schedule operation while its dependencies are not yet
-   * evaluated. */
-  if (node->num_links_pending != 0) {
+  else if (schedule->num_links_pending[operation_index] != 0) {
     return;
   }
   /* During the COW stage only schedule COW nodes. */
-  if (!need_evaluate_operation_at_stage(state, node)) {
+  if (!need_evaluate_operation_at_stage(state, operation_index)) {
     return;
   }
   /* Actually schedule the node. */
-  bool is_scheduled = atomic_fetch_and_or_uint8((uint8_t *)&node->scheduled, (uint8_t) true);
+  bool is_scheduled = atomic_fetch_and_or_uint8(&schedule->scheduled[operation_index],
+                                                (uint8_t) true);
   if (!is_scheduled) {
-    if (node->is_noop()) {
+    if (schedule->flags[operation_index] & SCHEDULE_OPERATION_NOOP) {
       /* skip NOOP node, schedule children right away */
-      schedule_children(state, node, schedule_function, schedule_function_args...);
+      schedule_children(state, operation_index, schedule_function, schedule_function_args...);
     }
     else {
       /* children are scheduled once this task is completed */
-      schedule_function(node, 0, schedule_function_args...);
+      schedule_function(state->graph->operations[operation_index], 0, schedule_function_args...);
     }
   }
 }
@@ -280,27 +249,28 @@ void schedule_graph(DepsgraphEvalState *state,
                     ScheduleFunction *schedule_function,
                     ScheduleFunctionArgs... schedule_function_args)
 {
-  for (OperationNode *node : state->graph->operations) {
-    schedule_node(state, node, false, schedule_function, schedule_function_args...);
+  for (const int operation_index : state->graph->operations.index_range()) {
+    schedule_node(state, operation_index, false, schedule_function, schedule_function_args...);
   }
 }
 
 template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_children(DepsgraphEvalState *state,
-                       OperationNode *node,
+                       const int operation_index,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args)
 {
-  for (Relation *rel : node->outlinks) {
-    OperationNode *child = (OperationNode *)rel->to;
-    BLI_assert(child->type == NodeType::OPERATION);
-    if (child->scheduled) {
+  const EvaluationSchedule *schedule = state->schedule;
+  const int children_end = schedule->children_offsets[operation_index + 1];
+  for (int i = schedule->children_offsets[operation_index]; i < children_end; i++) {
+    const ScheduleChild &child = schedule->children[i];
+    if (schedule->scheduled[child.operation_index]) {
       /* Happens when having cyclic dependencies. */
       continue;
     }
     schedule_node(state,
-                  child,
-                  (rel->flag & RELATION_FLAG_CYCLIC) == 0,
+                  child.operation_index,
+                  !child.is_cyclic,
                   schedule_function,
                   schedule_function_args...);
   }
@@ -323,7 +293,7 @@ void evaluate_graph_single_threaded(DepsgraphEvalState *state)
     BLI_gsqueue_pop(evaluation_queue, &operation_node);
 
     evaluate_node(state, operation_node);
-    schedule_children(state, operation_node, schedule_node_to_queue, evaluation_queue);
+    schedule_children(state, operation_node->index, schedule_node_to_queue, evaluation_queue);
   }
 
   BLI_gsqueue_free(evaluation_queue);
@@ -377,8 +347,11 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   /* Set up evaluation state. */
   DepsgraphEvalState state;
   state.graph = graph;
+  state.schedule = nullptr;
   state.do_stats = graph->debug.do_time_debug();
   state.need_single_thread_pass = false;
+  state.ready_operations = BLI_heap_new();
+  BLI_spin_init(&state.ready_operations_lock);
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
 
@@ -402,12 +375,21 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
     evaluate_graph_single_threaded(&state);
   }
 
+  BLI_assert(BLI_heap_is_empty(state.ready_operations));
+  BLI_heap_free(state.ready_operations, nullptr);
+  BLI_spin_end(&state.ready_operations_lock);
+
   /* Finalize statistics gathering. This is because we only gather single
    * operation timing here, without aggregating anything to avoid any extra
    * synchronization. */
   if (state.do_stats) {
     deg_eval_stats_aggregate(graph);
   }
+  /* Update scheduling priorities for the next evaluations, before the tags are cleared. */
+  if (state.update_critical_path) {
+    deg_eval_stats_update_critical_path(graph);
+  }
+  state.schedule->num_evaluations++;
   /* Clear any uncleared tags - just in case. */
   deg_graph_clear_tags(graph);
   graph->is_evaluating = false;
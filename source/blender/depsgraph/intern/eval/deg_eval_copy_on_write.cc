@@ -37,15 +37,19 @@
 
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_curve.h"
+#include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_gpencil.h"
 #include "BKE_idprop.h"
 #include "BKE_layer.h"
 #include "BKE_lib_id.h"
+#include "BKE_mesh.h"
 #include "BKE_scene.h"
 
 #include "DEG_depsgraph.h"
@@ -284,7 +288,7 @@ struct ValidateData {
 
 /* Similar to generic BKE_id_copy() but does not require main and assumes pointer
  * is already allocated. */
-bool id_copy_inplace_no_main(const ID *id, ID *newid)
+bool id_copy_inplace_no_main(const ID *id, ID *newid, const int extra_flag = 0)
 {
   const ID *id_for_copy = id;
 
@@ -304,7 +308,8 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
   bool result = (BKE_id_copy_ex(nullptr,
                                 (ID *)id_for_copy,
                                 &newid,
-                                LIB_ID_COPY_LOCALIZE | LIB_ID_CREATE_NO_ALLOCATE) != nullptr);
+                                LIB_ID_COPY_LOCALIZE | LIB_ID_CREATE_NO_ALLOCATE |
+                                    extra_flag) != nullptr);
 
 #ifdef NESTED_ID_NASTY_WORKAROUND
   if (result) {
@@ -344,6 +349,72 @@ bool scene_copy_inplace_no_main(const Scene *scene, Scene *new_scene)
   return result;
 }
 
+/* Meshes with less elements than this are copied the regular way, the overhead of threading
+ * does not pay off for them. */
+#define MESH_COPY_PARALLEL_MIN_ELEMENTS (1 << 16)
+
+struct MeshLayerDuplicateData {
+  CustomData *data;
+  int layer_index;
+  int totelem;
+};
+
+void mesh_duplicate_referenced_layer_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict /*tls*/)
+{
+  const MeshLayerDuplicateData *layers = (const MeshLayerDuplicateData *)userdata;
+  const MeshLayerDuplicateData &layer_data = layers[i];
+  const CustomDataLayer *layer = &layer_data.data->layers[layer_data.layer_index];
+  const int n = layer_data.layer_index - CustomData_get_layer_index(layer_data.data, layer->type);
+  /* Every layer is handled by a single task, so it is safe to modify it here. */
+  CustomData_duplicate_referenced_layer_n(layer_data.data, layer->type, n, layer_data.totelem);
+}
+
+/* Similar to id_copy_inplace_no_main(), but copies geometry arrays of big meshes in parallel.
+ *
+ * The copy is first done referencing custom data layers of the original mesh, which is cheap,
+ * then every referenced layer gets its own copy from a separate task. The result is the same
+ * as the regular copy, the evaluated mesh never shares arrays with the original one. */
+bool mesh_copy_inplace_no_main(const Mesh *mesh, Mesh *new_mesh)
+{
+  if (mesh->totvert + mesh->totedge + mesh->totloop + mesh->totpoly <
+      MESH_COPY_PARALLEL_MIN_ELEMENTS) {
+    return false;
+  }
+
+  if (!id_copy_inplace_no_main(&mesh->id, &new_mesh->id, LIB_ID_COPY_CD_REFERENCE)) {
+    return false;
+  }
+
+  const bool do_tessface = ((mesh->totface != 0) && (mesh->totpoly == 0));
+  const std::pair<CustomData *, int> domains[] = {
+      {&new_mesh->vdata, new_mesh->totvert},
+      {&new_mesh->edata, new_mesh->totedge},
+      {&new_mesh->ldata, new_mesh->totloop},
+      {&new_mesh->pdata, new_mesh->totpoly},
+      {&new_mesh->fdata, new_mesh->totface},
+  };
+  blender::Vector<MeshLayerDuplicateData> layers;
+  for (const std::pair<CustomData *, int> &domain : domains) {
+    for (int i = 0; i < domain.first->totlayer; i++) {
+      if (domain.first->layers[i].flag & CD_FLAG_NOFREE) {
+        layers.append({domain.first, i, domain.second});
+      }
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(
+      0, layers.size(), layers.data(), mesh_duplicate_referenced_layer_cb, &settings);
+
+  /* Layer pointers were set up for the referenced arrays, point them to the copied ones. */
+  BKE_mesh_update_customdata_pointers(new_mesh, do_tessface);
+
+  return true;
+}
+
 /* For the given scene get view layer which corresponds to an original for the
  * scene's evaluated one. This depends on how the scene is pulled into the
  * dependency  graph. */
@@ -890,6 +961,7 @@ ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
     case ID_ME: {
       /* TODO(sergey): Ideally we want to handle meshes in a special
        * manner here to avoid initial copy of all the geometry arrays. */
+      done = mesh_copy_inplace_no_main((const Mesh *)id_orig, (Mesh *)id_cow);
       break;
     }
     default:
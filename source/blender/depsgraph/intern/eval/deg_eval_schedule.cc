@@ -0,0 +1,150 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_schedule.h"
+
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_ID.h"
+#include "DNA_object_types.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace blender::deg {
+
+namespace {
+
+uint8_t schedule_operation_flags_get(const OperationNode *operation_node)
+{
+  const ComponentNode *component_node = operation_node->owner;
+  uint8_t flags = 0;
+  /* Special exception, copy on write component is to be always evaluated,
+   * to keep copied "database" in a consistent state. */
+  if (component_node->type == NodeType::COPY_ON_WRITE) {
+    flags |= SCHEDULE_OPERATION_VISIBLE | SCHEDULE_OPERATION_COPY_ON_WRITE;
+  }
+  else if (component_node->affects_directly_visible) {
+    flags |= SCHEDULE_OPERATION_VISIBLE;
+  }
+  if (operation_node->is_noop()) {
+    flags |= SCHEDULE_OPERATION_NOOP;
+  }
+  /* Use the original ID, the copy-on-write one might not be expanded yet. */
+  const ID *id_orig = component_node->owner->id_orig;
+  if (GS(id_orig->name) == ID_OB && reinterpret_cast<const Object *>(id_orig)->type == OB_MBALL) {
+    flags |= SCHEDULE_OPERATION_METABALL;
+  }
+  return flags;
+}
+
+EvaluationSchedule *schedule_build(const Depsgraph *graph)
+{
+  const int num_operations = graph->operations.size();
+  EvaluationSchedule *schedule = new EvaluationSchedule();
+  schedule->flags.reinitialize(num_operations);
+  schedule->children_offsets.reinitialize(num_operations + 1);
+  schedule->needs_evaluation.reinitialize(num_operations);
+  schedule->num_links_pending.reinitialize(num_operations);
+  schedule->scheduled.reinitialize(num_operations);
+
+  int num_children = 0;
+  for (const int i : graph->operations.index_range()) {
+    OperationNode *operation_node = graph->operations[i];
+    operation_node->index = i;
+    schedule->flags[i] = schedule_operation_flags_get(operation_node);
+    schedule->children_offsets[i] = num_children;
+    num_children += operation_node->outlinks.size();
+  }
+  schedule->children_offsets[num_operations] = num_children;
+
+  schedule->children.reinitialize(num_children);
+  for (const int i : graph->operations.index_range()) {
+    const OperationNode *operation_node = graph->operations[i];
+    int child_index = schedule->children_offsets[i];
+    for (const Relation *rel : operation_node->outlinks) {
+      BLI_assert(rel->to->type == NodeType::OPERATION);
+      const OperationNode *child = static_cast<const OperationNode *>(rel->to);
+      schedule->children[child_index].operation_index = child->index;
+      schedule->children[child_index].is_cyclic = (rel->flag & RELATION_FLAG_CYCLIC) != 0;
+      child_index++;
+    }
+  }
+
+  return schedule;
+}
+
+void schedule_init_operation_cb(void *__restrict userdata,
+                                const int i,
+                                const TaskParallelTLS *__restrict /*tls*/)
+{
+  Depsgraph *graph = static_cast<Depsgraph *>(userdata);
+  EvaluationSchedule *schedule = graph->schedule.get();
+  const OperationNode *operation_node = graph->operations[i];
+  /* No need to bother with anything if node is not visible or not tagged for update. */
+  schedule->needs_evaluation[i] = (schedule->flags[i] & SCHEDULE_OPERATION_VISIBLE) &&
+                                  (operation_node->flag & DEPSOP_FLAG_NEEDS_UPDATE);
+  schedule->num_links_pending[i] = 0;
+  schedule->scheduled[i] = false;
+}
+
+}  // namespace
+
+EvaluationSchedule *deg_eval_schedule_prepare(Depsgraph *graph)
+{
+  if (graph->schedule == nullptr) {
+    graph->schedule.reset(schedule_build(graph));
+  }
+  EvaluationSchedule *schedule = graph->schedule.get();
+  BLI_assert(schedule->flags.size() == graph->operations.size());
+
+  const int num_operations = graph->operations.size();
+
+  /* Update tags are stored in the operation nodes, gather them from multiple threads. */
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, num_operations, graph, schedule_init_operation_cb, &settings);
+
+  /* Count parents which are to be evaluated, only looking into the schedule arrays. */
+  for (int i = 0; i < num_operations; i++) {
+    if (!schedule->needs_evaluation[i]) {
+      continue;
+    }
+    for (int j = schedule->children_offsets[i]; j < schedule->children_offsets[i + 1]; j++) {
+      const ScheduleChild &child = schedule->children[j];
+      if (!child.is_cyclic && schedule->needs_evaluation[child.operation_index]) {
+        schedule->num_links_pending[child.operation_index]++;
+      }
+    }
+  }
+
+  return schedule;
+}
+
+}  // namespace blender::deg
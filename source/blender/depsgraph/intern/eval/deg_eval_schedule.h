@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+
+#include "intern/depsgraph_type.h"
+
+namespace blender {
+namespace deg {
+
+struct Depsgraph;
+
+/* Static properties of an operation which are used by the scheduler. */
+enum eScheduleOperationFlag {
+  /* Operation belongs to a component which is to be evaluated. */
+  SCHEDULE_OPERATION_VISIBLE = (1 << 0),
+  /* Operation has no callback, its children are scheduled right away. */
+  SCHEDULE_OPERATION_NOOP = (1 << 1),
+  /* Operation belongs to the copy-on-write component. */
+  SCHEDULE_OPERATION_COPY_ON_WRITE = (1 << 2),
+  /* Operation of a meta-ball object, which can not be evaluated from threads. */
+  SCHEDULE_OPERATION_METABALL = (1 << 3),
+};
+
+struct ScheduleChild {
+  /* Index of the child operation in Depsgraph::operations. */
+  int operation_index;
+  bool is_cyclic;
+};
+
+/* State used to schedule operations for evaluation, stored in contiguous arrays indexed by the
+ * index of an operation in Depsgraph::operations, so that the scheduler does not need to chase
+ * pointers to operation nodes and their relations.
+ *
+ * Static part is built once after the relations of the graph were updated. */
+struct EvaluationSchedule {
+  /* eScheduleOperationFlag of every operation. */
+  Array<uint8_t> flags;
+
+  /* Children of all operations in CSR form: children of operation i are stored in the
+   * range [children_offsets[i], children_offsets[i + 1]). */
+  Array<int> children_offsets;
+  Array<ScheduleChild> children;
+
+  /* Per-evaluation state. */
+  /* Operation is visible and tagged for update. */
+  Array<bool> needs_evaluation;
+  /* How many parents are still to be evaluated before the operation can be evaluated. */
+  Array<uint32_t> num_links_pending;
+  Array<uint8_t> scheduled;
+
+  /* Number of evaluations done since the schedule was built. */
+  int num_evaluations = 0;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("EvaluationSchedule");
+};
+
+/* Get schedule of the graph, building it if the relations were updated since the last
+ * evaluation, and initialize its per-evaluation state from update tags of the operations. */
+EvaluationSchedule *deg_eval_schedule_prepare(Depsgraph *graph);
+
+}  // namespace deg
+}  // namespace blender
@@ -23,9 +23,13 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <algorithm>
+
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -54,4 +58,70 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+/* Weight of the new sample in the running average of operation timings. */
+#define DEG_STATS_AVERAGE_FACTOR 0.25
+
+void deg_eval_stats_update_critical_path(Depsgraph *graph)
+{
+  enum { OP_UNVISITED = 0, OP_VISITING = 1, OP_VISITED = 2 };
+
+  for (OperationNode *op_node : graph->operations) {
+    if ((op_node->flag & DEPSOP_FLAG_NEEDS_UPDATE) && !op_node->is_noop()) {
+      Node::Stats &stats = op_node->stats;
+      stats.average_time = (stats.average_time == 0.0) ?
+                               stats.current_time :
+                               (stats.average_time * (1.0 - DEG_STATS_AVERAGE_FACTOR) +
+                                stats.current_time * DEG_STATS_AVERAGE_FACTOR);
+    }
+    op_node->custom_flags = OP_UNVISITED;
+  }
+
+  /* Depth first traversal over outgoing relations, the critical path time of an operation is
+   * known once all operations depending on it are visited. Cyclic relations are ignored. */
+  Vector<std::pair<OperationNode *, int>> stack;
+  for (OperationNode *root : graph->operations) {
+    if (root->custom_flags != OP_UNVISITED) {
+      continue;
+    }
+    root->custom_flags = OP_VISITING;
+    stack.append({root, 0});
+    while (!stack.is_empty()) {
+      OperationNode *op_node = stack.last().first;
+      int &rel_index = stack.last().second;
+      bool descended = false;
+      while (rel_index < op_node->outlinks.size()) {
+        Relation *rel = op_node->outlinks[rel_index++];
+        if ((rel->flag & RELATION_FLAG_CYCLIC) || rel->to->type != NodeType::OPERATION) {
+          continue;
+        }
+        OperationNode *child = (OperationNode *)rel->to;
+        if (child->custom_flags == OP_UNVISITED) {
+          child->custom_flags = OP_VISITING;
+          stack.append({child, 0});
+          descended = true;
+          break;
+        }
+      }
+      if (descended) {
+        continue;
+      }
+
+      double children_time = 0.0;
+      for (Relation *rel : op_node->outlinks) {
+        if ((rel->flag & RELATION_FLAG_CYCLIC) || rel->to->type != NodeType::OPERATION) {
+          continue;
+        }
+        const OperationNode *child = (const OperationNode *)rel->to;
+        /* Children still being visited are part of a cycle that wasn't tagged as such. */
+        if (child->custom_flags == OP_VISITED) {
+          children_time = std::max(children_time, child->critical_path_time);
+        }
+      }
+      op_node->critical_path_time = op_node->stats.average_time + children_time;
+      op_node->custom_flags = OP_VISITED;
+      stack.remove_last();
+    }
+  }
+}
+
 }  // namespace blender::deg
@@ -31,5 +31,11 @@ struct Depsgraph;
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Update average operation timings from the last evaluation and the critical path time of
+ * all operations, which is used to prioritize evaluation of long chains of operations.
+ * Only called for evaluations which gathered operation timings, see
+ * DEG_EVAL_TIMING_SAMPLE_INTERVAL. */
+void deg_eval_stats_update_critical_path(Depsgraph *graph);
+
 }  // namespace deg
 }  // namespace blender
@@ -266,6 +266,13 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Index of the operation in Depsgraph::operations, used to access its evaluation state. */
+  int index;
+
+  /* Estimated time needed to evaluate this operation and the longest chain of operations
+   * depending on it. Operations with the highest value are evaluated first. */
+  double critical_path_time;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
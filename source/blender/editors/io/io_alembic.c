@@ -135,6 +135,7 @@ static int wm_alembic_export_exec(bContext *C, wmOperator *op)
       .export_particles = RNA_boolean_get(op->ptr, "export_particles"),
       .export_custom_properties = RNA_boolean_get(op->ptr, "export_custom_properties"),
       .use_instancing = RNA_boolean_get(op->ptr, "use_instancing"),
+      .use_pipelined_evaluation = RNA_boolean_get(op->ptr, "use_pipelined_evaluation"),
       .packuv = RNA_boolean_get(op->ptr, "packuv"),
       .triangulate = RNA_boolean_get(op->ptr, "triangulate"),
       .quad_method = RNA_enum_get(op->ptr, "quad_method"),
@@ -188,6 +189,8 @@ static void ui_alembic_export_settings(uiLayout *layout, PointerRNA *imfptr)
   uiItemR(sub, imfptr, "sh_open", UI_ITEM_R_SLIDER, NULL, ICON_NONE);
   uiItemR(sub, imfptr, "sh_close", UI_ITEM_R_SLIDER, IFACE_("Close"), ICON_NONE);
 
+  uiItemR(col, imfptr, "use_pipelined_evaluation", 0, NULL, ICON_NONE);
+
   uiItemS(col);
 
   uiItemR(col, imfptr, "flatten", 0, NULL, ICON_NONE);
@@ -458,6 +461,14 @@ void WM_OT_alembic_export(wmOperatorType *ot)
                   "Export Custom Properties",
                   "Export custom properties to Alembic .userProperties");
 
+  RNA_def_boolean(ot->srna,
+                  "use_pipelined_evaluation",
+                  false,
+                  "Pipelined Evaluation",
+                  "Evaluate the next frame while the current one is written, using more memory. "
+                  "Has no effect on scenes with caches or simulations, or when frame change "
+                  "handlers are registered");
+
   RNA_def_boolean(
       ot->srna,
       "as_background_job",
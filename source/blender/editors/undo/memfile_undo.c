@@ -32,6 +32,7 @@
 #include "DNA_object_enums.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BKE_blender_undo.h"
 #include "BKE_context.h"
@@ -99,8 +100,21 @@ static bool memfile_undosys_step_encode(struct bContext *UNUSED(C),
   MemFileUndoStep *us_prev = (MemFileUndoStep *)BKE_undosys_step_find_by_type(
       ustack, BKE_UNDOSYS_TYPE_MEMFILE);
   us->data = BKE_memfile_undo_encode(bmain, us_prev ? us_prev->data : NULL);
+
+  /* Big chunks are only added to the size of the new step once they are de-duplicated, wait for
+   * that when the size is used to limit undo memory. */
+  if (U.undomemory != 0) {
+    BLO_memfile_wait();
+    us->data->undo_size = us->data->memfile.size;
+  }
   us->step.data_size = us->data->undo_size;
 
+  /* The previous step has been de-duplicated by now (it was used as reference). */
+  if (us_prev != NULL) {
+    us_prev->data->undo_size = us_prev->data->memfile.size;
+    us_prev->step.data_size = us_prev->data->undo_size;
+  }
+
   /* Store the fact that we should not re-use old data with that undo step, and reset the Main
    * flag. */
   us->step.use_old_bmain_data = !bmain->use_memfile_full_barrier;
@@ -335,6 +349,7 @@ void ED_undosys_stack_memfile_id_changed_tag(UndoStack *ustack, ID *id)
   }
 
   MemFile *memfile = &((MemFileUndoStep *)us)->data->memfile;
+  BLO_memfile_wait();
   LISTBASE_FOREACH (MemFileChunk *, mem_chunk, &memfile->chunks) {
     if (mem_chunk->id_session_uuid == id->session_uuid) {
       mem_chunk->is_identical_future = false;
@@ -28,6 +28,50 @@
 
 namespace blender::fn {
 
+/**
+ * Behaves like a span in which every element is the same value.
+ */
+template<typename T> class SingleValueAccessor {
+ private:
+  const T *value_;
+
+ public:
+  SingleValueAccessor(const T &value) : value_(&value)
+  {
+  }
+
+  const T &operator[](const int64_t UNUSED(index)) const
+  {
+    return *value_;
+  }
+};
+
+/**
+ * Returns true when #devirtualize_vspan can be used with the given virtual span.
+ */
+template<typename T> inline bool is_devirtualizable(const VSpan<T> &span)
+{
+  return span.is_single_element() || span.is_full_array();
+}
+
+/**
+ * Calls the given function with either a #SingleValueAccessor or a #Span that references the
+ * same data as the virtual span. Contrary to the virtual span, these don't have to check the
+ * category of the span for every element. This allows the compiler to inline and vectorize loops
+ * that access the elements. The span must be devirtualizable (see #is_devirtualizable).
+ */
+template<typename T, typename Func>
+inline void devirtualize_vspan(const VSpan<T> &span, const Func &func)
+{
+  BLI_assert(is_devirtualizable(span));
+  if (span.is_single_element()) {
+    func(SingleValueAccessor<T>(span.as_single_element()));
+  }
+  else {
+    func(span.as_full_array());
+  }
+}
+
 /**
  * Generates a multi-function with the following parameters:
  * 1. single input (SI) of type In1
@@ -58,6 +102,16 @@ template<typename In1, typename Out1> class CustomMF_SI_SO : public MultiFunctio
   template<typename ElementFuncT> static FunctionT create_function(ElementFuncT element_fn)
   {
     return [=](IndexMask mask, VSpan<In1> in1, MutableSpan<Out1> out1) {
+      if (mask.is_range() && is_devirtualizable(in1)) {
+        /* Fast path for contiguous indices without virtual element access. */
+        const IndexRange range = mask.as_range();
+        devirtualize_vspan(in1, [&](const auto &in1_devi) {
+          for (const int64_t i : range) {
+            new (static_cast<void *>(&out1[i])) Out1(element_fn(in1_devi[i]));
+          }
+        });
+        return;
+      }
       mask.foreach_index(
           [&](int i) { new (static_cast<void *>(&out1[i])) Out1(element_fn(in1[i])); });
     };
@@ -101,6 +155,18 @@ class CustomMF_SI_SI_SO : public MultiFunction {
   template<typename ElementFuncT> static FunctionT create_function(ElementFuncT element_fn)
   {
     return [=](IndexMask mask, VSpan<In1> in1, VSpan<In2> in2, MutableSpan<Out1> out1) {
+      if (mask.is_range() && is_devirtualizable(in1) && is_devirtualizable(in2)) {
+        /* Fast path for contiguous indices without virtual element access. */
+        const IndexRange range = mask.as_range();
+        devirtualize_vspan(in1, [&](const auto &in1_devi) {
+          devirtualize_vspan(in2, [&](const auto &in2_devi) {
+            for (const int64_t i : range) {
+              new (static_cast<void *>(&out1[i])) Out1(element_fn(in1_devi[i], in2_devi[i]));
+            }
+          });
+        });
+        return;
+      }
       mask.foreach_index(
           [&](int i) { new (static_cast<void *>(&out1[i])) Out1(element_fn(in1[i], in2[i])); });
     };
@@ -152,6 +218,22 @@ class CustomMF_SI_SI_SI_SO : public MultiFunction {
                VSpan<In2> in2,
                VSpan<In3> in3,
                MutableSpan<Out1> out1) {
+      if (mask.is_range() && is_devirtualizable(in1) && is_devirtualizable(in2) &&
+          is_devirtualizable(in3)) {
+        /* Fast path for contiguous indices without virtual element access. */
+        const IndexRange range = mask.as_range();
+        devirtualize_vspan(in1, [&](const auto &in1_devi) {
+          devirtualize_vspan(in2, [&](const auto &in2_devi) {
+            devirtualize_vspan(in3, [&](const auto &in3_devi) {
+              for (const int64_t i : range) {
+                new (static_cast<void *>(&out1[i]))
+                    Out1(element_fn(in1_devi[i], in2_devi[i], in3_devi[i]));
+              }
+            });
+          });
+        });
+        return;
+      }
       mask.foreach_index([&](int i) {
         new (static_cast<void *>(&out1[i])) Out1(element_fn(in1[i], in2[i], in3[i]));
       });
@@ -25,20 +25,38 @@
 namespace blender::fn {
 
 class MFNetworkEvaluationStorage;
+class MFNetworkBufferPool;
 
 class MFNetworkEvaluator : public MultiFunction {
  private:
   Vector<const MFOutputSocket *> inputs_;
   Vector<const MFInputSocket *> outputs_;
+  /** When larger than zero, large masks are split into chunks of this size. */
+  int64_t chunk_size_ = 0;
 
  public:
   MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs, Vector<const MFInputSocket *> outputs);
 
   void call(IndexMask mask, MFParams params, MFContext context) const override;
 
+  /**
+   * Evaluate masks that contain more than the given number of indices in chunks. The chunks are
+   * evaluated in parallel and intermediate buffers only have to be as large as a chunk, which
+   * keeps them in cache and allows reusing them between chunks. Chunked evaluation is only done
+   * when the network has no vector inputs or outputs. Zero disables chunking.
+   */
+  void set_chunk_size(int64_t chunk_size);
+
  private:
   using Storage = MFNetworkEvaluationStorage;
 
+  bool can_evaluate_in_chunks() const;
+  void call_in_chunks(IndexMask mask, MFParams params, MFContext context) const;
+  void evaluate(IndexMask mask,
+                MFParams params,
+                MFContext context,
+                MFNetworkBufferPool *buffer_pool) const;
+
   void copy_inputs_to_storage(MFParams params, Storage &storage) const;
   void copy_outputs_to_storage(
       MFParams params,
@@ -28,21 +28,66 @@
  * - Avoids data copies in many cases.
  * - Every node is executed at most once.
  * - Can compute sub-functions on a single element, when the result is the same for all elements.
+ * - Can split large masks into chunks that are evaluated in parallel. Intermediate buffers are
+ *   then only as large as a chunk and are reused between chunks.
  *
  * Possible improvements:
- * - Cache and reuse buffers.
  * - Use "deepest depth first" heuristic to decide which order the inputs of a node should be
  *   computed. This reduces the number of required temporary buffers when they are reused.
  */
 
 #include "FN_multi_function_network_evaluation.hh"
 
+#include "BLI_map.hh"
 #include "BLI_stack.hh"
+#include "BLI_task.hh"
 
 namespace blender::fn {
 
 struct Value;
 
+/**
+ * Keeps buffers of intermediate values alive after they are not used anymore, so that they can be
+ * reused by later evaluations. This is useful when the same network is evaluated on many chunks of
+ * the same size. A buffer pool must not be used by multiple threads at the same time.
+ */
+class MFNetworkBufferPool : NonCopyable, NonMovable {
+ private:
+  /** All buffers use the same alignment, so that they can be reused for every type. */
+  static constexpr int64_t buffer_alignment = 64;
+
+  /** Unused buffers grouped by their size in bytes. */
+  Map<int64_t, Vector<void *>> unused_buffers_by_size_;
+
+ public:
+  MFNetworkBufferPool() = default;
+
+  ~MFNetworkBufferPool()
+  {
+    for (Span<void *> buffers : unused_buffers_by_size_.values()) {
+      for (void *buffer : buffers) {
+        MEM_freeN(buffer);
+      }
+    }
+  }
+
+  void *allocate(const int64_t size, const int64_t alignment)
+  {
+    BLI_assert(alignment <= buffer_alignment);
+    UNUSED_VARS_NDEBUG(alignment);
+    Vector<void *> &buffers = unused_buffers_by_size_.lookup_or_add_default(size);
+    if (!buffers.is_empty()) {
+      return buffers.pop_last();
+    }
+    return MEM_mallocN_aligned(size, buffer_alignment, AT);
+  }
+
+  void deallocate(void *buffer, const int64_t size)
+  {
+    unused_buffers_by_size_.lookup_or_add_default(size).append(buffer);
+  }
+};
+
 /**
  * This keeps track of all the values that flow through the multi-function network. Therefore it
  * maintains a mapping between output sockets and their corresponding values. Every `value`
@@ -56,9 +101,13 @@ class MFNetworkEvaluationStorage {
   IndexMask mask_;
   Array<Value *> value_per_output_id_;
   int64_t min_array_size_;
+  /** Optional, when null, buffers are allocated and freed directly. */
+  MFNetworkBufferPool *buffer_pool_;
 
  public:
-  MFNetworkEvaluationStorage(IndexMask mask, int socket_id_amount);
+  MFNetworkEvaluationStorage(IndexMask mask,
+                             int socket_id_amount,
+                             MFNetworkBufferPool *buffer_pool);
   ~MFNetworkEvaluationStorage();
 
   /* Add the values that have been provided by the caller of the multi-function network. */
@@ -97,6 +146,10 @@ class MFNetworkEvaluationStorage {
   bool socket_is_computed(const MFOutputSocket &socket);
   bool is_same_value_for_every_index(const MFOutputSocket &socket);
   bool socket_has_buffer_for_output(const MFOutputSocket &socket);
+
+ private:
+  void *allocate_full_buffer(const CPPType &type);
+  void free_full_buffer(const CPPType &type, void *buffer);
 };
 
 MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
@@ -135,14 +188,110 @@ MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
   }
 }
 
+void MFNetworkEvaluator::set_chunk_size(const int64_t chunk_size)
+{
+  BLI_assert(chunk_size >= 0);
+  chunk_size_ = chunk_size;
+}
+
 void MFNetworkEvaluator::call(IndexMask mask, MFParams params, MFContext context) const
 {
   if (mask.size() == 0) {
     return;
   }
 
+  if (chunk_size_ > 0 && mask.size() > chunk_size_ && this->can_evaluate_in_chunks()) {
+    this->call_in_chunks(mask, params, context);
+    return;
+  }
+
+  this->evaluate(mask, params, context, nullptr);
+}
+
+bool MFNetworkEvaluator::can_evaluate_in_chunks() const
+{
+  /* Vector outputs can't be sliced, because the caller owns the vector array. */
+  for (const MFOutputSocket *socket : inputs_) {
+    if (socket->data_type().category() != MFDataType::Single) {
+      return false;
+    }
+  }
+  for (const MFInputSocket *socket : outputs_) {
+    if (socket->data_type().category() != MFDataType::Single) {
+      return false;
+    }
+  }
+  return true;
+}
+
+BLI_NOINLINE void MFNetworkEvaluator::call_in_chunks(IndexMask mask,
+                                                     MFParams params,
+                                                     MFContext context) const
+{
+  const int64_t chunk_amount = (mask.size() + chunk_size_ - 1) / chunk_size_;
+
+  parallel_for(IndexRange(chunk_amount), 1, [&](IndexRange chunk_range) {
+    /* Chunks that are evaluated by the same task reuse the same intermediate buffers. */
+    MFNetworkBufferPool buffer_pool;
+    Vector<int64_t> chunk_indices;
+
+    for (const int64_t chunk_index : chunk_range) {
+      const int64_t start = chunk_index * chunk_size_;
+      const Span<int64_t> indices = mask.indices().slice(
+          start, std::min(chunk_size_, mask.size() - start));
+
+      /* Shift all indices so that the chunk starts at zero. That way, the intermediate buffers
+       * only have to be as large as the chunk. */
+      const int64_t offset = indices.first();
+      const int64_t chunk_array_size = indices.last() - offset + 1;
+      IndexMask chunk_mask;
+      if (chunk_array_size == indices.size()) {
+        chunk_mask = IndexRange(chunk_array_size);
+      }
+      else {
+        chunk_indices.clear();
+        for (const int64_t i : indices) {
+          chunk_indices.append(i - offset);
+        }
+        chunk_mask = chunk_indices.as_span();
+      }
+
+      MFParamsBuilder chunk_params{*this, chunk_array_size};
+      for (const int param_index : this->param_indices()) {
+        const MFParamType param_type = this->param_type(param_index);
+        switch (param_type.category()) {
+          case MFParamType::SingleInput: {
+            const GVSpan values = params.readonly_single_input(param_index);
+            chunk_params.add_readonly_single_input(values.slice(offset, chunk_array_size));
+            break;
+          }
+          case MFParamType::SingleOutput: {
+            const GMutableSpan values = params.uninitialized_single_output(param_index);
+            chunk_params.add_uninitialized_single_output(values.slice(offset, chunk_array_size));
+            break;
+          }
+          case MFParamType::VectorInput:
+          case MFParamType::VectorOutput:
+          case MFParamType::SingleMutable:
+          case MFParamType::VectorMutable: {
+            BLI_assert(false);
+            break;
+          }
+        }
+      }
+
+      this->evaluate(chunk_mask, chunk_params, context, &buffer_pool);
+    }
+  });
+}
+
+void MFNetworkEvaluator::evaluate(IndexMask mask,
+                                  MFParams params,
+                                  MFContext context,
+                                  MFNetworkBufferPool *buffer_pool) const
+{
   const MFNetwork &network = outputs_[0]->node().network();
-  Storage storage(mask, network.socket_id_amount());
+  Storage storage(mask, network.socket_id_amount(), buffer_pool);
 
   Vector<const MFInputSocket *> outputs_to_initialize_in_the_end;
 
@@ -506,10 +655,13 @@ struct OwnVectorValue : public Value {
 /** \name Storage methods
  * \{ */
 
-MFNetworkEvaluationStorage::MFNetworkEvaluationStorage(IndexMask mask, int socket_id_amount)
+MFNetworkEvaluationStorage::MFNetworkEvaluationStorage(IndexMask mask,
+                                                       int socket_id_amount,
+                                                       MFNetworkBufferPool *buffer_pool)
     : mask_(mask),
       value_per_output_id_(socket_id_amount, nullptr),
-      min_array_size_(mask.min_array_size())
+      min_array_size_(mask.min_array_size()),
+      buffer_pool_(buffer_pool)
 {
 }
 
@@ -528,7 +680,7 @@ MFNetworkEvaluationStorage::~MFNetworkEvaluationStorage()
       }
       else {
         type.destruct_indices(span.data(), mask_);
-        MEM_freeN(span.data());
+        this->free_full_buffer(type, span.data());
       }
     }
     else if (any_value->type == ValueType::OwnVector) {
@@ -543,6 +695,24 @@ IndexMask MFNetworkEvaluationStorage::mask() const
   return mask_;
 }
 
+void *MFNetworkEvaluationStorage::allocate_full_buffer(const CPPType &type)
+{
+  const int64_t size = min_array_size_ * type.size();
+  if (buffer_pool_ != nullptr) {
+    return buffer_pool_->allocate(size, type.alignment());
+  }
+  return MEM_mallocN_aligned(size, type.alignment(), AT);
+}
+
+void MFNetworkEvaluationStorage::free_full_buffer(const CPPType &type, void *buffer)
+{
+  if (buffer_pool_ != nullptr) {
+    buffer_pool_->deallocate(buffer, min_array_size_ * type.size());
+    return;
+  }
+  MEM_freeN(buffer);
+}
+
 bool MFNetworkEvaluationStorage::socket_is_computed(const MFOutputSocket &socket)
 {
   Value *any_value = value_per_output_id_[socket.id()];
@@ -638,7 +808,7 @@ void MFNetworkEvaluationStorage::finish_input_socket(const MFInputSocket &socket
         }
         else {
           type.destruct_indices(span.data(), mask_);
-          MEM_freeN(span.data());
+          this->free_full_buffer(type, span.data());
         }
         value_per_output_id_[origin.id()] = nullptr;
       }
@@ -702,7 +872,7 @@ GMutableSpan MFNetworkEvaluationStorage::get_single_output__full(const MFOutputS
   Value *any_value = value_per_output_id_[socket.id()];
   if (any_value == nullptr) {
     const CPPType &type = socket.data_type().single_type();
-    void *buffer = MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+    void *buffer = this->allocate_full_buffer(type);
     GMutableSpan span(type, buffer, min_array_size_);
 
     auto *value = allocator_.construct<OwnSingleValue>(span, socket.targets().size(), false);
@@ -802,7 +972,7 @@ GMutableSpan MFNetworkEvaluationStorage::get_mutable_single__full(const MFInputS
   }
 
   GVSpan virtual_span = this->get_single_input__full(input);
-  void *new_buffer = MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+  void *new_buffer = this->allocate_full_buffer(type);
   GMutableSpan new_array_ref(type, new_buffer, min_array_size_);
   virtual_span.materialize_to_uninitialized(mask_, new_array_ref.data());
 
@@ -2,6 +2,9 @@
 
 #include "testing/testing.h"
 
+#include "BLI_float3.hh"
+#include "BLI_timeit.hh"
+
 #include "FN_multi_function.hh"
 #include "FN_multi_function_builder.hh"
 
@@ -249,6 +252,61 @@ TEST(multi_function, CustomMF_SI_SI_SO)
   EXPECT_EQ(outputs[3], 90);
 }
 
+TEST(multi_function, CustomMF_SI_SI_SO_Range)
+{
+  CustomMF_SI_SI_SO<int, int, int> fn("mul", [](int a, int b) { return a * b; });
+
+  Array<int> values_a = {4, 6, 8, 9};
+  Array<int> values_b = {1, 2, 3, 4};
+  int value_b = 10;
+  Array<int> pointer_values_b_storage = {5, 6, 7, 8};
+  Array<const int *> pointer_values_b = {&pointer_values_b_storage[0],
+                                         &pointer_values_b_storage[1],
+                                         &pointer_values_b_storage[2],
+                                         &pointer_values_b_storage[3]};
+  MFContextBuilder context;
+
+  {
+    Array<int> outputs(values_a.size(), -1);
+    MFParamsBuilder params(fn, values_a.size());
+    params.add_readonly_single_input(values_a.as_span());
+    params.add_readonly_single_input(values_b.as_span());
+    params.add_uninitialized_single_output(outputs.as_mutable_span());
+    fn.call(IndexRange(1, 3), params, context);
+
+    EXPECT_EQ(outputs[0], -1);
+    EXPECT_EQ(outputs[1], 12);
+    EXPECT_EQ(outputs[2], 24);
+    EXPECT_EQ(outputs[3], 36);
+  }
+  {
+    Array<int> outputs(values_a.size(), -1);
+    MFParamsBuilder params(fn, values_a.size());
+    params.add_readonly_single_input(values_a.as_span());
+    params.add_readonly_single_input(&value_b);
+    params.add_uninitialized_single_output(outputs.as_mutable_span());
+    fn.call(IndexRange(4), params, context);
+
+    EXPECT_EQ(outputs[0], 40);
+    EXPECT_EQ(outputs[1], 60);
+    EXPECT_EQ(outputs[2], 80);
+    EXPECT_EQ(outputs[3], 90);
+  }
+  {
+    Array<int> outputs(values_a.size(), -1);
+    MFParamsBuilder params(fn, values_a.size());
+    params.add_readonly_single_input(values_a.as_span());
+    params.add_readonly_single_input(VSpan<int>(pointer_values_b.as_span()));
+    params.add_uninitialized_single_output(outputs.as_mutable_span());
+    fn.call(IndexRange(4), params, context);
+
+    EXPECT_EQ(outputs[0], 20);
+    EXPECT_EQ(outputs[1], 36);
+    EXPECT_EQ(outputs[2], 56);
+    EXPECT_EQ(outputs[3], 72);
+  }
+}
+
 TEST(multi_function, CustomMF_SI_SI_SI_SO)
 {
   CustomMF_SI_SI_SI_SO<int, std::string, bool, uint> fn{
@@ -383,5 +441,54 @@ TEST(multi_function, CustomMF_Convert)
   EXPECT_EQ(outputs[2], 9);
 }
 
+/**
+ * Set this to 1 to activate the benchmark. It is disabled by default, because it prints a lot.
+ * It compares the devirtualized fast path of the function builders with the generic path that
+ * has to access every element through a virtual span.
+ */
+#if 0
+template<typename T, typename Fn>
+BLI_NOINLINE void benchmark_si_si_so(StringRef name, const Fn &element_fn, const int amount)
+{
+  CustomMF_SI_SI_SO<T, T, T> fn("benchmark", element_fn);
+
+  Array<T> values_a(amount, T(1.5f));
+  Array<T> values_b(amount, T(2.5f));
+  Array<const T *> pointers_b(amount);
+  for (const int i : IndexRange(amount)) {
+    pointers_b[i] = &values_b[i];
+  }
+  Array<T> outputs(amount);
+  MFContextBuilder context;
+
+  {
+    MFParamsBuilder params(fn, amount);
+    params.add_readonly_single_input(values_a.as_span());
+    params.add_readonly_single_input(values_b.as_span());
+    params.add_uninitialized_single_output(outputs.as_mutable_span());
+    SCOPED_TIMER(name + " Devirtualized");
+    fn.call(IndexRange(amount), params, context);
+  }
+  {
+    MFParamsBuilder params(fn, amount);
+    params.add_readonly_single_input(values_a.as_span());
+    params.add_readonly_single_input(VSpan<T>(pointers_b.as_span()));
+    params.add_uninitialized_single_output(outputs.as_mutable_span());
+    SCOPED_TIMER(name + " Virtual      ");
+    fn.call(IndexRange(amount), params, context);
+  }
+}
+
+TEST(multi_function, Benchmark)
+{
+  for (int i = 0; i < 3; i++) {
+    benchmark_si_si_so<float>(
+        "float  add", [](float a, float b) { return a + b; }, 10000000);
+    benchmark_si_si_so<float3>(
+        "float3 add", [](float3 a, float3 b) { return a + b; }, 10000000);
+  }
+}
+#endif
+
 }  // namespace
 }  // namespace blender::fn::tests
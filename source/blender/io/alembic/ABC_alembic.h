@@ -62,6 +62,9 @@ struct AlembicExportParams {
   bool export_particles;
   bool export_custom_properties;
   bool use_instancing;
+  /* Evaluate the next frame in a separate depsgraph while the current one is written. Ignored
+   * when frames depend on the evaluation of previous ones, like with point caches. */
+  bool use_pipelined_evaluation;
 
   /* See MOD_TRIANGULATE_NGON_xxx and MOD_TRIANGULATE_QUAD_xxx
    * in DNA_modifier_types.h */
@@ -29,17 +29,22 @@
 #include "DEG_depsgraph_query.h"
 
 #include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
 #include "BKE_blender_version.h"
+#include "BKE_callbacks.h"
 #include "BKE_context.h"
 #include "BKE_global.h"
 #include "BKE_main.h"
+#include "BKE_modifier.h"
+#include "BKE_pointcache.h"
 #include "BKE_scene.h"
 
 #include "BLI_fileops.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 
 #include "WM_api.h"
 #include "WM_types.h"
@@ -48,6 +53,7 @@
 static CLG_LogRef LOG = {"io.alembic"};
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
 
 struct ExportJobData {
@@ -75,6 +81,62 @@ static void build_depsgraph(Depsgraph *depsgraph, const bool visible_objects_onl
   }
 }
 
+/* Whether every frame can be evaluated without evaluating the frames before it. This is not the
+ * case for point caches, rigid bodies and simulations, which are stepped frame by frame. */
+static bool frames_evaluate_independently(Depsgraph *depsgraph)
+{
+  Scene *scene = DEG_get_evaluated_scene(depsgraph);
+  if (scene->rigidbody_world != nullptr || DEG_id_type_any_exists(depsgraph, ID_SIM)) {
+    return false;
+  }
+
+  bool independent = true;
+  DEG_OBJECT_ITER_BEGIN (depsgraph,
+                         object,
+                         DEG_ITER_OBJECT_FLAG_LINKED_DIRECTLY |
+                             DEG_ITER_OBJECT_FLAG_LINKED_VIA_SET) {
+    if (BKE_ptcache_object_has(scene, object, 0) ||
+        BKE_modifiers_findby_type(object, eModifierType_Fluidsim) != nullptr) {
+      independent = false;
+      break;
+    }
+  }
+  DEG_OBJECT_ITER_END;
+
+  return independent;
+}
+
+static void evaluate_frame_task(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  Depsgraph *depsgraph = static_cast<Depsgraph *>(taskdata);
+  BKE_scene_graph_update_for_newframe(depsgraph);
+}
+
+/* Create a second depsgraph for the exported scene, used to evaluate the next frame while the
+ * current one is written. Returns nullptr when this is not possible for the scene. */
+static Depsgraph *pipelined_depsgraph_create(const ExportJobData *data)
+{
+  if (!data->params.use_pipelined_evaluation ||
+      !frames_evaluate_independently(data->depsgraph)) {
+    return nullptr;
+  }
+  /* Frame change handlers would run on the background task, off the job thread, and could
+   * change and tag data while the current frame is written. */
+  if (BKE_callback_is_used(BKE_CB_EVT_FRAME_CHANGE_PRE) ||
+      BKE_callback_is_used(BKE_CB_EVT_FRAME_CHANGE_POST)) {
+    CLOG_INFO(&LOG, 2, "Not evaluating frames ahead, frame change handlers are registered");
+    return nullptr;
+  }
+
+  Depsgraph *depsgraph = DEG_graph_new(data->bmain,
+                                       DEG_get_input_scene(data->depsgraph),
+                                       DEG_get_input_view_layer(data->depsgraph),
+                                       DEG_get_mode(data->depsgraph));
+  build_depsgraph(depsgraph, data->params.visible_objects_only);
+  BKE_scene_graph_update_tagged(depsgraph, data->bmain);
+  return depsgraph;
+}
+
 static void export_startjob(void *customdata,
                             /* Cannot be const, this function implements wm_jobs_start_callback.
                              * NOLINTNEXTLINE: readability-non-const-parameter. */
@@ -141,6 +203,17 @@ static void export_startjob(void *customdata,
     ABCArchive::Frames::const_iterator frame_it = abc_archive->frames_begin();
     const ABCArchive::Frames::const_iterator frames_end = abc_archive->frames_end();
 
+    /* When pipelining, the depsgraph that is written is always evaluated for the current frame,
+     * while the other one is being evaluated for the next frame by a background task. */
+    Depsgraph *depsgraph_next = pipelined_depsgraph_create(data);
+    Depsgraph *depsgraph_current = data->depsgraph;
+    TaskPool *task_pool = nullptr;
+    if (depsgraph_next != nullptr) {
+      CLOG_INFO(&LOG, 2, "Evaluating frames ahead of writing them");
+      task_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_HIGH);
+    }
+
+    bool is_current_evaluated = false;
     for (; frame_it != frames_end; frame_it++) {
       double frame = *frame_it;
 
@@ -148,19 +221,43 @@ static void export_startjob(void *customdata,
         break;
       }
 
-      /* Update the scene for the next frame to render. */
-      scene->r.cfra = static_cast<int>(frame);
-      scene->r.subframe = frame - scene->r.cfra;
-      BKE_scene_graph_update_for_newframe(data->depsgraph);
+      if (!is_current_evaluated) {
+        /* Update the scene for the next frame to render. */
+        scene->r.cfra = static_cast<int>(frame);
+        scene->r.subframe = frame - scene->r.cfra;
+        BKE_scene_graph_update_for_newframe(depsgraph_current);
+      }
+
+      ABCArchive::Frames::const_iterator frame_next_it = std::next(frame_it);
+      is_current_evaluated = (task_pool != nullptr && frame_next_it != frames_end);
+      if (is_current_evaluated) {
+        /* The written depsgraph only holds evaluated copies, so changing the original scene
+         * frame does not affect it. */
+        scene->r.cfra = static_cast<int>(*frame_next_it);
+        scene->r.subframe = *frame_next_it - scene->r.cfra;
+        BLI_task_pool_push(task_pool, evaluate_frame_task, depsgraph_next, false, nullptr);
+      }
 
       CLOG_INFO(&LOG, 2, "Exporting frame %.2f", frame);
       ExportSubset export_subset = abc_archive->export_subset_for_frame(frame);
+      iter.set_depsgraph(depsgraph_current);
       iter.set_export_subset(export_subset);
       iter.iterate_and_write();
 
+      if (is_current_evaluated) {
+        BLI_task_pool_work_and_wait(task_pool);
+        std::swap(depsgraph_current, depsgraph_next);
+      }
+
       *progress += progress_per_frame;
       *do_update = true;
     }
+
+    if (task_pool != nullptr) {
+      BLI_task_pool_free(task_pool);
+      iter.set_depsgraph(data->depsgraph);
+      DEG_graph_free(depsgraph_current == data->depsgraph ? depsgraph_next : depsgraph_current);
+    }
   }
   else {
     /* If we're not animating, a single iteration over all objects is enough. */
@@ -109,7 +109,7 @@ void ABCGenericMeshWriter::create_alembic_objects(const HierarchyContext *contex
     type.set(subsurf_modifier_ == nullptr);
   }
 
-  Scene *scene_eval = DEG_get_evaluated_scene(args_.depsgraph);
+  Scene *scene_eval = DEG_get_evaluated_scene(args_.hierarchy_iterator->get_depsgraph());
   liquid_sim_modifier_ = get_liquid_sim_modifier(scene_eval, context->object);
 }
 
@@ -248,6 +248,12 @@ class AbstractHierarchyIterator {
    * previous iteration. */
   void set_export_subset(ExportSubset export_subset_);
 
+  /* Change the depsgraph that is iterated over by the next call to iterate_and_write().
+   * This allows writing frames that were evaluated by different depsgraphs of the same scene,
+   * which is how evaluation of a frame can overlap with writing of the previous one. */
+  void set_depsgraph(Depsgraph *depsgraph);
+  Depsgraph *get_depsgraph() const;
+
   /* Convert the given name to something that is valid for the exported file format.
    * This base implementation is a no-op; override in a concrete subclass. */
   virtual std::string make_valid_name(const std::string &name) const;
@@ -2245,8 +2245,16 @@ typedef struct NodesModifierData {
   ModifierData modifier;
   struct bNodeTree *node_group;
   struct NodesModifierSettings settings;
+  int flag;
+  char _pad[4];
 } NodesModifierData;
 
+/* NodesModifierData.flag */
+enum {
+  /** Keep outputs of unchanged nodes between evaluations. */
+  MOD_NODES_USE_CACHE = (1 << 0),
+};
+
 typedef struct MeshToVolumeModifierData {
   ModifierData modifier;
 
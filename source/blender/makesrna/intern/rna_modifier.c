@@ -6995,6 +6995,16 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
   RNA_def_property_flag(prop, PROP_NEVER_NULL);
   RNA_def_property_ui_text(prop, "Settings", "Settings that are passed into the node group");
 
+  prop = RNA_def_property(srna, "use_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_NODES_USE_CACHE);
+  RNA_def_property_ui_text(
+      prop,
+      "Cache Unchanged Nodes",
+      "Keep the outputs of nodes that did not change since the last evaluation, so that only the "
+      "changed parts of the node group are executed again. The input geometry is copied and "
+      "compared on every evaluation, which is slower when it changes often");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   RNA_define_lib_overridable(false);
 
   rna_def_modifier_nodes_settings(brna);
@@ -21,16 +21,23 @@
  * \ingroup modifiers
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 #include <string>
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_float3.hh"
+#include "BLI_hash.hh"
 #include "BLI_listbase.h"
 #include "BLI_set.hh"
+#include "BLI_stack.hh"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_timeit.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_collection_types.h"
@@ -44,7 +51,9 @@
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
 
+#include "BKE_context.h"
 #include "BKE_customdata.h"
+#include "BKE_global.h"
 #include "BKE_idprop.h"
 #include "BKE_lib_query.h"
 #include "BKE_mesh.h"
@@ -55,6 +64,8 @@
 
 #include "BLO_read_write.h"
 
+#include "BLT_translation.h"
+
 #include "UI_interface.h"
 #include "UI_resources.h"
 
@@ -75,10 +86,13 @@
 #include "NOD_type_callbacks.hh"
 
 using blender::float3;
+using blender::hash_combine;
+using blender::hash_string;
 using blender::IndexRange;
 using blender::Map;
 using blender::Set;
 using blender::Span;
+using blender::Stack;
 using blender::StringRef;
 using blender::Vector;
 using blender::fn::GMutablePointer;
@@ -191,38 +205,250 @@ static bool isDisabled(const struct Scene *UNUSED(scene),
   return false;
 }
 
+static uint64_t hash_rna_property(PointerRNA *ptr, PropertyRNA *prop)
+{
+  const int array_length = RNA_property_array_length(ptr, prop);
+  uint64_t hash = hash_string(RNA_property_identifier(prop));
+  switch (RNA_property_type(prop)) {
+    case PROP_BOOLEAN:
+      if (array_length == 0) {
+        return hash_combine(hash, RNA_property_boolean_get(ptr, prop));
+      }
+      for (const int i : IndexRange(array_length)) {
+        hash = hash_combine(hash, RNA_property_boolean_get_index(ptr, prop, i));
+      }
+      return hash;
+    case PROP_INT:
+      if (array_length == 0) {
+        return hash_combine(hash, static_cast<uint64_t>(RNA_property_int_get(ptr, prop)));
+      }
+      for (const int i : IndexRange(array_length)) {
+        hash = hash_combine(hash,
+                            static_cast<uint64_t>(RNA_property_int_get_index(ptr, prop, i)));
+      }
+      return hash;
+    case PROP_FLOAT:
+      if (array_length == 0) {
+        return hash_combine(hash,
+                            blender::DefaultHash<float>{}(RNA_property_float_get(ptr, prop)));
+      }
+      for (const int i : IndexRange(array_length)) {
+        hash = hash_combine(
+            hash, blender::DefaultHash<float>{}(RNA_property_float_get_index(ptr, prop, i)));
+      }
+      return hash;
+    case PROP_ENUM:
+      return hash_combine(hash, static_cast<uint64_t>(RNA_property_enum_get(ptr, prop)));
+    case PROP_STRING: {
+      char fixed_buffer[256];
+      char *value = RNA_property_string_get_alloc(
+          ptr, prop, fixed_buffer, sizeof(fixed_buffer), nullptr);
+      hash = hash_combine(hash, hash_string(value));
+      if (value != fixed_buffer) {
+        MEM_freeN(value);
+      }
+      return hash;
+    }
+    case PROP_POINTER:
+      if (RNA_struct_is_ID(RNA_property_pointer_type(ptr, prop))) {
+        /* Referenced data-blocks can change without the node tree being aware of it, but that is
+         * handled like for #bNode.id. */
+        const PointerRNA id_ptr = RNA_property_pointer_get(ptr, prop);
+        return hash_combine(hash, blender::DefaultHash<void *>{}(id_ptr.data));
+      }
+      return hash;
+    case PROP_COLLECTION:
+      return hash;
+  }
+  return hash;
+}
+
+/**
+ * Hash the settings of a node, which are the RNA properties defined by its node type. Contrary to
+ * hashing the #bNode.storage memory, this does not depend on padding bytes and pointers. The
+ * properties that all nodes have, like their location, don't change the outputs.
+ */
+static uint64_t hash_node_settings(const DNode &node)
+{
+  PointerRNA ptr;
+  RNA_pointer_create(&node.node_ref().btree()->id, &RNA_Node, node.bnode(), &ptr);
+  uint64_t hash = hash_string(RNA_struct_identifier(ptr.type));
+  const ListBase *properties = RNA_struct_type_properties(ptr.type);
+  LISTBASE_FOREACH (Link *, link, properties) {
+    PropertyRNA *prop = reinterpret_cast<PropertyRNA *>(link);
+    hash = hash_combine(hash, hash_rna_property(&ptr, prop));
+  }
+  return hash;
+}
+
+/**
+ * Output values of nodes that are kept between evaluations of a modifier. The cache is stored as
+ * runtime data of the modifier.
+ *
+ * Every node gets a key that is computed from its settings, its unlinked input values and the
+ * keys of the nodes it depends on. When a node has the same key as in the previous evaluation,
+ * its outputs can be taken from the cache, and the nodes it depends on don't have to be executed.
+ *
+ * Only the outputs of unchanged nodes that are used by changed nodes are stored. Those are the
+ * nodes where evaluation has to start again when the same inputs change in the next evaluation.
+ * Caching every node would use much more memory and would make every intermediate geometry
+ * immutable, so that nodes would have to copy it before modifying it.
+ */
+struct GeometryNodesCache {
+  /** Key of every node that could be cached in the last evaluation, by node identifier. */
+  Map<uint64_t, uint64_t> key_by_node_identifier;
+  /** Values of all available outputs of cached nodes, by node key. */
+  Map<uint64_t, Vector<GMutablePointer>> outputs_by_key;
+  /**
+   * Copy of the geometry passed into the node group in the last evaluation. Comparing the new
+   * input with it is cheaper than hashing the input in every evaluation, because the comparison
+   * stops at the first difference.
+   */
+  GeometrySet input_geometry;
+  /** Incremented every time the input geometry changes. Used as key of the input geometry. */
+  uint64_t input_geometry_version = 0;
+
+  ~GeometryNodesCache()
+  {
+    this->clear_outputs();
+  }
+
+  void clear_outputs()
+  {
+    for (Vector<GMutablePointer> &values : outputs_by_key.values()) {
+      for (GMutablePointer value : values) {
+        value.destruct();
+        MEM_freeN(value.get());
+      }
+    }
+    outputs_by_key.clear();
+  }
+};
+
+/** Runtime data of a nodes modifier, kept between evaluations. */
+struct NodesModifierRuntime {
+  /** Only exists while #MOD_NODES_USE_CACHE is enabled. */
+  std::unique_ptr<GeometryNodesCache> cache;
+  /**
+   * Time spent in every node in the last evaluation, by node path. Like the timings of depsgraph
+   * operations, these are only gathered with #G_DEBUG_DEPSGRAPH_TIME.
+   */
+  Map<std::string, blender::timeit::Nanoseconds> duration_by_node;
+};
+
+/**
+ * Evaluates a derived node tree to compute the values of the group outputs.
+ *
+ * Only nodes that the group outputs depend on are executed. Before evaluation starts, these
+ * nodes are found by walking the tree backwards from the outputs. Every node whose dependencies
+ * have been computed is pushed into a task pool, so that independent branches of the tree are
+ * evaluated in parallel.
+ *
+ * When a #GeometryNodesCache is passed in, nodes whose outputs are cached are not executed and
+ * neither are the nodes that only they depend on.
+ */
 class GeometryNodesEvaluator {
  private:
+  /** Evaluation state of a node that has to be executed to compute the group outputs. */
+  struct NodeState {
+    const DNode *node = nullptr;
+    /** Number of nodes that still have to be executed before this node can run. */
+    std::atomic<int> dependencies_left = 0;
+    /** Nodes that use at least one output of this node. */
+    Vector<NodeState *> dependents;
+    /**
+     * Values created while executing this node are allocated here. Every node has its own
+     * allocator, so that nodes running on different threads don't have to synchronize.
+     */
+    blender::LinearAllocator<> allocator;
+    /** Output values from the previous evaluation, when the node does not have to run again. */
+    const Vector<GMutablePointer> *cached_outputs = nullptr;
+    /** True when the outputs of this node should be cached for the next evaluation. */
+    bool store_outputs = false;
+    /** True when an output of this node is used by a group output directly. */
+    bool is_used_by_group_output = false;
+    /** Copies of the outputs that are moved into the cache after evaluation. */
+    Vector<GMutablePointer> outputs_to_store;
+    /** Time spent in this node, including the preparation of its inputs. */
+    blender::timeit::Nanoseconds duration{0};
+  };
+
   blender::LinearAllocator<> allocator_;
   Map<const DInputSocket *, GMutablePointer> value_by_input_;
+  /** Protects #value_by_input_ while nodes are executed in parallel. */
+  std::mutex value_by_input_mutex_;
   Vector<const DInputSocket *> group_outputs_;
+  Map<const DNode *, std::unique_ptr<NodeState>> node_states_;
   blender::nodes::MultiFunctionByNode &mf_by_node_;
   const blender::nodes::DataTypeConversions &conversions_;
   const blender::bke::PersistentDataHandleMap &handle_map_;
   const Object *self_object_;
+  GeometryNodesCache *cache_;
+  /** Node timings are written here when it is not null. */
+  Map<std::string, blender::timeit::Nanoseconds> *duration_by_node_;
+  /** Cache keys of nodes, see #node_key. Nodes that can't be cached have no key. */
+  Map<const DNode *, std::optional<uint64_t>> key_by_node_;
+  /** Cache keys of the group inputs, see #group_input_key. */
+  Map<const DOutputSocket *, uint64_t> key_by_group_input_;
 
  public:
   GeometryNodesEvaluator(const Map<const DOutputSocket *, GMutablePointer> &group_input_data,
                          Vector<const DInputSocket *> group_outputs,
                          blender::nodes::MultiFunctionByNode &mf_by_node,
                          const blender::bke::PersistentDataHandleMap &handle_map,
-                         const Object *self_object)
+                         const Object *self_object,
+                         GeometryNodesCache *cache,
+                         Map<std::string, blender::timeit::Nanoseconds> *duration_by_node)
       : group_outputs_(std::move(group_outputs)),
         mf_by_node_(mf_by_node),
         conversions_(blender::nodes::get_implicit_type_conversions()),
         handle_map_(handle_map),
-        self_object_(self_object)
+        self_object_(self_object),
+        cache_(cache),
+        duration_by_node_(duration_by_node)
   {
     for (auto item : group_input_data.items()) {
-      this->forward_to_inputs(*item.key, item.value);
+      if (cache_ != nullptr) {
+        key_by_group_input_.add_new(item.key, this->group_input_key(item.value));
+      }
+      this->forward_to_inputs(*item.key, item.value, allocator_);
     }
+    this->find_required_nodes();
   }
 
   Vector<GMutablePointer> execute()
   {
+    /* Collect the nodes without dependencies first, because tasks that run already might
+     * schedule other nodes while the initial tasks are pushed. */
+    Vector<NodeState *> initial_states;
+    for (std::unique_ptr<NodeState> &state : node_states_.values()) {
+      if (state->dependencies_left == 0) {
+        initial_states.append(state.get());
+      }
+    }
+
+    TaskPool *task_pool = (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) ?
+                              BLI_task_pool_create_no_threads(this) :
+                              BLI_task_pool_create_suspended(this, TASK_PRIORITY_HIGH);
+    for (NodeState *state : initial_states) {
+      BLI_task_pool_push(task_pool, execute_node_task, state, false, nullptr);
+    }
+    BLI_task_pool_work_and_wait(task_pool);
+    BLI_task_pool_free(task_pool);
+
+    if (cache_ != nullptr) {
+      this->update_cache();
+    }
+    if (duration_by_node_ != nullptr) {
+      duration_by_node_->clear();
+      for (const std::unique_ptr<NodeState> &state : node_states_.values()) {
+        duration_by_node_->add_overwrite(node_path(*state->node), state->duration);
+      }
+    }
+
     Vector<GMutablePointer> results;
     for (const DInputSocket *group_output : group_outputs_) {
-      GMutablePointer result = this->get_input_value(*group_output);
+      GMutablePointer result = this->get_input_value(*group_output, allocator_);
       results.append(result);
     }
     for (GMutablePointer value : value_by_input_.values()) {
@@ -232,72 +458,368 @@ class GeometryNodesEvaluator {
   }
 
  private:
-  GMutablePointer get_input_value(const DInputSocket &socket_to_compute)
+  /**
+   * Returns the node that has to be executed to compute the value of the given input socket, or
+   * null when the value is known without executing another node.
+   */
+  const DNode *find_origin_node(const DInputSocket &socket) const
   {
-    std::optional<GMutablePointer> value = value_by_input_.pop_try(&socket_to_compute);
-    if (value.has_value()) {
-      /* This input has been computed before, return it directly. */
-      return *value;
+    if (value_by_input_.contains(&socket)) {
+      /* The value has been passed in as group input already. */
+      return nullptr;
     }
+    Span<const DOutputSocket *> from_sockets = socket.linked_sockets();
+    if (from_sockets.size() != 1) {
+      return nullptr;
+    }
+    const DOutputSocket &from_socket = *from_sockets[0];
+    if (!from_socket.is_available()) {
+      /* The default value is used for outputs that are not available. */
+      return nullptr;
+    }
+    return &from_socket.node();
+  }
 
-    Span<const DOutputSocket *> from_sockets = socket_to_compute.linked_sockets();
-    Span<const DGroupInput *> from_group_inputs = socket_to_compute.linked_group_inputs();
-    const int total_inputs = from_sockets.size() + from_group_inputs.size();
-    BLI_assert(total_inputs <= 1);
+  /**
+   * Create a state for every node that is required to compute the group outputs and count the
+   * dependencies of every node. Inputs that are not available are ignored, so nodes that only
+   * feed into those are not executed. The same goes for the dependencies of cached nodes.
+   */
+  void find_required_nodes()
+  {
+    Stack<const DNode *> nodes_to_check;
+
+    auto add_dependency = [&](const DInputSocket &socket, NodeState *dependent) {
+      const DNode *origin_node = this->find_origin_node(socket);
+      if (origin_node == nullptr) {
+        return;
+      }
+      NodeState &origin_state = *node_states_.lookup_or_add_cb(origin_node, [&]() {
+        nodes_to_check.push(origin_node);
+        std::unique_ptr<NodeState> state = std::make_unique<NodeState>();
+        state->node = origin_node;
+        return state;
+      });
+      if (dependent == nullptr) {
+        origin_state.is_used_by_group_output = true;
+      }
+      else if (!origin_state.dependents.contains(dependent)) {
+        origin_state.dependents.append(dependent);
+        dependent->dependencies_left++;
+      }
+    };
 
-    if (total_inputs == 0) {
-      /* The input is not connected, use the value from the socket itself. */
-      return get_unlinked_input_value(socket_to_compute);
+    for (const DInputSocket *group_output : group_outputs_) {
+      add_dependency(*group_output, nullptr);
     }
-    if (from_group_inputs.size() == 1) {
-      /* The input gets its value from the input of a group that is not further connected. */
-      return get_unlinked_input_value(socket_to_compute);
+    while (!nodes_to_check.is_empty()) {
+      const DNode *node = nodes_to_check.pop();
+      NodeState *state = node_states_.lookup(node).get();
+      if (cache_ != nullptr) {
+        const std::optional<uint64_t> key = this->node_key(*node);
+        if (key.has_value()) {
+          state->cached_outputs = cache_->outputs_by_key.lookup_ptr(*key);
+          if (state->cached_outputs != nullptr) {
+            /* The nodes this node depends on don't have to be executed for it. */
+            continue;
+          }
+        }
+      }
+      for (const DInputSocket *input_socket : node->inputs()) {
+        if (input_socket->is_available()) {
+          add_dependency(*input_socket, state);
+        }
+      }
     }
 
-    /* Compute the socket now. */
-    const DOutputSocket &from_socket = *from_sockets[0];
-    this->compute_output_and_forward(from_socket);
-    return value_by_input_.pop(&socket_to_compute);
+    if (cache_ != nullptr) {
+      for (std::unique_ptr<NodeState> &state : node_states_.values()) {
+        state->store_outputs = this->should_store_outputs(*state);
+      }
+    }
+  }
+
+  /**
+   * A node is identified by its name and the names of the group nodes it is in. Contrary to
+   * pointers, the identifier stays the same when the node tree is copied for evaluation.
+   */
+  static uint64_t node_identifier(const DNode &node)
+  {
+    uint64_t identifier = hash_string(node.name());
+    for (const DParentNode *parent = node.parent(); parent != nullptr; parent = parent->parent()) {
+      identifier = hash_combine(identifier, hash_string(parent->node_ref().name()));
+    }
+    return identifier;
+  }
+
+  /** Names of the group nodes the node is in and of the node itself, separated by slashes. */
+  static std::string node_path(const DNode &node)
+  {
+    std::string path = node.name();
+    for (const DParentNode *parent = node.parent(); parent != nullptr; parent = parent->parent()) {
+      path = std::string(parent->node_ref().name()) + "/" + path;
+    }
+    return path;
+  }
+
+  /**
+   * The key of a node is a hash of everything its outputs depend on. Returns an empty value when
+   * the outputs can't be cached, because they depend on data outside of the node tree.
+   */
+  std::optional<uint64_t> node_key(const DNode &node)
+  {
+    const std::optional<uint64_t> *cached_key = key_by_node_.lookup_ptr(&node);
+    if (cached_key != nullptr) {
+      return *cached_key;
+    }
+    const std::optional<uint64_t> key = this->compute_node_key(node);
+    key_by_node_.add(&node, key);
+    return key;
   }
 
-  void compute_output_and_forward(const DOutputSocket &socket_to_compute)
+  std::optional<uint64_t> compute_node_key(const DNode &node)
   {
-    const DNode &node = socket_to_compute.node();
+    for (const DInputSocket *socket : node.inputs()) {
+      if (ELEM(socket->bsocket()->type, SOCK_OBJECT, SOCK_COLLECTION)) {
+        /* Other objects can change without the node tree being aware of it. */
+        return {};
+      }
+    }
+
     const bNode &bnode = *node.bnode();
+    uint64_t key = node_identifier(node);
+    key = hash_combine(key, hash_string(bnode.idname));
+    key = hash_combine(key, static_cast<uint64_t>(bnode.custom1));
+    key = hash_combine(key, static_cast<uint64_t>(bnode.custom2));
+    key = hash_combine(key, blender::DefaultHash<float>{}(bnode.custom3));
+    key = hash_combine(key, blender::DefaultHash<float>{}(bnode.custom4));
+    key = hash_combine(key, blender::DefaultHash<ID *>{}(bnode.id));
+    key = hash_combine(key, hash_node_settings(node));
+
+    for (const DInputSocket *socket : node.inputs()) {
+      if (!socket->is_available()) {
+        continue;
+      }
+      const std::optional<uint64_t> input_key = this->input_key(*socket);
+      if (!input_key.has_value()) {
+        return {};
+      }
+      key = hash_combine(key, *input_key);
+    }
+    return key;
+  }
 
-    if (!socket_to_compute.is_available()) {
-      /* If the output is not available, use a default value. */
-      const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket_to_compute.typeinfo());
-      void *buffer = allocator_.allocate(type.size(), type.alignment());
-      type.copy_to_uninitialized(type.default_value(), buffer);
-      this->forward_to_inputs(socket_to_compute, {type, buffer});
-      return;
+  /**
+   * The input geometry is compared with the one from the previous evaluation instead of being
+   * hashed, so that its data does not have to be read completely in every evaluation.
+   */
+  uint64_t group_input_key(const GMutablePointer value)
+  {
+    const CPPType &type = *value.type();
+    if (!type.is<GeometrySet>()) {
+      return type.hash(value.get());
+    }
+    const GeometrySet &geometry_set = *static_cast<const GeometrySet *>(value.get());
+    if (!(cache_->input_geometry == geometry_set)) {
+      cache_->input_geometry = geometry_set;
+      /* The input geometry is freed after the evaluation. */
+      cache_->input_geometry.ensure_owns_direct_data();
+      cache_->input_geometry_version++;
     }
+    return hash_combine(hash_string("input_geometry"), cache_->input_geometry_version);
+  }
+
+  std::optional<uint64_t> input_key(const DInputSocket &socket)
+  {
+    Span<const DOutputSocket *> from_sockets = socket.linked_sockets();
+    if (from_sockets.size() == 1) {
+      const DOutputSocket &from_socket = *from_sockets[0];
+      const uint64_t *group_input_key = key_by_group_input_.lookup_ptr(&from_socket);
+      if (group_input_key != nullptr) {
+        return *group_input_key;
+      }
+      if (!from_socket.is_available()) {
+        /* The default value of the output type is used. */
+        return hash_string(from_socket.idname());
+      }
+      const std::optional<uint64_t> from_key = this->node_key(from_socket.node());
+      if (!from_key.has_value()) {
+        return {};
+      }
+      return hash_combine(*from_key, static_cast<uint64_t>(from_socket.index()));
+    }
+
+    GMutablePointer value = this->get_unlinked_input_value(socket, allocator_);
+    const uint64_t hash = value.type()->hash(value.get());
+    value.destruct();
+    return hash;
+  }
+
+  bool node_key_changed(const DNode &node) const
+  {
+    const std::optional<uint64_t> key = key_by_node_.lookup_default(&node, std::nullopt);
+    if (!key.has_value()) {
+      return true;
+    }
+    const uint64_t *previous_key = cache_->key_by_node_identifier.lookup_ptr(
+        node_identifier(node));
+    return previous_key == nullptr || *previous_key != *key;
+  }
+
+  /**
+   * Only nodes that are unchanged since the last evaluation but are used by changed nodes are
+   * stored. If nothing changes, the group output uses the cached value directly.
+   */
+  bool should_store_outputs(const NodeState &state) const
+  {
+    if (this->node_key_changed(*state.node)) {
+      return false;
+    }
+    if (state.is_used_by_group_output) {
+      return true;
+    }
+    for (const NodeState *dependent : state.dependents) {
+      if (this->node_key_changed(*dependent->node)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Replace the content of the cache with the outputs stored in this evaluation. Outputs that
+   * were not used in this evaluation are freed.
+   */
+  void update_cache()
+  {
+    Map<uint64_t, Vector<GMutablePointer>> new_outputs_by_key;
+    for (std::unique_ptr<NodeState> &state : node_states_.values()) {
+      if (state->store_outputs) {
+        const uint64_t key = *key_by_node_.lookup(state->node);
+        new_outputs_by_key.add(key, std::move(state->outputs_to_store));
+      }
+    }
+    cache_->clear_outputs();
+    cache_->outputs_by_key = std::move(new_outputs_by_key);
+
+    cache_->key_by_node_identifier.clear();
+    for (auto item : key_by_node_.items()) {
+      if (item.value.has_value()) {
+        cache_->key_by_node_identifier.add_overwrite(node_identifier(*item.key), *item.value);
+      }
+    }
+  }
+
+  static void execute_node_task(TaskPool *__restrict pool, void *taskdata)
+  {
+    GeometryNodesEvaluator &evaluator = *(GeometryNodesEvaluator *)BLI_task_pool_user_data(pool);
+    NodeState &state = *(NodeState *)taskdata;
+
+    evaluator.compute_node_and_forward(state);
+
+    for (NodeState *dependent : state.dependents) {
+      if (--dependent->dependencies_left == 0) {
+        BLI_task_pool_push(pool, execute_node_task, dependent, false, nullptr);
+      }
+    }
+  }
+
+  GMutablePointer get_input_value(const DInputSocket &socket_to_compute,
+                                  blender::LinearAllocator<> &allocator)
+  {
+    {
+      std::lock_guard lock{value_by_input_mutex_};
+      std::optional<GMutablePointer> value = value_by_input_.pop_try(&socket_to_compute);
+      if (value.has_value()) {
+        /* This input has been computed before, return it directly. */
+        return *value;
+      }
+    }
+
+    Span<const DOutputSocket *> from_sockets = socket_to_compute.linked_sockets();
+    Span<const DGroupInput *> from_group_inputs = socket_to_compute.linked_group_inputs();
+    const int total_inputs = from_sockets.size() + from_group_inputs.size();
+    BLI_assert(total_inputs <= 1);
+    UNUSED_VARS_NDEBUG(total_inputs);
+
+    if (from_sockets.size() == 1) {
+      /* The input is linked to an output that is not available. */
+      BLI_assert(!from_sockets[0]->is_available());
+      return this->get_unavailable_output_value(*from_sockets[0], socket_to_compute, allocator);
+    }
+
+    /* The input is not connected or it gets its value from the input of a group that is not
+     * further connected. Use the value from the socket itself. */
+    return this->get_unlinked_input_value(socket_to_compute, allocator);
+  }
+
+  void compute_node_and_forward(NodeState &state)
+  {
+    const bool do_timing = duration_by_node_ != nullptr;
+    const blender::timeit::TimePoint start_time = do_timing ? blender::timeit::Clock::now() :
+                                                              blender::timeit::TimePoint();
 
-    /* Prepare inputs required to execute the node. */
-    GValueMap<StringRef> node_inputs_map{allocator_};
-    for (const DInputSocket *input_socket : node.inputs()) {
-      if (input_socket->is_available()) {
-        GMutablePointer value = this->get_input_value(*input_socket);
-        node_inputs_map.add_new_direct(input_socket->identifier(), value);
+    const DNode &node = *state.node;
+    const bNode &bnode = *node.bnode();
+    blender::LinearAllocator<> &allocator = state.allocator;
+
+    GValueMap<StringRef> node_inputs_map{allocator};
+    GValueMap<StringRef> node_outputs_map{allocator};
+    if (state.cached_outputs != nullptr) {
+      /* Use the outputs from the previous evaluation. */
+      int cached_index = 0;
+      for (const DOutputSocket *output_socket : node.outputs()) {
+        if (output_socket->is_available()) {
+          const GMutablePointer cached_value = (*state.cached_outputs)[cached_index];
+          const CPPType &type = *cached_value.type();
+          void *buffer = allocator.allocate(type.size(), type.alignment());
+          type.copy_to_uninitialized(cached_value.get(), buffer);
+          node_outputs_map.add_new_direct(output_socket->identifier(), {type, buffer});
+          cached_index++;
+        }
       }
     }
+    else {
+      /* Prepare inputs required to execute the node. */
+      for (const DInputSocket *input_socket : node.inputs()) {
+        if (input_socket->is_available()) {
+          GMutablePointer value = this->get_input_value(*input_socket, allocator);
+          node_inputs_map.add_new_direct(input_socket->identifier(), value);
+        }
+      }
 
-    /* Execute the node. */
-    GValueMap<StringRef> node_outputs_map{allocator_};
-    GeoNodeExecParams params{bnode, node_inputs_map, node_outputs_map, handle_map_, self_object_};
-    this->execute_node(node, params);
+      /* Execute the node. */
+      GeoNodeExecParams params{
+          bnode, node_inputs_map, node_outputs_map, handle_map_, self_object_};
+      this->execute_node(node, params, allocator);
+    }
 
     /* Forward computed outputs to linked input sockets. */
     for (const DOutputSocket *output_socket : node.outputs()) {
       if (output_socket->is_available()) {
         GMutablePointer value = node_outputs_map.extract(output_socket->identifier());
-        this->forward_to_inputs(*output_socket, value);
+        if (state.store_outputs) {
+          const CPPType &type = *value.type();
+          void *buffer = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+          type.copy_to_uninitialized(value.get(), buffer);
+          if (type.is<GeometrySet>()) {
+            /* The geometry might reference data that is freed after this evaluation. */
+            static_cast<GeometrySet *>(buffer)->ensure_owns_direct_data();
+          }
+          state.outputs_to_store.append({type, buffer});
+        }
+        this->forward_to_inputs(*output_socket, value, allocator);
       }
     }
+
+    if (do_timing) {
+      state.duration = blender::timeit::Clock::now() - start_time;
+    }
   }
 
-  void execute_node(const DNode &node, GeoNodeExecParams params)
+  void execute_node(const DNode &node,
+                    GeoNodeExecParams params,
+                    blender::LinearAllocator<> &allocator)
   {
     const bNode &bnode = params.node();
     if (bnode.typeinfo->geometry_node_execute != nullptr) {
@@ -321,7 +843,7 @@ class GeometryNodesEvaluator {
     for (const DOutputSocket *dsocket : node.outputs()) {
       if (dsocket->is_available()) {
         const CPPType &type = *blender::nodes::socket_cpp_type_get(*dsocket->typeinfo());
-        void *buffer = allocator_.allocate(type.size(), type.alignment());
+        void *buffer = allocator.allocate(type.size(), type.alignment());
         fn_params.add_uninitialized_single_output(GMutableSpan(type, buffer, 1));
         output_data.append(GMutablePointer(type, buffer));
       }
@@ -341,12 +863,40 @@ class GeometryNodesEvaluator {
     }
   }
 
-  void forward_to_inputs(const DOutputSocket &from_socket, GMutablePointer value_to_forward)
+  /**
+   * Convert the value to the type of the given input socket. The caller remains responsible for
+   * destructing the passed in value.
+   */
+  GMutablePointer convert_value_for_input(const DInputSocket &to_socket,
+                                          const CPPType &from_type,
+                                          const void *value,
+                                          blender::LinearAllocator<> &allocator)
+  {
+    const CPPType &to_type = *blender::nodes::socket_cpp_type_get(*to_socket.typeinfo());
+    void *buffer = allocator.allocate(to_type.size(), to_type.alignment());
+    if (from_type == to_type) {
+      to_type.copy_to_uninitialized(value, buffer);
+    }
+    else if (conversions_.is_convertible(from_type, to_type)) {
+      conversions_.convert(from_type, to_type, value, buffer);
+    }
+    else {
+      to_type.copy_to_uninitialized(to_type.default_value(), buffer);
+    }
+    return {to_type, buffer};
+  }
+
+  void forward_to_inputs(const DOutputSocket &from_socket,
+                         GMutablePointer value_to_forward,
+                         blender::LinearAllocator<> &allocator)
   {
     Span<const DInputSocket *> to_sockets_all = from_socket.linked_sockets();
 
     const CPPType &from_type = *value_to_forward.type();
 
+    /* Create the values for all linked inputs before the map is locked. */
+    Vector<std::pair<const DInputSocket *, GMutablePointer>> values_to_add;
+
     Vector<const DInputSocket *> to_sockets_same_type;
     for (const DInputSocket *to_socket : to_sockets_all) {
       const CPPType &to_type = *blender::nodes::socket_cpp_type_get(*to_socket->typeinfo());
@@ -354,14 +904,9 @@ class GeometryNodesEvaluator {
         to_sockets_same_type.append(to_socket);
       }
       else {
-        void *buffer = allocator_.allocate(to_type.size(), to_type.alignment());
-        if (conversions_.is_convertible(from_type, to_type)) {
-          conversions_.convert(from_type, to_type, value_to_forward.get(), buffer);
-        }
-        else {
-          to_type.copy_to_uninitialized(to_type.default_value(), buffer);
-        }
-        value_by_input_.add_new(to_socket, GMutablePointer{to_type, buffer});
+        GMutablePointer value = this->convert_value_for_input(
+            *to_socket, from_type, value_to_forward.get(), allocator);
+        values_to_add.append({to_socket, value});
       }
     }
 
@@ -372,7 +917,7 @@ class GeometryNodesEvaluator {
     else if (to_sockets_same_type.size() == 1) {
       /* This value is only used on one input socket, no need to copy it. */
       const DInputSocket *to_socket = to_sockets_same_type[0];
-      value_by_input_.add_new(to_socket, value_to_forward);
+      values_to_add.append({to_socket, value_to_forward});
     }
     else {
       /* Multiple inputs use the value, make a copy for every input except for one. */
@@ -380,16 +925,31 @@ class GeometryNodesEvaluator {
       Span<const DInputSocket *> other_to_sockets = to_sockets_same_type.as_span().drop_front(1);
       const CPPType &type = *value_to_forward.type();
 
-      value_by_input_.add_new(first_to_socket, value_to_forward);
+      values_to_add.append({first_to_socket, value_to_forward});
       for (const DInputSocket *to_socket : other_to_sockets) {
-        void *buffer = allocator_.allocate(type.size(), type.alignment());
+        void *buffer = allocator.allocate(type.size(), type.alignment());
         type.copy_to_uninitialized(value_to_forward.get(), buffer);
-        value_by_input_.add_new(to_socket, GMutablePointer{type, buffer});
+        values_to_add.append({to_socket, GMutablePointer{type, buffer}});
       }
     }
+
+    std::lock_guard lock{value_by_input_mutex_};
+    for (const std::pair<const DInputSocket *, GMutablePointer> &item : values_to_add) {
+      value_by_input_.add_new(item.first, item.second);
+    }
   }
 
-  GMutablePointer get_unlinked_input_value(const DInputSocket &socket)
+  GMutablePointer get_unavailable_output_value(const DOutputSocket &from_socket,
+                                               const DInputSocket &to_socket,
+                                               blender::LinearAllocator<> &allocator)
+  {
+    const CPPType &from_type = *blender::nodes::socket_cpp_type_get(*from_socket.typeinfo());
+    return this->convert_value_for_input(
+        to_socket, from_type, from_type.default_value(), allocator);
+  }
+
+  GMutablePointer get_unlinked_input_value(const DInputSocket &socket,
+                                           blender::LinearAllocator<> &allocator)
   {
     bNodeSocket *bsocket;
     if (socket.linked_group_inputs().size() == 0) {
@@ -399,7 +959,7 @@ class GeometryNodesEvaluator {
       bsocket = socket.linked_group_inputs()[0]->bsocket();
     }
     const CPPType &type = *blender::nodes::socket_cpp_type_get(*socket.typeinfo());
-    void *buffer = allocator_.allocate(type.size(), type.alignment());
+    void *buffer = allocator.allocate(type.size(), type.alignment());
 
     if (bsocket->type == SOCK_OBJECT) {
       Object *object = ((bNodeSocketValueObject *)bsocket->default_value)->value;
@@ -782,8 +1342,6 @@ static void fill_data_handle_map(const DerivedNodeTree &tree,
 
 /**
  * Evaluate a node group to compute the output geometry.
- * Currently, this uses a fairly basic and inefficient algorithm that might compute things more
- * often than necessary. It's going to be replaced soon.
  */
 static GeometrySet compute_geometry(const DerivedNodeTree &tree,
                                     Span<const DOutputSocket *> group_input_sockets,
@@ -826,8 +1384,36 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
   blender::bke::PersistentDataHandleMap handle_map;
   fill_data_handle_map(tree, handle_map);
 
-  GeometryNodesEvaluator evaluator{
-      group_inputs, group_outputs, mf_by_node, handle_map, ctx->object};
+  NodesModifierRuntime *runtime = static_cast<NodesModifierRuntime *>(nmd->modifier.runtime);
+  if (runtime == nullptr) {
+    runtime = new NodesModifierRuntime();
+    nmd->modifier.runtime = runtime;
+  }
+  if (nmd->flag & MOD_NODES_USE_CACHE) {
+    if (!runtime->cache) {
+      runtime->cache = std::make_unique<GeometryNodesCache>();
+    }
+  }
+  else {
+    /* Comparing and copying the input geometry in every evaluation is only worth it when the
+     * user knows that the input rarely changes. */
+    runtime->cache.reset();
+  }
+  Map<std::string, blender::timeit::Nanoseconds> *duration_by_node = nullptr;
+  if (G.debug & G_DEBUG_DEPSGRAPH_TIME) {
+    duration_by_node = &runtime->duration_by_node;
+  }
+  else {
+    runtime->duration_by_node.clear();
+  }
+
+  GeometryNodesEvaluator evaluator{group_inputs,
+                                   group_outputs,
+                                   mf_by_node,
+                                   handle_map,
+                                   ctx->object,
+                                   runtime->cache.get(),
+                                   duration_by_node};
   Vector<GMutablePointer> results = evaluator.execute();
   BLI_assert(results.size() == 1);
   GMutablePointer result = results[0];
@@ -987,6 +1573,43 @@ static void draw_property_for_socket(uiLayout *layout,
   }
 }
 
+/* Show the time spent in every node in the last evaluation, slowest first. */
+static void draw_node_timings(const bContext *C, uiLayout *layout, PointerRNA *ptr)
+{
+  Depsgraph *depsgraph = CTX_data_depsgraph_pointer(C);
+  Object *object = reinterpret_cast<Object *>(ptr->owner_id);
+  ModifierData *md_eval = BKE_modifier_get_evaluated(
+      depsgraph, object, static_cast<ModifierData *>(ptr->data));
+  if (md_eval == nullptr || md_eval->runtime == nullptr) {
+    return;
+  }
+  const NodesModifierRuntime &runtime = *static_cast<const NodesModifierRuntime *>(
+      md_eval->runtime);
+  if (runtime.duration_by_node.is_empty()) {
+    return;
+  }
+
+  Vector<std::pair<StringRef, blender::timeit::Nanoseconds>> timings;
+  for (auto item : runtime.duration_by_node.items()) {
+    timings.append({item.key, item.value});
+  }
+  std::sort(timings.begin(), timings.end(), [](const auto &a, const auto &b) {
+    return a.second > b.second;
+  });
+
+  uiLayout *col = uiLayoutColumn(layout, false);
+  uiItemL(col, IFACE_("Node Timings:"), ICON_NONE);
+  for (const auto &timing : timings) {
+    char line[256];
+    BLI_snprintf(line,
+                 sizeof(line),
+                 "%s: %.3f ms",
+                 std::string(timing.first).c_str(),
+                 std::chrono::duration<double, std::milli>(timing.second).count());
+    uiItemL(col, line, ICON_NONE);
+  }
+}
+
 static void panel_draw(const bContext *C, Panel *panel)
 {
   uiLayout *layout = panel->layout;
@@ -1018,6 +1641,12 @@ static void panel_draw(const bContext *C, Panel *panel)
     }
   }
 
+  uiItemR(layout, ptr, "use_cache", 0, nullptr, ICON_NONE);
+
+  if (G.debug & G_DEBUG_DEPSGRAPH_TIME) {
+    draw_node_timings(C, layout, ptr);
+  }
+
   modifier_panel_end(layout, ptr);
 }
 
@@ -1055,6 +1684,12 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   }
 }
 
+static void freeRuntimeData(void *runtime_data_v)
+{
+  NodesModifierRuntime *runtime = static_cast<NodesModifierRuntime *>(runtime_data_v);
+  delete runtime;
+}
+
 static void freeData(ModifierData *md)
 {
   NodesModifierData *nmd = reinterpret_cast<NodesModifierData *>(md);
@@ -1062,6 +1697,8 @@ static void freeData(ModifierData *md)
     IDP_FreeProperty_ex(nmd->settings.properties, false);
     nmd->settings.properties = nullptr;
   }
+  freeRuntimeData(md->runtime);
+  md->runtime = nullptr;
 }
 
 static void requiredDataMask(Object *UNUSED(ob),
@@ -1105,7 +1742,7 @@ ModifierTypeInfo modifierType_Nodes = {
     /* dependsOnNormals */ nullptr,
     /* foreachIDLink */ foreachIDLink,
     /* foreachTexLink */ nullptr,
-    /* freeRuntimeData */ nullptr,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ blendWrite,
     /* blendRead */ blendRead,
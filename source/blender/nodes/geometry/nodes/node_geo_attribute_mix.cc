@@ -49,15 +49,19 @@ static void do_mix_operation_float(const int blend_mode,
                                    const FloatReadAttribute &inputs_b,
                                    FloatWriteAttribute &results)
 {
-  const int size = results.size();
-  for (const int i : IndexRange(size)) {
-    const float factor = factors[i];
-    float3 a{inputs_a[i]};
-    const float3 b{inputs_b[i]};
+  /* Use spans to avoid virtual function calls for every element. */
+  Span<float> span_factors = factors.get_span();
+  Span<float> span_a = inputs_a.get_span();
+  Span<float> span_b = inputs_b.get_span();
+  MutableSpan<float> span_results = results.get_span();
+  for (const int i : span_results.index_range()) {
+    const float factor = span_factors[i];
+    float3 a{span_a[i]};
+    const float3 b{span_b[i]};
     ramp_blend(blend_mode, a, factor, b);
-    const float result = a.length();
-    results.set(i, result);
+    span_results[i] = a.length();
   }
+  results.apply_span();
 }
 
 static void do_mix_operation_float3(const int blend_mode,
@@ -66,14 +70,18 @@ static void do_mix_operation_float3(const int blend_mode,
                                     const Float3ReadAttribute &inputs_b,
                                     Float3WriteAttribute &results)
 {
-  const int size = results.size();
-  for (const int i : IndexRange(size)) {
-    const float factor = factors[i];
-    float3 a = inputs_a[i];
-    const float3 b = inputs_b[i];
+  Span<float> span_factors = factors.get_span();
+  Span<float3> span_a = inputs_a.get_span();
+  Span<float3> span_b = inputs_b.get_span();
+  MutableSpan<float3> span_results = results.get_span();
+  for (const int i : span_results.index_range()) {
+    const float factor = span_factors[i];
+    float3 a = span_a[i];
+    const float3 b = span_b[i];
     ramp_blend(blend_mode, a, factor, b);
-    results.set(i, a);
+    span_results[i] = a;
   }
+  results.apply_span();
 }
 
 static void do_mix_operation_color4f(const int blend_mode,
@@ -82,14 +90,18 @@ static void do_mix_operation_color4f(const int blend_mode,
                                      const Color4fReadAttribute &inputs_b,
                                      Color4fWriteAttribute &results)
 {
-  const int size = results.size();
-  for (const int i : IndexRange(size)) {
-    const float factor = factors[i];
-    Color4f a = inputs_a[i];
-    const Color4f b = inputs_b[i];
+  Span<float> span_factors = factors.get_span();
+  Span<Color4f> span_a = inputs_a.get_span();
+  Span<Color4f> span_b = inputs_b.get_span();
+  MutableSpan<Color4f> span_results = results.get_span();
+  for (const int i : span_results.index_range()) {
+    const float factor = span_factors[i];
+    Color4f a = span_a[i];
+    const Color4f b = span_b[i];
     ramp_blend(blend_mode, a, factor, b);
-    results.set(i, a);
+    span_results[i] = a;
   }
+  results.apply_span();
 }
 
 static void do_mix_operation(const CustomDataType result_type,
@@ -442,6 +442,8 @@ static const fn::MultiFunction &create_function_for_node_that_expands_into_multi
 
   fn::MFNetworkEvaluator &fn_evaluator = resources.construct<fn::MFNetworkEvaluator>(
       __func__, std::move(dummy_fn_inputs), std::move(dummy_fn_outputs));
+  /* Evaluate large attributes in parallel, with intermediate buffers that fit into the cache. */
+  fn_evaluator.set_chunk_size(4096);
   return fn_evaluator;
 }
 
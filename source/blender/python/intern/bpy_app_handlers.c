@@ -40,6 +40,7 @@ void bpy_app_generic_callback(struct Main *main,
                               struct PointerRNA **pointers,
                               const int num_pointers,
                               void *arg);
+static bool bpy_app_generic_callback_is_used(void *arg);
 
 static PyTypeObject BlenderAppCbType;
 
@@ -245,6 +246,7 @@ PyObject *BPY_app_handlers_struct(void)
       funcstore->func = bpy_app_generic_callback;
       funcstore->alloc = 0;
       funcstore->arg = POINTER_FROM_INT(pos);
+      funcstore->is_used = bpy_app_generic_callback_is_used;
       BKE_callback_add(funcstore, pos);
     }
   }
@@ -311,6 +313,12 @@ static PyObject *choose_arguments(PyObject *func, PyObject *args_all, PyObject *
 }
 
 /* the actual callback - not necessarily called from py */
+static bool bpy_app_generic_callback_is_used(void *arg)
+{
+  PyObject *cb_list = py_cb_array[POINTER_AS_INT(arg)];
+  return PyList_GET_SIZE(cb_list) > 0;
+}
+
 void bpy_app_generic_callback(struct Main *UNUSED(main),
                               struct PointerRNA **pointers,
                               const int num_pointers,
@@ -515,6 +515,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--render-output");
   BLI_args_print_arg_doc(ba, "--engine");
   BLI_args_print_arg_doc(ba, "--threads");
+  BLI_args_print_arg_doc(ba, "--huge-pages");
 
   printf("\n");
   printf("Format Options:\n");
@@ -1468,6 +1469,18 @@ static int arg_handle_threads_set(int argc, const char **argv, void *UNUSED(data
   return 0;
 }
 
+static const char arg_handle_huge_pages_set_doc[] =
+    "\n\t"
+    "Back large memory allocations such as mesh data and render buffers with transparent huge\n"
+    "\tpages (Linux only).";
+static int arg_handle_huge_pages_set(int UNUSED(argc),
+                                     const char **UNUSED(argv),
+                                     void *UNUSED(data))
+{
+  MEM_use_huge_pages(true);
+  return 0;
+}
+
 static const char arg_handle_verbosity_set_doc[] =
     "<verbose>\n"
     "\tSet the logging verbosity level for debug messages that support it.";
@@ -2011,6 +2024,7 @@ void main_args_setup(bContext *C, bArgs *ba)
   BLI_args_add(ba, NULL, "--env-system-python", CB_EX(arg_handle_env_system_set, python), NULL);
 
   BLI_args_add(ba, "-t", "--threads", CB(arg_handle_threads_set), NULL);
+  BLI_args_add(ba, NULL, "--huge-pages", CB(arg_handle_huge_pages_set), NULL);
 
   /* Pass: Background Mode & Settings
    *